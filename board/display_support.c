@@ -474,15 +474,49 @@ status_t BOARD_InitDisplayInterface(void)
     return BOARD_InitLcdPanel();
 }
 
+__attribute__((weak)) void BOARD_DisplayFrameShown(uint8_t layer)
+{
+    /* Default implementation does nothing, applications override it to time frame presentation. */
+    (void)layer;
+}
+
 #if (DEMO_DISPLAY_CONTROLLER == DEMO_DISPLAY_CONTROLLER_LCDIFV2)
 void LCDIFv2_IRQHandler(void)
 {
+    dc_fb_lcdifv2_handle_t *dcHandle = g_dc.prvData;
+    uint32_t pending                 = 0U;
+
+    for (uint8_t i = 0; i < DC_FB_LCDIFV2_MAX_LAYER; i++)
+    {
+        if (dcHandle->layers[i].framePending)
+        {
+            pending |= (1UL << i);
+        }
+    }
+
     DC_FB_LCDIFV2_IRQHandler(&g_dc);
+
+    /* Layers whose pending frame was latched at this vertical blank. */
+    for (uint8_t i = 0; i < DC_FB_LCDIFV2_MAX_LAYER; i++)
+    {
+        if (((pending & (1UL << i)) != 0U) && !dcHandle->layers[i].framePending)
+        {
+            BOARD_DisplayFrameShown(i);
+        }
+    }
 }
 #else
 void eLCDIF_IRQHandler(void)
 {
+    dc_fb_elcdif_handle_t *dcHandle = g_dc.prvData;
+    bool pending                    = dcHandle->layers[0].framePending;
+
     DC_FB_ELCDIF_IRQHandler(&g_dc);
+
+    if (pending && !dcHandle->layers[0].framePending)
+    {
+        BOARD_DisplayFrameShown(0);
+    }
 }
 #endif
 
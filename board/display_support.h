@@ -103,6 +103,9 @@ extern "C" {
 
 status_t BOARD_PrepareDisplayController(void);
 
+/* Called from the display interrupt when a new frame of layer becomes visible. Weak, does nothing by default. */
+void BOARD_DisplayFrameShown(uint8_t layer);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
@@ -11,6 +11,7 @@
 #include "task.h"
 #include "vg_lite.h"
 #include "vg_lite_platform.h"
+#include "vg_lite_os.h"
 #include "display_support.h"
 /*******************************************************************************
  * Definitions
@@ -85,5 +86,15 @@ status_t BOARD_PrepareVGLiteController(void)
 
     vg_lite_init_mem(registerMemBase, gpu_mem_base, vglite_heap_base, vglite_heap_size);
 
+    /* Start the cycle counter used to time GPU command buffers and frames. */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
     return kStatus_Success;
 }
+
+uint32_t vg_lite_os_timestamp(void)
+{
+    return DWT->CYCCNT;
+}
@@ -142,32 +142,63 @@ static vg_lite_error_t init_vg_lite(void)
 static void redraw(vg_lite_window_t* window, vg_lite_color_t bg, vg_lite_color_t fg, float angle)
 {
     vg_lite_error_t error = VG_LITE_SUCCESS;
+    vg_lite_rectangle_t region;
 
-    vg_lite_buffer_t *rt = VGLITE_GetRenderTarget(window);
+    /* Skip this window for a frame rather than waiting for the display to release a buffer. */
+    vg_lite_buffer_t *rt = VGLITE_TryGetRenderTarget(window);
     if (rt == NULL)
     {
-        PRINTF("vg_lite_get_renderTarget error\r\n");
-        while (1)
-            ;
+        return;
     }
     vg_lite_identity(&matrix);
     vg_lite_translate(window->width / 2.0f, window->height / 2.0f, &matrix);
     vg_lite_rotate(angle, &matrix);
     vg_lite_scale(10, 10, &matrix);
 
-    vg_lite_clear(rt, NULL, bg);
-    error = vg_lite_draw(rt, &path, VG_LITE_FILL_EVEN_ODD, &matrix, VG_LITE_BLEND_NONE, fg);
-    if (error)
+    /* Only the area of the path in this frame and in the frames still shown by rt has to be redrawn. */
+    VGLITE_AddPathDamage(window, &path, &matrix);
+    if (VGLITE_GetRepaintRegion(window, &region))
     {
-        PRINTF("vg_lite_draw() returned error %d\n", error);
-        cleanup();
-        return;
+        vg_lite_set_scissor(region.x, region.y, region.width, region.height);
+        vg_lite_enable_scissor();
+        vg_lite_clear(rt, &region, bg);
+        error = vg_lite_draw(rt, &path, VG_LITE_FILL_EVEN_ODD, &matrix, VG_LITE_BLEND_NONE, fg);
+        vg_lite_disable_scissor();
+        if (error)
+        {
+            PRINTF("vg_lite_draw() returned error %d\n", error);
+            cleanup();
+            return;
+        }
     }
     VGLITE_SwapBuffers(window);
 
     return;
 }
 
+/* Average where the recent frames of a window spent their time, to tell CPU, GPU and vsync bound apart. */
+static void print_timing(vg_lite_window_t *window)
+{
+    vg_lite_frame_timing_t timings[APP_TIMING_HISTORY];
+    uint32_t sum[5] = {0};
+    uint32_t count, us = SystemCoreClock / 1000000U;
+
+    count = VGLITE_GetFrameTimings(window, timings, APP_TIMING_HISTORY);
+    if (count == 0)
+        return;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sum[0] += timings[i].acquireCycles;
+        sum[1] += timings[i].encodeCycles;
+        sum[2] += timings[i].gpuCycles;
+        sum[3] += timings[i].presentCycles;
+        sum[4] += timings[i].latencyCycles;
+    }
+    PRINTF("acquire %u us, encode %u us, gpu %u us, present %u us, latency %u us\r\n", sum[0] / count / us,
+           sum[1] / count / us, sum[2] / count / us, sum[3] / count / us, sum[4] / count / us);
+}
+
 uint32_t getTime()
 {
     return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
@@ -227,7 +258,7 @@ static void vglite_task(void *pvParameters)
     // initialize the windows
     for (int i = 0; i < numWindows; ++i)
     {
-        windows[i] = VGLITE_CreateWindow(i, &area[i], bufferFormat[i]);
+        windows[i] = VGLITE_CreateWindowEx(i, &area[i], bufferFormat[i], APP_MAX_BUFFER_COUNT);
         if (windows[i] == NULL)
         {
             PRINTF("VGLITE_CreateWindow failed: VGLITE_CreateWindow() returned nullptr\n");
@@ -236,11 +267,13 @@ static void vglite_task(void *pvParameters)
         }
     }
 
-    uint32_t startTime, time, n = 0;
+    uint32_t startTime, time, frames, presented, n = 0;
     startTime = getTime();
+    presented = windows[0]->presentCount;
 
     while (1)
     {
+        VGLITE_BeginFrame();
         redraw(windows[0], 0xFFFF0000, 0xFF0000FF, 45 + n);
         if(windows[1])
             redraw(windows[1], 0xFF000000, 0xFF00FF00, n);
@@ -254,12 +287,19 @@ static void vglite_task(void *pvParameters)
             redraw(windows[5], 0x10000000, 0xFF0080FF, 100+n);
         if(windows[6])
             redraw(windows[6], 0x10000000, 0x80FFFFFF, 90-n);
+        VGLITE_EndFrame();
+
+        n++;
 
-        if (n++ >= 59)
+        /* Frames skipped because no render target was free do not count. */
+        frames = windows[0]->presentCount - presented;
+        if (frames >= 60)
         {
             time = getTime() - startTime;
-            PRINTF("%d frames in %d seconds: %d fps\r\n", n, time / 1000, n * 1000 / time);
+            PRINTF("%d frames in %d seconds: %d fps, %d loops\r\n", frames, time / 1000, frames * 1000 / time, n);
+            print_timing(windows[0]);
             n         = 0;
+            presented = windows[0]->presentCount;
             startTime = getTime();
         }
     }
@@ -43,9 +43,26 @@ void* fb_allocate(uint32_t size)
 vg_lite_display_t g_display[8];
 vg_lite_window_t g_window[8];
 
+/* Window whose commands are submitted but not yet presented. */
+static vg_lite_window_t *s_pendingWindow = NULL;
+
+/* Windows swapped between VGLITE_BeginFrame() and VGLITE_EndFrame(), in swap order. After VGLITE_EndFrame() the ones
+ * the display did not take. */
+static bool s_inFrame = false;
+static vg_lite_window_t *s_frameWindows[ARRAY_SIZE(g_window)];
+static uint32_t s_frameWindowCount = 0;
+
+/* Transient GPU memory, recycled when the frame that used it has been rendered. */
+static vg_lite_arena_t s_frameArena;
+
 /*******************************************************************************
  * Code
  ******************************************************************************/
+static inline uint32_t get_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
 static video_pixel_format_t vglite_to_video_format(vg_lite_buffer_format_t format)
 {
     switch (format)
@@ -94,6 +111,11 @@ static uint16_t get_stride_bytes(uint16_t width, video_pixel_format_t format)
 }
 
 vg_lite_window_t* VGLITE_CreateWindow(uint32_t displayId, vg_lite_rectangle_t* dimensions, vg_lite_buffer_format_t format)
+{
+    return VGLITE_CreateWindowEx(displayId, dimensions, format, APP_BUFFER_COUNT);
+}
+
+vg_lite_window_t* VGLITE_CreateWindowEx(uint32_t displayId, vg_lite_rectangle_t* dimensions, vg_lite_buffer_format_t format, int bufferCount)
 {
     vg_lite_display_t* display = &g_display[displayId];
     vg_lite_window_t* window = &g_window[displayId];
@@ -105,11 +127,18 @@ vg_lite_window_t* VGLITE_CreateWindow(uint32_t displayId, vg_lite_rectangle_t* d
     fbdev_t *g_fbdev          = &(display->g_fbdev);
     fbdev_fb_info_t *g_fbInfo = &(display->g_fbInfo);
 
-    window->bufferCount = APP_BUFFER_COUNT;
+    window->bufferCount = MIN(MAX(bufferCount, 2), APP_MAX_BUFFER_COUNT);
     window->display     = display;
     window->width       = dimensions->width;
     window->height      = dimensions->height;
     window->current     = -1;
+    window->frameCount  = 0;
+    memset(&window->damage, 0, sizeof(window->damage));
+    memset(window->damageHistory, 0, sizeof(window->damageHistory));
+    memset(window->bufferFrame, 0, sizeof(window->bufferFrame));
+    memset(&window->timingFrame, 0, sizeof(window->timingFrame));
+    window->timingShownValid = false;
+    window->timingCount      = 0;
     FBDEV_GetFrameBufferInfo(g_fbdev, g_fbInfo);
 
     g_fbInfo->bufInfo.pixelFormat = vglite_to_video_format(format);
@@ -148,10 +177,120 @@ void VGLITE_DestroyWindow(vg_lite_window_t* window)
 {
 }
 
-vg_lite_buffer_t *VGLITE_GetRenderTarget(vg_lite_window_t *window)
+static void commit_timing(vg_lite_window_t *window, const vg_lite_frame_timing_t *timing)
+{
+    window->timing[window->timingCount % APP_TIMING_HISTORY] = *timing;
+    /* Readers must see the entry before the count that publishes it. */
+    __DMB();
+    window->timingCount++;
+}
+
+uint32_t VGLITE_GetFrameTimings(vg_lite_window_t *window, vg_lite_frame_timing_t *timings, uint32_t count)
+{
+    uint32_t head, written, n;
+
+    head = window->timingCount;
+    __DMB();
+
+    /* The slot after the newest one may be in the middle of being overwritten. */
+    n = MIN(count, MIN(head, APP_TIMING_HISTORY - 1U));
+    for (uint32_t i = 0; i < n; i++)
+    {
+        timings[i] = window->timing[(head - 1U - i) % APP_TIMING_HISTORY];
+    }
+
+    /* Drop the oldest copies if the writer has reused their slots meanwhile. */
+    __DMB();
+    written = window->timingCount - head;
+    if (written >= APP_TIMING_HISTORY - 1U)
+        return 0;
+    return MIN(n, APP_TIMING_HISTORY - 1U - written);
+}
+
+void BOARD_DisplayFrameShown(uint8_t layer)
+{
+    if (layer < ARRAY_SIZE(g_window))
+    {
+        g_window[layer].shownTime = get_cycles();
+    }
+}
+
+static bool present_window(vg_lite_window_t *window, uint32_t flags)
+{
+    vg_lite_buffer_t *rt = &(window->buffers[window->current]);
+    fbdev_t *g_fbdev = &(window->display->g_fbdev);
+    vg_lite_frame_timing_t *timing = &window->timingFrame;
+    uint32_t start = get_cycles();
+
+    /* Only this window's commands have to be complete, later windows may still be rendering. */
+    if ((flags & kFBDEV_NoWait) != 0U)
+    {
+        if (!vg_lite_fence_is_signaled(&window->fence))
+            return false;
+    }
+    else
+    {
+        vg_lite_fence_wait(&window->fence, VG_LITE_FENCE_INFINITE);
+    }
+
+    if (FBDEV_SetFrameBuffer(g_fbdev, rt->memory, flags) != kStatus_Success)
+        return false;
+    timing->presentCycles = get_cycles() - start;
+    if (vg_lite_fence_get_gpu_time(&window->fence, &timing->gpuCycles) != VG_LITE_SUCCESS)
+        timing->gpuCycles = 0;
+
+    /* Setting this frame had to wait until the previous one became visible, its timing is complete now. */
+    if (window->timingShownValid)
+    {
+        if ((int32_t)(window->shownTime - window->presentTime) > 0)
+            window->timingShown.latencyCycles = window->shownTime - window->presentTime;
+        commit_timing(window, &window->timingShown);
+    }
+    window->timingShown      = *timing;
+    window->timingShownValid = true;
+    window->presentTime      = get_cycles();
+    window->presentPending   = false;
+    window->presentCount++;
+
+    if (!g_fbdev->enabled)
+    {
+        // LCDIFV2_SetLayerBlendConfig writes to shadow register (i.e. it has no immediate effect)
+        // FBDEV_Enable() will flush the blend config to the hardware
+        dc_fb_lcdifv2_handle_t *dcHandle = g_dc.prvData;
+        lcdifv2_blend_config_t blendConfig = { .globalAlpha = 255, .alphaMode = kLCDIFV2_AlphaEmbedded };
+        uint32_t displayId = window->display - g_display;
+        LCDIFV2_SetLayerBlendConfig(dcHandle->lcdifv2, displayId, &blendConfig);     // TODO: feels wrong to call it directly - should be probably part of FBDEV
+
+        FBDEV_Enable(g_fbdev);
+    }
+    return true;
+}
+
+static vg_lite_buffer_t *acquire_render_target(vg_lite_window_t *window, uint32_t flags)
 {
     vg_lite_buffer_t *rt = NULL;
-    void *memory         = FBDEV_GetFrameBuffer(&window->display->g_fbdev, 0);
+    void *memory;
+    uint32_t start;
+
+    /* The previous frame must be handed to the display before a free buffer can be acquired. */
+    if (window->presentPending)
+    {
+        if (!present_window(window, flags))
+            return NULL;
+        if (s_pendingWindow == window)
+            s_pendingWindow = NULL;
+    }
+
+    start  = get_cycles();
+    memory = FBDEV_GetFrameBuffer(&window->display->g_fbdev, flags);
+    if (memory == NULL)
+        return NULL;
+
+    memset(&window->timingFrame, 0, sizeof(window->timingFrame));
+    window->encodeStart               = get_cycles();
+    window->timingFrame.frame         = window->frameCount + 1;
+    window->timingFrame.acquireCycles = window->encodeStart - start;
+
     for (uint8_t i = 0; i < window->bufferCount; i++)
     {
         rt = &(window->buffers[i]);
@@ -164,29 +303,162 @@ vg_lite_buffer_t *VGLITE_GetRenderTarget(vg_lite_window_t *window)
     return NULL;
 }
 
+vg_lite_buffer_t *VGLITE_GetRenderTarget(vg_lite_window_t *window)
+{
+    return acquire_render_target(window, 0);
+}
+
+vg_lite_buffer_t *VGLITE_TryGetRenderTarget(vg_lite_window_t *window)
+{
+    return acquire_render_target(window, kFBDEV_NoWait);
+}
+
+uint32_t VGLITE_GetBufferAge(vg_lite_window_t *window)
+{
+    if (window->current < 0 || window->bufferFrame[window->current] == 0)
+        return 0;
+
+    return window->frameCount + 1 - window->bufferFrame[window->current];
+}
+
+static void union_rect(vg_lite_rectangle_t *dst, const vg_lite_rectangle_t *src)
+{
+    int32_t x1, y1;
+
+    if (src->width <= 0 || src->height <= 0)
+        return;
+    if (dst->width <= 0 || dst->height <= 0)
+    {
+        *dst = *src;
+        return;
+    }
+
+    x1          = MAX(dst->x + dst->width, src->x + src->width);
+    y1          = MAX(dst->y + dst->height, src->y + src->height);
+    dst->x      = MIN(dst->x, src->x);
+    dst->y      = MIN(dst->y, src->y);
+    dst->width  = x1 - dst->x;
+    dst->height = y1 - dst->y;
+}
+
+void VGLITE_AddDamage(vg_lite_window_t *window, const vg_lite_rectangle_t *rect)
+{
+    union_rect(&window->damage, rect);
+}
+
+void VGLITE_AddPathDamage(vg_lite_window_t *window, vg_lite_path_t *path, vg_lite_matrix_t *matrix)
+{
+    vg_lite_rectangle_t bounds = {0, 0, window->width, window->height};
+
+    /* Without bounds the whole window is damaged. */
+    vg_lite_get_path_bounds(path, matrix, &bounds);
+    union_rect(&window->damage, &bounds);
+}
+
+bool VGLITE_GetRepaintRegion(vg_lite_window_t *window, vg_lite_rectangle_t *region)
+{
+    vg_lite_rectangle_t full = {0, 0, window->width, window->height};
+    uint32_t age = VGLITE_GetBufferAge(window);
+    int32_t x1, y1;
+
+    /* Content of unknown age is repainted completely. */
+    if (age == 0 || age > APP_DAMAGE_HISTORY)
+    {
+        *region = full;
+        return true;
+    }
+
+    /* The buffer still shows what was drawn in the last age frames, and the current frame draws the damage. */
+    *region = window->damage;
+    for (uint32_t i = 0; i < age; i++)
+    {
+        union_rect(region, &window->damageHistory[i]);
+    }
+
+    x1             = MIN(region->x + region->width, full.width);
+    y1             = MIN(region->y + region->height, full.height);
+    region->x      = MAX(region->x, 0);
+    region->y      = MAX(region->y, 0);
+    region->width  = x1 - region->x;
+    region->height = y1 - region->y;
+
+    return region->width > 0 && region->height > 0;
+}
+
 void VGLITE_SwapBuffers(vg_lite_window_t *window)
 {
-    vg_lite_buffer_t *rt;
-    if (window->current >= 0 && window->current < window->bufferCount)
-        rt = &(window->buffers[window->current]);
-    else
+    if (window->current < 0 || window->current >= window->bufferCount)
         return;
 
-    vg_lite_finish();
+    window->timingFrame.encodeCycles = get_cycles() - window->encodeStart;
 
+    /* Age the damage. */
+    memmove(&window->damageHistory[1], &window->damageHistory[0],
+            (APP_DAMAGE_HISTORY - 1) * sizeof(window->damageHistory[0]));
+    window->damageHistory[0] = window->damage;
+    memset(&window->damage, 0, sizeof(window->damage));
+    window->bufferFrame[window->current] = ++window->frameCount;
+    window->presentPending               = true;
 
-    fbdev_t *g_fbdev = &(window->display->g_fbdev);
+    /* Inside a frame only mark the end of this window's commands, VGLITE_EndFrame() submits them. */
+    if (s_inFrame && s_frameWindowCount < ARRAY_SIZE(s_frameWindows))
+    {
+        vg_lite_fence_insert(&window->fence);
+        s_frameWindows[s_frameWindowCount++] = window;
+        return;
+    }
 
-    FBDEV_SetFrameBuffer(g_fbdev, rt->memory, 0);
-    if (!g_fbdev->enabled)
+    /* Submit this window without waiting, so the GPU renders it while the next window is being built. */
+    vg_lite_fence_insert(&window->fence);
+    vg_lite_flush();
+    vg_lite_arena_reset(&s_frameArena);
+
+    if (s_pendingWindow != NULL && s_pendingWindow->presentPending)
+        present_window(s_pendingWindow, 0);
+    s_pendingWindow = window;
+}
+
+void VGLITE_BeginFrame(void)
+{
+    if (s_pendingWindow != NULL)
     {
-        // LCDIFV2_SetLayerBlendConfig writes to shadow register (i.e. it has no immediate effect)
-        // FBDEV_Enable() will flush the blend config to the hardware
-        dc_fb_lcdifv2_handle_t *dcHandle = g_dc.prvData;
-        lcdifv2_blend_config_t blendConfig = { .globalAlpha = 255, .alphaMode = kLCDIFV2_AlphaEmbedded };
-        uint32_t displayId = window->display - g_display;
-        LCDIFV2_SetLayerBlendConfig(dcHandle->lcdifv2, displayId, &blendConfig);     // TODO: feels wrong to call it directly - should be probably part of FBDEV
+        if (s_pendingWindow->presentPending)
+            present_window(s_pendingWindow, 0);
+        s_pendingWindow = NULL;
+    }
+    for (uint32_t i = 0; i < s_frameWindowCount; i++)
+    {
+        if (s_frameWindows[i]->presentPending)
+            present_window(s_frameWindows[i], 0);
+    }
 
-        FBDEV_Enable(g_fbdev);
+    s_frameWindowCount = 0;
+    s_inFrame          = true;
+}
+
+void VGLITE_EndFrame(void)
+{
+    uint32_t pending = 0;
+
+    s_inFrame = false;
+
+    /* One submission for all windows, so their fences signal together. Each window is presented in swap order as
+     * soon as its fence has signaled. */
+    vg_lite_flush();
+    vg_lite_arena_reset(&s_frameArena);
+    for (uint32_t i = 0; i < s_frameWindowCount; i++)
+    {
+        if (!present_window(s_frameWindows[i], 0))
+            s_frameWindows[pending++] = s_frameWindows[i];
     }
+    s_frameWindowCount = pending;
+}
+
+vg_lite_arena_t *VGLITE_GetFrameArena(void)
+{
+    if (s_frameArena.memory.handle == NULL &&
+        vg_lite_arena_create(&s_frameArena, APP_FRAME_ARENA_SIZE) != VG_LITE_SUCCESS)
+        return NULL;
+
+    return &s_frameArena;
 }
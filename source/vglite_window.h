@@ -18,7 +18,31 @@
  * Definitions
  ******************************************************************************/
 
+/* Default number of buffers per window, VGLITE_CreateWindowEx() takes 2 up to APP_MAX_BUFFER_COUNT. */
 #define APP_BUFFER_COUNT 2
+#define APP_MAX_BUFFER_COUNT FBDEV_MAX_FRAME_BUFFER
+
+/* Number of past frames whose damage is kept, older buffers are repainted completely. */
+#define APP_DAMAGE_HISTORY 4
+
+/* GPU memory available to one frame in the arena returned by VGLITE_GetFrameArena(). */
+#ifndef APP_FRAME_ARENA_SIZE
+#define APP_FRAME_ARENA_SIZE (64 * 1024)
+#endif
+
+/* Number of frames whose timing is kept per window. */
+#define APP_TIMING_HISTORY 16
+
+/* Where the time of one frame went, in DWT cycles. */
+typedef struct vg_lite_frame_timing
+{
+    uint32_t frame;         /* Frame number, see vg_lite_window_t::frameCount. */
+    uint32_t acquireCycles; /* Blocked in FBDEV_GetFrameBuffer waiting for a free buffer. */
+    uint32_t encodeCycles;  /* From acquiring the render target to VGLITE_SwapBuffers(), building commands on the CPU. */
+    uint32_t gpuCycles;     /* From submitting the command buffer to its completion interrupt. */
+    uint32_t presentCycles; /* Blocked waiting for the GPU and in FBDEV_SetFrameBuffer. */
+    uint32_t latencyCycles; /* From FBDEV_SetFrameBuffer to the vertical blank that made the frame visible. */
+} vg_lite_frame_timing_t;
 
 typedef struct vg_lite_display
 {
@@ -29,11 +53,26 @@ typedef struct vg_lite_display
 typedef struct vg_lite_window
 {
     vg_lite_display_t *display;
-    vg_lite_buffer_t buffers[APP_BUFFER_COUNT];
+    vg_lite_buffer_t buffers[APP_MAX_BUFFER_COUNT];
     int width;
     int height;
     int bufferCount;
     int current;
+    vg_lite_fence_t fence;     /* Signaled when the commands rendering the current buffer have completed. */
+    vg_lite_rectangle_t damage;                            /* Area drawn by the frame being rendered. */
+    vg_lite_rectangle_t damageHistory[APP_DAMAGE_HISTORY]; /* Area drawn by the previous frames, newest first. */
+    uint32_t frameCount;                                   /* Number of frames swapped so far. */
+    uint32_t presentCount;                                 /* Number of frames handed to the display so far. */
+    bool presentPending;                                   /* The last swapped frame has not been handed to the display yet. */
+    uint32_t bufferFrame[APP_MAX_BUFFER_COUNT];            /* Frame last rendered into each buffer, 0 if never. */
+    vg_lite_frame_timing_t timingFrame;                    /* Timing of the frame being rendered. */
+    vg_lite_frame_timing_t timingShown;                    /* Timing of the frame waiting for its vertical blank. */
+    bool timingShownValid;
+    uint32_t encodeStart;
+    uint32_t presentTime;                                  /* When the frame of timingShown was handed to the display. */
+    volatile uint32_t shownTime;                           /* Set by the display interrupt when a frame became visible. */
+    vg_lite_frame_timing_t timing[APP_TIMING_HISTORY];     /* Ring of completed frames, written only by the render task. */
+    volatile uint32_t timingCount;                         /* Frames ever written to the ring. */
 } vg_lite_window_t;
 
 /*******************************************************************************
@@ -45,12 +84,46 @@ extern "C" {
 
 vg_lite_window_t* VGLITE_CreateWindow(uint32_t displayId, vg_lite_rectangle_t* dimensions, vg_lite_buffer_format_t format);
 
+vg_lite_window_t* VGLITE_CreateWindowEx(uint32_t displayId, vg_lite_rectangle_t* dimensions, vg_lite_buffer_format_t format, int bufferCount);
+
 void VGLITE_DestroyWindow(vg_lite_window_t*);
 
 vg_lite_buffer_t *VGLITE_GetRenderTarget(vg_lite_window_t *window);
 
+/* Like VGLITE_GetRenderTarget(), but returns NULL instead of waiting when no buffer is free yet. */
+vg_lite_buffer_t *VGLITE_TryGetRenderTarget(vg_lite_window_t *window);
+
+/* Number of frames since the current render target was last rendered, 0 if its content is undefined. */
+uint32_t VGLITE_GetBufferAge(vg_lite_window_t *window);
+
 void VGLITE_SwapBuffers(vg_lite_window_t *window);
 
+/* Batch all windows swapped until VGLITE_EndFrame() into a single command submission. */
+void VGLITE_BeginFrame(void);
+
+/* Submit the frame and hand each window to the display as soon as its rendering has completed, in swap order. The
+ * windows share one command submission, so their fences signal together, when the whole frame has been rendered; a
+ * window that must be shown earlier has to be swapped outside VGLITE_BeginFrame() and VGLITE_EndFrame(). Windows the
+ * display does not take are handed over by the next VGLITE_BeginFrame() or render target acquire. */
+void VGLITE_EndFrame(void);
+
+/* Report an area drawn by the current frame. */
+void VGLITE_AddDamage(vg_lite_window_t *window, const vg_lite_rectangle_t *rect);
+
+/* Report the area covered by drawing path with matrix in the current frame. */
+void VGLITE_AddPathDamage(vg_lite_window_t *window, vg_lite_path_t *path, vg_lite_matrix_t *matrix);
+
+/* Area of the current render target that is stale and has to be cleared and redrawn, based on the damage of the
+ * frames since the buffer was last rendered. Returns false if nothing has to be redrawn. */
+bool VGLITE_GetRepaintRegion(vg_lite_window_t *window, vg_lite_rectangle_t *region);
+
+/* Copy the timing of up to count completed frames, newest first. A frame is completed once it has become visible.
+ * Lock-free, may be called from any task while the window is rendering. Returns the number of frames copied. */
+uint32_t VGLITE_GetFrameTimings(vg_lite_window_t *window, vg_lite_frame_timing_t *timings, uint32_t count);
+
+/* Arena for GPU memory that is only needed until the current frame is displayed. */
+vg_lite_arena_t *VGLITE_GetFrameArena(void);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
@@ -68,12 +68,23 @@ void __attribute__((weak)) vg_lite_bus_error_handler()
      return;
 }
 
+uint32_t __attribute__((weak)) vg_lite_os_timestamp(void)
+{
+    /*
+     * Default implementation has no timer. Application should override this
+     * function with a free running counter, e.g. the DWT cycle counter, to
+     * get GPU execution times.
+     */
+    return 0;
+}
+
 #if !defined(VG_DRIVER_SINGLE_THREAD)
 /* command queue function */
 void command_queue(void * parameters)
 {
     vg_lite_queue_t* peek_queue;
     uint32_t  even_got;
+    int32_t   finished;
     BaseType_t  ret;
 
     os_obj.queue_handle = xQueueCreate(QUEUE_LENGTH, sizeof(vg_lite_queue_t * ));
@@ -104,10 +115,13 @@ void command_queue(void * parameters)
                         printf("0x%08x ",((uint32_t*)(peek_queue->cmd_physical + peek_queue->cmd_offset))[i]);
                     }
 #endif
+                    peek_queue->event->start_time = vg_lite_os_timestamp();
                     vg_lite_hal_poke(VG_LITE_HW_CMDBUF_ADDRESS, peek_queue->cmd_physical + peek_queue->cmd_offset);
                     vg_lite_hal_poke(VG_LITE_HW_CMDBUF_SIZE, (peek_queue->cmd_size +7)/8 );
 
-                    if(vg_lite_hal_wait_interrupt(ISR_WAIT_TIME, (uint32_t)~0, &even_got))
+                    finished = vg_lite_hal_wait_interrupt(ISR_WAIT_TIME, (uint32_t)~0, &even_got);
+                    peek_queue->event->end_time = vg_lite_os_timestamp();
+                    if(finished)
                         peek_queue->event->signal = VG_LITE_HW_FINISHED;
                     else
 #if defined(PRINT_DEBUG_REGISTER)
@@ -289,29 +303,42 @@ int32_t vg_lite_os_submit(uint32_t context, uint32_t physical, uint32_t offset,
         return VG_LITE_MULTI_THREAD_FAIL;
     curContext = context;
 
-    if (vg_lite_os_wait_event(event) == VG_LITE_SUCCESS) {
-        if(xSemaphoreGive(command_semaphore) != pdTRUE)
-            return VG_LITE_MULTI_THREAD_FAIL;
-        return VG_LITE_SUCCESS;
-    }
+    /* Do not wait for earlier buffers: the queue task executes them in order. */
+    if(xSemaphoreGive(command_semaphore) != pdTRUE)
+        return VG_LITE_MULTI_THREAD_FAIL;
 
-    return VG_LITE_MULTI_THREAD_FAIL;
+    return VG_LITE_SUCCESS;
 }
 
 int32_t vg_lite_os_wait(uint32_t timeout, vg_lite_os_async_event_t *event)
 {
-    if (semaphore[event->semaphore_id]) {
-        if (xSemaphoreTake(semaphore[event->semaphore_id], portMAX_DELAY) == pdTRUE) {
-            if(event->signal == VG_LITE_HW_FINISHED){
-                xSemaphoreGive(semaphore[event->semaphore_id]);
-                return VG_LITE_SUCCESS;
-            }
-            else{
-                xSemaphoreGive(semaphore[event->semaphore_id]);
+    TickType_t ticks, start, elapsed;
+
+    if (semaphore[event->semaphore_id] == NULL)
+        return VG_LITE_TIMEOUT;
+
+    /* Round up so that a short timeout still waits at least one tick. */
+    ticks = (timeout == VG_LITE_INFINITE) ? portMAX_DELAY
+                                          : (TickType_t)((timeout + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+    start = xTaskGetTickCount();
+
+    /* The semaphore is given each time one of the task's buffers completes, each pass only waits for what is
+       left of the timeout. */
+    while (event->signal == VG_LITE_IN_QUEUE) {
+        if (ticks == portMAX_DELAY) {
+            elapsed = 0;
+        } else {
+            elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= ticks)
                 return VG_LITE_TIMEOUT;
-            }
         }
+        if (xSemaphoreTake(semaphore[event->semaphore_id], ticks - elapsed) != pdTRUE)
+            return VG_LITE_TIMEOUT;
     }
+
+    if(event->signal == VG_LITE_HW_FINISHED)
+        return VG_LITE_SUCCESS;
+
     return VG_LITE_TIMEOUT;
 }
 #endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
@@ -336,6 +363,20 @@ void vg_lite_os_IRQHandler(void)
     }
 }
 
+void vg_lite_os_signal_interrupt(void)
+{
+    uint32_t flags = vg_lite_hal_peek(VG_LITE_INTR_STATUS);
+
+    if (flags) {
+        int_flags |= flags;
+
+        /* Same as the IRQ handler, but without the FromISR calls. */
+        if(int_queue){
+            xSemaphoreGive(int_queue);
+        }
+    }
+}
+
 int32_t vg_lite_os_wait_interrupt(uint32_t timeout, uint32_t mask, uint32_t * value)
 {
 #if _BAREMETAL
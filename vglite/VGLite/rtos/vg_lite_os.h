@@ -18,7 +18,9 @@
 typedef struct vg_lite_os_async_event
 {
     uint32_t    semaphore_id; /*! The Id of the semaphore assigned to this event */
-    int32_t     signal;       /*! The command buffer status */
+    volatile int32_t signal;  /*! The command buffer status, updated by the command queue task */
+    uint32_t    start_time;   /*! vg_lite_os_timestamp() when the command buffer was started on the GPU */
+    uint32_t    end_time;     /*! vg_lite_os_timestamp() when its completion interrupt was received */
 }
 vg_lite_os_async_event_t;
 
@@ -51,6 +53,11 @@ void vg_lite_os_free(void * memory);
 void vg_lite_os_reset_tls();
 #endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
 
+/*!
+@brief  Free running timestamp used to time command buffers. Weak, returns 0 unless the platform provides a counter.
+*/
+uint32_t vg_lite_os_timestamp(void);
+
 /*!
 @brief  sleep a number of milliseconds.
 */
@@ -93,6 +100,11 @@ int32_t vg_lite_os_wait(uint32_t timeout, vg_lite_os_async_event_t *event);
 */
 void vg_lite_os_IRQHandler(void);
 
+/*!
+@brief  Deliver a GPU interrupt from task context, e.g. from a simulated GPU that completes in the submitting task.
+*/
+void vg_lite_os_signal_interrupt(void);
+
 /*!
 @brief  Wait until an interrupt from the VGLite graphics hardware has been received.
 */
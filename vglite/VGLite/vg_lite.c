@@ -80,6 +80,32 @@ vg_lite_error_t vg_lite_kernel(vg_lite_kernel_command_t command, void * data);
     #define VG_TARGET_FAST_CLEAR 0
 #endif /* VG_TARGET_FAST_CLEAR */
 
+/* Paths drawn VG_PATH_CACHE_HOT times without changing are uploaded to GPU memory by the driver,
+   up to VG_PATH_CACHE_SIZE bytes in VG_PATH_CACHE_ENTRIES paths. A size of 0 disables the cache. */
+#ifndef VG_PATH_CACHE_SIZE
+    #define VG_PATH_CACHE_SIZE (32 << 10)
+#endif /* VG_PATH_CACHE_SIZE */
+#ifndef VG_PATH_CACHE_ENTRIES
+    #define VG_PATH_CACHE_ENTRIES 16
+#endif /* VG_PATH_CACHE_ENTRIES */
+#ifndef VG_PATH_CACHE_HOT
+    #define VG_PATH_CACHE_HOT 2
+#endif /* VG_PATH_CACHE_HOT */
+
+/* All tessellations share one tessellation buffer, so each one stalls until the previous one has been
+   consumed. With VG_STALL_ELISION a draw ends with the full stall 15 instead of stall 7, so the stall
+   before its next tessellation is skipped when none was pushed since; the same after vg_lite_finish.
+   vg_lite_set_stall_elision turns it off at run time. */
+#ifndef VG_STALL_ELISION
+    #define VG_STALL_ELISION 1
+#endif /* VG_STALL_ELISION */
+
+/* Writes that would not change the blend, color, tessellation control, scale, bias or matrix registers
+   are dropped, and writes to consecutive ones share a single state command. */
+#ifndef VG_STATE_SHADOW
+    #define VG_STATE_SHADOW 1
+#endif /* VG_STATE_SHADOW */
+
 #if DUMP_COMMAND || DUMP_IMAGE
 #ifdef __linux__
 #include <unistd.h>
@@ -99,6 +125,8 @@ vg_lite_error_t vg_lite_kernel(vg_lite_kernel_command_t command, void * data);
 #define CMDBUF_OFFSET(context)  (context).command_offset[(context).command_buffer_current]
 #define CMDBUF_SWAP(context)    (context).command_buffer_current = \
                                     ((context).command_buffer_current + 1) % CMDBUF_COUNT
+#define CMDBUF_PREV_INDEX(context) \
+                                (((context).command_buffer_current + CMDBUF_COUNT - 1) % CMDBUF_COUNT)
 
 #if !defined(VG_DRIVER_SINGLE_THREAD)
 #ifndef CMDBUF_IN_QUEUE
@@ -162,6 +190,7 @@ static uint32_t command_buffer_size = VG_LITE_COMMAND_BUFFER_SIZE;
     }
 
 #define DEST_ALIGNMENT_LIMITATION 64  /* To match hardware alignment requirement */
+#define STATE_SHADOW_COUNT     0x46    /* Shadowed registers are in 0x0A00 - 0x0A45. */
 #if !defined(VG_DRIVER_SINGLE_THREAD)
 #define TS_STATE_COUNT         20      /* Initial state count for tessellation buffer. */
 #endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
@@ -176,15 +205,15 @@ static uint32_t command_buffer_size = VG_LITE_COMMAND_BUFFER_SIZE;
 #define LERP(v1, v2, w)    ((v1) * (w) + (v2) * (1.0f - (w)))
 
 #define PI                           3.141592653589793238462643383279502f
-#define SINF(x)                      ((vg_lite_float_t) sin(x))
-#define COSF(x)                      ((vg_lite_float_t) cos(x))
-#define FABSF(x)                     ((vg_lite_float_t) fabs(x))
-#define SQRTF(x)                     ((vg_lite_float_t) sqrt(x))
+#define SINF(x)                      ((vg_lite_float_t) sinf(x))
+#define COSF(x)                      ((vg_lite_float_t) cosf(x))
+#define FABSF(x)                     ((vg_lite_float_t) fabsf(x))
+#define SQRTF(x)                     ((vg_lite_float_t) sqrtf(x))
 #define CLAMP(x, min, max)           (((x) < (min)) ? (min) : \
                                            ((x) > (max)) ? (max) : (x))
-#define ACOSF(x)                     ((vg_lite_float_t) acos(x))
-#define FMODF(x, y)                  ((vg_lite_float_t) fmod((x), (y)))
-#define CEILF(x)                     ((vg_lite_float_t) ceil(x))
+#define ACOSF(x)                     ((vg_lite_float_t) acosf(x))
+#define FMODF(x, y)                  ((vg_lite_float_t) fmodf((x), (y)))
+#define CEILF(x)                     ((vg_lite_float_t) ceilf(x))
 #define FALSE                        0
 #define TURE                         1
 #define SIZEOF(a) \
@@ -221,6 +250,9 @@ typedef uintptr_t               UINTPTR_T;
 
 #define FLOAT_EPSILON               0.001f
 
+/* Initial size of the stroke conversion storage block. */
+#define STROKE_BLOCK_SIZE    1024
+
 #define SWING_NO             0
 #define SWING_OUT            1
 #define SWING_IN             2
@@ -302,8 +334,7 @@ typedef struct vg_lite_ftable {
 
 #if !defined(VG_DRIVER_SINGLE_THREAD)
 typedef struct vg_lite_states {
-    uint32_t state;
-    uint8_t  init;
+    uint32_t last;      /* Offset of the last command writing the state. */
 }vg_lite_states_t;
 
 typedef struct vg_lite_hardware {
@@ -313,6 +344,18 @@ typedef struct vg_lite_hardware {
 static vg_lite_hardware_t hw = {0};
 #endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
 
+typedef struct vg_lite_path_cache_entry {
+    vg_lite_path_t            * path;                       /* Path the entry belongs to, NULL if unused. */
+    void                      * data;                       /* Path data the entry was created for. */
+    int32_t                     length;
+    uint32_t                    draws;                      /* Draws since the path last changed. */
+    uint32_t                    last_use;
+    void                      * handle;                     /* GPU copy of the path, NULL until it is uploaded. */
+    uint32_t                    address;
+    uint32_t                    bytes;
+    vg_lite_fence_t             fence;                      /* Last draw that called the GPU copy. */
+} vg_lite_path_cache_entry_t;
+
 typedef struct vg_lite_context {
     vg_lite_kernel_context_t    context;
     vg_lite_capabilities_t      capabilities;
@@ -350,16 +393,51 @@ typedef struct vg_lite_context {
 
 #endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
 
+    vg_lite_command_list_t    * recording;                  /* Command list being recorded, NULL if none. */
+    uint8_t                   * record_buffer;              /* Command buffer slot saved while recording. */
+    uint32_t                    record_offset;
+    uint32_t                    record_size;
+    uint32_t                    record_start_offset;
+    uint32_t                    record_ts_init;
+    uint32_t                    record_ts_dirty;
+
     uint32_t                    chip_id;
     uint32_t                    chip_rev;
 
     uint32_t                    premultiply_enabled;
 
+    vg_lite_path_cache_entry_t  path_cache[VG_PATH_CACHE_ENTRIES];
+    uint32_t                    path_cache_clock;
+    uint32_t                    path_cache_bytes;           /* GPU memory held by the path cache. */
+    uint32_t                    path_cache_hits;
+    uint32_t                    path_cache_misses;
+    uint32_t                    path_cache_uploads;
+    uint32_t                    path_cache_evictions;
+
+#if VG_STALL_ELISION
+    uint8_t                     tessellation_idle;          /* The pipeline was drained and nothing tessellated since. */
+    uint8_t                     stall_elision_off;          /* vg_lite_set_stall_elision(0) was called. */
+#endif /* VG_STALL_ELISION */
+
+#if VG_STATE_SHADOW
+    uint32_t                    state_shadow[STATE_SHADOW_COUNT];           /* Last value written to 0x0A00 + index. */
+    uint8_t                     state_shadow_valid[STATE_SHADOW_COUNT];
+    uint8_t                     state_shadow_replay[STATE_SHADOW_COUNT];    /* Valid entries when the buffer was submitted. */
+    uint32_t                    state_run_buffer;           /* Command buffer holding the state command at state_run_start. */
+    uint32_t                    state_run_start;            /* Last state command of shadowed registers, ending at state_run_end. */
+    uint32_t                    state_run_end;              /* 0 if there is none. */
+    uint32_t                    states_elided;
+    uint32_t                    states_coalesced;
+    uint32_t                    state_words_saved;
+#endif /* VG_STATE_SHADOW */
+
 #if defined(VG_DRIVER_SINGLE_THREAD)
     uint32_t                    premultiply_dirty;
     uint8_t                     init;
 #else
     uint32_t                    semaphore_id;
+    uint32_t                    submit_serial;              /* Serial number of the last submitted command buffer. */
+    uint32_t                    command_serial[CMDBUF_COUNT];   /* Serial number each command buffer was last submitted with. */
 
     uint32_t                    * colors[4];                /* index colors. */
     uint32_t                    clut_dirty[4];              /* clut dirty flag. */
@@ -707,6 +785,93 @@ static vg_lite_error_t _set_point_tangent(
     return VG_LITE_SUCCESS;
 }
 
+static void * _stroke_alloc(
+    vg_lite_stroke_conversion_t * stroke_conversion,
+    uint32_t size
+    )
+{
+    vg_lite_stroke_block_ptr block = stroke_conversion->current_block;
+    vg_lite_stroke_block_ptr new_block;
+    uint32_t capacity = STROKE_BLOCK_SIZE;
+    uint8_t * memory;
+
+    size = (size + 7) & ~7u;
+
+    while (block == NULL || block->used + size > block->capacity)
+    {
+        /* Grow geometrically so a long path needs only a few blocks. */
+        if (block != NULL && block->capacity * 2 > capacity)
+            capacity = block->capacity * 2;
+        while (capacity < size)
+            capacity *= 2;
+
+        new_block = (vg_lite_stroke_block_ptr)vg_lite_os_malloc(sizeof(*new_block) + capacity);
+        if (!new_block)
+            return NULL;
+
+        new_block->next = NULL;
+        new_block->capacity = capacity;
+        new_block->used = 0;
+        if (block != NULL)
+            block->next = new_block;
+        else
+            stroke_conversion->block_list = new_block;
+        block = new_block;
+    }
+
+    stroke_conversion->current_block = block;
+    memory = (uint8_t *)(block + 1) + block->used;
+    block->used += size;
+
+    return memory;
+}
+
+static void _stroke_free_blocks(
+    vg_lite_stroke_conversion_t * stroke_conversion
+    )
+{
+    vg_lite_stroke_block_ptr block, next;
+
+    for (block = stroke_conversion->block_list; block; block = next)
+    {
+        next = block->next;
+        vg_lite_os_free(block);
+    }
+    stroke_conversion->block_list = NULL;
+    stroke_conversion->current_block = NULL;
+}
+
+static void _stroke_reset(
+    vg_lite_stroke_conversion_t * stroke_conversion
+    )
+{
+    vg_lite_stroke_block_ptr block = stroke_conversion->block_list;
+
+    /* Keep at most one block of the initial size, so a path does not hold its peak stroke storage. */
+    if (block && (block->next || block->capacity > STROKE_BLOCK_SIZE))
+    {
+        _stroke_free_blocks(stroke_conversion);
+        block = NULL;
+    }
+    if (block)
+        block->used = 0;
+    stroke_conversion->current_block = block;
+
+    /* Every list node lived in the blocks, so just drop the lists. */
+    stroke_conversion->path_point_list = NULL;
+    stroke_conversion->path_last_point = NULL;
+    stroke_conversion->point_count = 0;
+    stroke_conversion->left_stroke_point = NULL;
+    stroke_conversion->last_right_stroke_point = NULL;
+    stroke_conversion->stroke_point_list = NULL;
+    stroke_conversion->stroke_last_point = NULL;
+    stroke_conversion->stroke_point_count = 0;
+    stroke_conversion->stroke_sub_path_list = NULL;
+    stroke_conversion->last_stroke_sub_path = NULL;
+    stroke_conversion->swing_start_point = NULL;
+    stroke_conversion->swing_start_stroke_point = NULL;
+}
+
 vg_lite_error_t _add_point_to_point_list_wdelta(
     vg_lite_stroke_conversion_t * stroke_conversion,
     vg_lite_float_t X,
@@ -724,7 +889,7 @@ vg_lite_error_t _add_point_to_point_list_wdelta(
         return VG_LITE_INVALID_ARGUMENT;
 
     last_point = stroke_conversion->path_last_point;
-    point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*point));
+    point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*point));
 
     if(!point)
         return VG_LITE_OUT_OF_RESOURCES;
@@ -743,11 +908,7 @@ vg_lite_error_t _add_point_to_point_list_wdelta(
     point->prev = last_point;
     stroke_conversion->point_count++;
 
-    return error;
 ErrorHandler:
-
-    vg_lite_os_free(point);
-    point = NULL;
     return error;
 }
 
@@ -768,7 +929,7 @@ vg_lite_error_t _add_point_to_point_list(
     last_point = stroke_conversion->path_last_point;
     if (last_point == NULL)
     {
-        point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*point));
+        point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*point));
         if(!point)
             return VG_LITE_OUT_OF_RESOURCES;
         memset(point, 0, sizeof(*point));
@@ -1073,7 +1234,7 @@ _add_point_to_right_stroke_point_list_tail(
     if(!stroke_conversion)
         return VG_LITE_INVALID_ARGUMENT;
 
-    point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*point));
+    point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*point));
     if(!point)
         return VG_LITE_OUT_OF_RESOURCES;
 
@@ -1106,7 +1267,7 @@ _add_point_to_left_stroke_point_list_head(
     if(!stroke_conversion)
         return VG_LITE_INVALID_ARGUMENT;
 
-    point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*point));
+    point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*point));
 
     if(!point)
         return VG_LITE_OUT_OF_RESOURCES;
@@ -1137,7 +1298,7 @@ static vg_lite_error_t _add_stroke_sub_path(
     if(!stroke_conversion || !sub_path)
         return VG_LITE_INVALID_ARGUMENT;
 
-    *sub_path = (vg_lite_sub_path_ptr)vg_lite_os_malloc(sizeof(**sub_path));
+    *sub_path = (vg_lite_sub_path_ptr)_stroke_alloc(stroke_conversion, sizeof(**sub_path));
 
     if(!*sub_path)
         return VG_LITE_OUT_OF_RESOURCES;
@@ -1198,7 +1359,7 @@ _add_zero_length_stroke_sub_path(
             dy = -Point->tangentX * half_width;
         }
 
-        new_point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*new_point));
+        new_point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*new_point));
 
         if(!new_point)
             return VG_LITE_OUT_OF_RESOURCES;
@@ -1222,7 +1383,7 @@ _add_zero_length_stroke_sub_path(
     else
     {
         /* Draw a circle. */
-        new_point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*new_point));
+        new_point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*new_point));
 
         if(!new_point)
             return VG_LITE_OUT_OF_RESOURCES;
@@ -1439,7 +1600,7 @@ _convert_circle_arc(
         }
 
         /* Add control point. */
-        point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*point));
+        point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*point));
 
         if(!point)
             return VG_LITE_OUT_OF_RESOURCES;
@@ -1460,7 +1621,7 @@ _convert_circle_arc(
         }
 
         /* Add anchor point. */
-        point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*point));
+        point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*point));
 
         if(!point) {
             error = VG_LITE_OUT_OF_RESOURCES;
@@ -1479,16 +1640,7 @@ _convert_circle_arc(
     last_point->next = NULL;
     *point_list = start_point;
 
-    return error;
 ErrorHandler:
-    /* Return status. */
-    while (start_point)
-    {
-        point = start_point;
-        start_point = start_point->next;
-        vg_lite_os_free(point);
-    }
-    start_point = last_point = point = NULL;
     return error;
 }
 
@@ -1513,7 +1665,7 @@ _start_new_stroke_sub_path(
 
     VG_LITE_ERROR_HANDLER(_add_stroke_sub_path(stroke_conversion, &stroke_sub_path));
 
-    new_point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*new_point));
+    new_point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*new_point));
     if(!new_point)
         return VG_LITE_OUT_OF_RESOURCES;
 
@@ -1526,7 +1678,7 @@ _start_new_stroke_sub_path(
 
     stroke_sub_path->point_list = stroke_conversion->last_right_stroke_point = new_point;
 
-    new_point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*new_point));
+    new_point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*new_point));
     if(!new_point)
         return VG_LITE_OUT_OF_RESOURCES;
 
@@ -2623,7 +2775,7 @@ _create_stroke_path(
 
                 /* Add curve. */
                 /* Add extra point to the beginning with end point's coordinates. */
-                point = (vg_lite_path_point_ptr)vg_lite_os_malloc(sizeof(*point));
+                point = (vg_lite_path_point_ptr)_stroke_alloc(stroke_conversion, sizeof(*point));
                 if(!point)
                     return VG_LITE_INVALID_ARGUMENT;
                 memset(point, 0, sizeof(*point));
@@ -2668,7 +2820,6 @@ static vg_lite_error_t _copy_stroke_path(
     float *pfloat;
     char *cpath = NULL;
     char last_opcode = 0;
-    void *temp_stroke_path_data = NULL;
     uint32_t temp_stroke_path_size;
     vg_lite_sub_path_ptr sub_path;
     vg_lite_float_t half_width;
@@ -2682,38 +2833,33 @@ static vg_lite_error_t _copy_stroke_path(
     if(!stroke_conversion || !path || !sub_path)
         return VG_LITE_INVALID_ARGUMENT; 
 
-    while (sub_path)
+    /* Size all sub paths first so the stroke path is allocated once. */
+    for (; sub_path; sub_path = sub_path->next)
     {
-        tmp_point = prev_point = point = sub_path->point_list;
         totalsize += _commandSize_float[VLC_OP_LINE] * sub_path->point_count + _commandSize_float[VLC_OP_CLOSE];
-        for(;tmp_point;tmp_point = tmp_point->next)
+        for(tmp_point = sub_path->point_list;tmp_point;tmp_point = tmp_point->next)
         {
             if(tmp_point->curve_type == CURVE_ARC_SCCW || tmp_point->curve_type == CURVE_ARC_SCCW_HALF) {
                 totalsize += 4 * _commandSize_float[VLC_OP_QUAD]; 
             }
         }
+    }
 
-        temp_stroke_path_data = path->stroke_path_data;
-        temp_stroke_path_size = path->stroke_path_size;
+    path->stroke_path_size = 0;
+    if(totalsize == 0)
+        return VG_LITE_INVALID_ARGUMENT;
 
-        path->stroke_path_size += totalsize;
-        if(path->stroke_path_size == 0) {
-            error = VG_LITE_INVALID_ARGUMENT;
-            goto ErrorHandler;
-        }
-        path->stroke_path_data = (void *)vg_lite_os_malloc(path->stroke_path_size);
-        if(!path->stroke_path_data) {
-            error = VG_LITE_OUT_OF_RESOURCES;
-            goto ErrorHandler;
-        }
+    path->stroke_path_data = (void *)vg_lite_os_malloc(totalsize);
+    if(!path->stroke_path_data)
+        return VG_LITE_OUT_OF_RESOURCES;
 
-        memset(path->stroke_path_data, 0, path->stroke_path_size);
+    memset(path->stroke_path_data, 0, totalsize);
 
-        if(temp_stroke_path_data) {
-            memcpy(path->stroke_path_data,temp_stroke_path_data,temp_stroke_path_size);
-            vg_lite_os_free(temp_stroke_path_data);
-            temp_stroke_path_data = NULL;
-        }
+    sub_path = stroke_conversion->stroke_sub_path_list;
+    while (sub_path)
+    {
+        prev_point = point = sub_path->point_list;
+        temp_stroke_path_size = path->stroke_path_size;
 
         pfloat = (vg_lite_float_t *)((char *)path->stroke_path_data + temp_stroke_path_size);
         if(last_opcode == VLC_OP_CLOSE) {
@@ -2813,8 +2959,6 @@ static vg_lite_error_t _copy_stroke_path(
                         *pfloat++ = p2->x;
                         *pfloat++ = p2->y;
                         real_size += _commandSize_float[VLC_OP_QUAD];
-                        vg_lite_os_free(p);
-                        vg_lite_os_free(p2);
                     }
                 }
                 else
@@ -2841,20 +2985,112 @@ static vg_lite_error_t _copy_stroke_path(
             *cpath = VLC_OP_END;
         real_size += _commandSize_float[VLC_OP_CLOSE];
         path->stroke_path_size = temp_stroke_path_size + real_size;
-        totalsize = 0;
         real_size = 0;
         sub_path = sub_path->next;
         last_opcode = *cpath;
     }
 
 ErrorHandler:
+    return error;
+}
+
+/* Number of coordinates following a stroke path opcode. */
+static int32_t _stroke_coordinate_count(uint8_t opcode)
+{
+    switch (opcode) {
+        case VLC_OP_MOVE:
+        case VLC_OP_LINE:
+            return 2;
+
+        case VLC_OP_QUAD:
+            return 4;
+
+        default:
+            return 0;
+    }
+}
+
+static int32_t _round_coordinate(vg_lite_float_t value)
+{
+    return value >= 0.0f ? (int32_t)(value + 0.5f) : -(int32_t)(0.5f - value);
+}
+
+/* Rewrite the FP32 stroke path in place with the smallest integer format that fits. */
+static vg_lite_error_t _quantize_stroke_path(
+    vg_lite_stroke_conversion_t * stroke_conversion,
+    vg_lite_path_t *path
+    )
+{
+    uint8_t *data;
+    int32_t src, dst = 0, data_size;
+    vg_lite_float_t coords[4];
+    vg_lite_float_t min = 0.0f, max = 0.0f;
+    vg_lite_float_t scale;
+    int32_t count, i;
+    uint8_t opcode;
+
+    if(!stroke_conversion || !path)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    data = (uint8_t *)path->stroke_path_data;
+    stroke_conversion->stroke_path_format = VG_LITE_FP32;
+    if (stroke_conversion->quantize_error <= 0.0f || !data)
+        return VG_LITE_SUCCESS;
+
+    /* Rounding moves a point by up to half a path unit. */
+    scale = stroke_conversion->flatten_scale > 0.0f ? stroke_conversion->flatten_scale : 1.0f;
+    if (0.5f * scale > stroke_conversion->quantize_error)
+        return VG_LITE_SUCCESS;
+
+    /* Find the coordinate range. Coordinates are aligned to their size, opcodes are not. */
+    for (src = 0; src < path->stroke_path_size;) {
+        opcode = data[src++];
+        count = _stroke_coordinate_count(opcode);
+        if (count)
+            src = (src + 3) & ~3;
+        for (i = 0; i < count; i++, src += sizeof(vg_lite_float_t)) {
+            coords[0] = *(vg_lite_float_t *)(data + src);
+            if (coords[0] < min) min = coords[0];
+            if (coords[0] > max) max = coords[0];
+        }
+        if (opcode == VLC_OP_END)
+            break;
+    }
 
-    if(temp_stroke_path_data) {
-            vg_lite_os_free(temp_stroke_path_data);
-            temp_stroke_path_data = NULL;
+    if (min >= -32768.0f && max <= 32767.0f)
+        stroke_conversion->stroke_path_format = VG_LITE_S16;
+    else if (min >= -2147483520.0f && max <= 2147483520.0f)
+        stroke_conversion->stroke_path_format = VG_LITE_S32;
+    else
+        return VG_LITE_SUCCESS;
+    data_size = stroke_conversion->stroke_path_format == VG_LITE_S16 ? sizeof(int16_t) : sizeof(int32_t);
+
+    /* Integer commands are never longer than float ones, so convert in place. */
+    for (src = 0; src < path->stroke_path_size;) {
+        opcode = data[src++];
+        count = _stroke_coordinate_count(opcode);
+        if (count)
+            src = (src + 3) & ~3;
+        for (i = 0; i < count; i++, src += sizeof(vg_lite_float_t))
+            coords[i] = *(vg_lite_float_t *)(data + src);
+
+        data[dst++] = opcode;
+        if (count) {
+            while (dst & (data_size - 1))
+                data[dst++] = 0;
+        }
+        for (i = 0; i < count; i++, dst += data_size) {
+            if (data_size == (int32_t)sizeof(int16_t))
+                *(int16_t *)(data + dst) = (int16_t)_round_coordinate(coords[i]);
+            else
+                *(int32_t *)(data + dst) = _round_coordinate(coords[i]);
         }
+        if (opcode == VLC_OP_END)
+            break;
+    }
+    path->stroke_path_size = dst;
 
-    return error;
+    return VG_LITE_SUCCESS;
 }
 
 static vg_lite_error_t _initialize_stroke_dash_parameters(
@@ -2936,12 +3172,138 @@ static vg_lite_error_t _initialize_stroke_dash_parameters(
     return error;
 }
 
+static uint32_t _stroke_hash(
+    uint32_t hash,
+    const void * data,
+    uint32_t bytes
+    )
+{
+    const uint8_t * p = (const uint8_t *)data;
+
+    /* FNV-1a. */
+    while (bytes--)
+    {
+        hash ^= *p++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static void _stroke_key(
+    vg_lite_stroke_conversion_t * stroke_conversion,
+    vg_lite_path_t *path,
+    vg_lite_stroke_key_t *key
+    )
+{
+    uint32_t hash = 2166136261u;
+
+    key->path = path->path;
+    key->path_length = path->path_length;
+    key->format = path->format;
+    key->cap_style = stroke_conversion->stroke_cap_style;
+    key->join_style = stroke_conversion->stroke_join_style;
+    key->line_width = stroke_conversion->stroke_line_width;
+    key->miter_limit = stroke_conversion->stroke_miter_limit;
+    key->dash_pattern = stroke_conversion->stroke_dash_pattern;
+    key->dash_pattern_count = stroke_conversion->stroke_dash_pattern_count;
+    key->dash_phase = stroke_conversion->stroke_dash_phase;
+    key->flatten_scale = stroke_conversion->flatten_scale;
+    key->quantize_error = stroke_conversion->quantize_error;
+
+    hash = _stroke_hash(hash, path->path, path->path_length);
+    if (stroke_conversion->stroke_dash_pattern != NULL)
+        hash = _stroke_hash(hash, stroke_conversion->stroke_dash_pattern,
+                            stroke_conversion->stroke_dash_pattern_count * sizeof(vg_lite_float_t));
+    key->hash = hash;
+}
+
+/* The hash only guards against data edited in place, everything else must match exactly. */
+static int _stroke_key_equal(
+    vg_lite_stroke_key_t *a,
+    vg_lite_stroke_key_t *b
+    )
+{
+    return a->path == b->path && a->path_length == b->path_length && a->format == b->format &&
+           a->cap_style == b->cap_style && a->join_style == b->join_style &&
+           a->line_width == b->line_width && a->miter_limit == b->miter_limit &&
+           a->dash_pattern == b->dash_pattern && a->dash_pattern_count == b->dash_pattern_count &&
+           a->dash_phase == b->dash_phase && a->flatten_scale == b->flatten_scale &&
+           a->quantize_error == b->quantize_error && a->hash == b->hash;
+}
+
+static vg_lite_error_t _upload_stroke_path(
+    vg_lite_stroke_conversion_t * stroke_conversion,
+    vg_lite_path_t *path
+    )
+{
+    vg_lite_error_t error;
+    vg_lite_kernel_allocate_t allocate;
+    uint32_t *memory;
+    uint32_t bytes;
+
+    /* Strokes may be generated before the driver is initialized. */
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    if (!s_context.init)
+        return VG_LITE_NO_CONTEXT;
+#else
+    if (vg_lite_os_get_tls() == NULL)
+        return VG_LITE_NO_CONTEXT;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+
+    /* Same layout as vg_lite_upload_path. */
+    bytes = (8 + path->stroke_path_size + 7 + 8) & ~7;
+
+    allocate.bytes = bytes;
+    allocate.contiguous = 1;
+    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_ALLOCATE, &allocate));
+
+    memory = (uint32_t *)allocate.memory;
+    memory[0] = 0x40000000 | ((path->stroke_path_size + 7) / 8);
+    memory[1] = 0;
+    memcpy(memory + 2, path->stroke_path_data, path->stroke_path_size);
+    memory[bytes / 4 - 2] = 0x70000000;
+    memory[bytes / 4 - 1] = 0;
+
+    stroke_conversion->uploaded_handle = allocate.memory_handle;
+    stroke_conversion->uploaded_address = allocate.memory_gpu;
+    stroke_conversion->uploaded_bytes = bytes;
+
+    return VG_LITE_SUCCESS;
+}
+
+static vg_lite_error_t _free_stroke_upload(
+    vg_lite_stroke_conversion_t * stroke_conversion
+    )
+{
+    vg_lite_error_t error;
+    vg_lite_kernel_free_t free_cmd;
+    vg_lite_fence_t fence;
+
+    if (stroke_conversion->uploaded_handle == NULL)
+        return VG_LITE_SUCCESS;
+
+    /* Earlier draws may still call the uploaded stroke. */
+    VG_LITE_RETURN_ERROR(vg_lite_fence_insert(&fence));
+    VG_LITE_RETURN_ERROR(vg_lite_fence_wait(&fence, VG_LITE_FENCE_INFINITE));
+
+    free_cmd.memory_handle = stroke_conversion->uploaded_handle;
+    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_FREE, &free_cmd));
+
+    stroke_conversion->uploaded_handle = NULL;
+    stroke_conversion->uploaded_address = 0;
+    stroke_conversion->uploaded_bytes = 0;
+
+    return VG_LITE_SUCCESS;
+}
+
 vg_lite_error_t vg_lite_update_stroke(
     vg_lite_path_t *path
     )
 {
     vg_lite_error_t error = VG_LITE_SUCCESS;
     vg_lite_stroke_conversion_t * stroke_conversion;
+    vg_lite_stroke_key_t key;
 
     if(!path)
         return VG_LITE_INVALID_ARGUMENT;
@@ -2957,14 +3319,35 @@ vg_lite_error_t vg_lite_update_stroke(
 
     stroke_conversion = path->stroke_conversion;
 
+    /* Keep the stroke if neither the path nor the stroke parameters changed. */
+    _stroke_key(stroke_conversion, path, &key);
+    if (stroke_conversion->stroke_cached && _stroke_key_equal(&stroke_conversion->stroke_key, &key) && path->stroke_path_data)
+    {
+        stroke_conversion->stroke_cache_hits++;
+
+        /* The stroke is static, so let the GPU fetch it directly. Without
+           GPU memory it is still copied into the command buffer. */
+        if (stroke_conversion->uploaded_handle == NULL)
+            _upload_stroke_path(stroke_conversion, path);
+
+        return VG_LITE_SUCCESS;
+    }
+    stroke_conversion->stroke_cache_misses++;
+    stroke_conversion->stroke_cached = 0;
+    VG_LITE_RETURN_ERROR(_free_stroke_upload(stroke_conversion));
+
     /* Free the stroke. */
     if (path->stroke_path_data)
     {
         vg_lite_os_free(path->stroke_path_data);
         /* Reset the stroke. */
         path->stroke_path_data = NULL;
+        path->stroke_path_size = 0;
     }
 
+    /* Recycle the point and sub path storage of the previous update. */
+    _stroke_reset(stroke_conversion);
+
     if (stroke_conversion->stroke_line_width >= FLOAT_FAT_LINE_WIDTH
         &&  stroke_conversion->stroke_line_width >= 1.0f)
     {
@@ -2974,6 +3357,13 @@ vg_lite_error_t vg_lite_update_stroke(
     VG_LITE_RETURN_ERROR(_flatten_path(stroke_conversion, path));
     VG_LITE_RETURN_ERROR(_create_stroke_path(stroke_conversion));
     VG_LITE_RETURN_ERROR(_copy_stroke_path(stroke_conversion, path));
+    VG_LITE_RETURN_ERROR(_quantize_stroke_path(stroke_conversion, path));
+
+    /* The points and sub paths are dead once the stroke path is written. */
+    _stroke_reset(stroke_conversion);
+
+    stroke_conversion->stroke_key = key;
+    stroke_conversion->stroke_cached = 1;
 
     return error;
 }
@@ -3017,6 +3407,49 @@ vg_lite_error_t vg_lite_set_stroke(
     return VG_LITE_SUCCESS;
 }
 
+vg_lite_error_t vg_lite_set_stroke_transform(
+    vg_lite_path_t *path,
+    vg_lite_matrix_t *matrix
+    )
+{
+    vg_lite_float_t a, b, c, d, sum, det, root;
+
+    if(!path || !path->stroke_conversion)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    if (!matrix) {
+        path->stroke_conversion->flatten_scale = 0.0f;
+        return VG_LITE_SUCCESS;
+    }
+
+    /* Largest singular value of the linear part. */
+    a = matrix->m[0][0];
+    b = matrix->m[0][1];
+    c = matrix->m[1][0];
+    d = matrix->m[1][1];
+    sum = a * a + b * b + c * c + d * d;
+    det = a * d - b * c;
+    root = sum * sum - 4.0f * det * det;
+    if (root < 0.0f)
+        root = 0.0f;
+    path->stroke_conversion->flatten_scale = SQRTF((sum + SQRTF(root)) * 0.5f);
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_set_stroke_precision(
+    vg_lite_path_t *path,
+    vg_lite_float_t max_error
+    )
+{
+    if(!path || !path->stroke_conversion || max_error < 0.0f)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    path->stroke_conversion->quantize_error = max_error;
+
+    return VG_LITE_SUCCESS;
+}
+
 static inline vg_lite_error_t transform_bounding_box(vg_lite_rectangle_t *in_bbx,
                                                      vg_lite_matrix_t *matrix,
                                                      vg_lite_rectangle_t *clip,
@@ -3318,6 +3751,7 @@ vg_lite_error_t _allocate_command_buffer(uint32_t size)
 {
     vg_lite_kernel_allocate_t allocate;
     vg_lite_error_t error = VG_LITE_SUCCESS;
+    uint32_t i;
 #if defined(VG_DRIVER_SINGLE_THREAD)
     vg_lite_context_t *ctx = &s_context;
 #else
@@ -3336,24 +3770,19 @@ vg_lite_error_t _allocate_command_buffer(uint32_t size)
 
     allocate.bytes = size;
     allocate.contiguous = 1;
-    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_ALLOCATE, &allocate));
-
-    ctx->context.command_buffer[0] = allocate.memory_handle;
-    ctx->context.command_buffer_logical[0] = allocate.memory;
-    ctx->context.command_buffer_physical[0] = allocate.memory_gpu;
 
-    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_ALLOCATE, &allocate));
+    for (i = 0; i < CMDBUF_COUNT; i++) {
+        VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_ALLOCATE, &allocate));
 
-    ctx->context.command_buffer[1] = allocate.memory_handle;
-    ctx->context.command_buffer_logical[1] = allocate.memory;
-    ctx->context.command_buffer_physical[1] = allocate.memory_gpu;
+        ctx->context.command_buffer[i] = allocate.memory_handle;
+        ctx->context.command_buffer_logical[i] = allocate.memory;
+        ctx->context.command_buffer_physical[i] = allocate.memory_gpu;
 
-    ctx->command_buffer[0] = ctx->context.command_buffer_logical[0];
-    ctx->command_buffer[1] = ctx->context.command_buffer_logical[1];
+        ctx->command_buffer[i] = ctx->context.command_buffer_logical[i];
+        ctx->command_offset[i] = 0;
+    }
 
     ctx->command_buffer_size = size;
-    ctx->command_offset[0] = 0;
-    ctx->command_offset[1] = 0;
     ctx->command_buffer_current = 0;
 
 #if !defined(VG_DRIVER_SINGLE_THREAD)
@@ -3362,6 +3791,10 @@ vg_lite_error_t _allocate_command_buffer(uint32_t size)
     ctx->ts_init = 0;
     memset(ctx->ts_record, 0, sizeof(ctx->ts_record));
 #endif
+#if VG_STATE_SHADOW
+    memset(ctx->state_shadow_valid, 0, sizeof(ctx->state_shadow_valid));
+    ctx->state_run_end = 0;
+#endif /* VG_STATE_SHADOW */
 
     return error;
 }
@@ -3370,6 +3803,7 @@ vg_lite_error_t _free_command_buffer()
 {
     vg_lite_kernel_free_t free;
     vg_lite_error_t error = VG_LITE_SUCCESS;
+    uint32_t i;
 
 #if defined(VG_DRIVER_SINGLE_THREAD)
     vg_lite_context_t *ctx = &s_context;
@@ -3384,18 +3818,13 @@ vg_lite_error_t _free_command_buffer()
     ctx = &tls->t_context;
 #endif
 
-    if(ctx->context.command_buffer[0]){
-        free.memory_handle = ctx->context.command_buffer[0];
-        VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_FREE, &free));
-        ctx->context.command_buffer[0] = 0;
-        ctx->context.command_buffer_logical[0] = 0;
-    }
-
-    if(ctx->context.command_buffer[1]){
-        free.memory_handle = ctx->context.command_buffer[1];
-        VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_FREE, &free));
-        ctx->context.command_buffer[1] = 0;
-        ctx->context.command_buffer_logical[1] = 0;
+    for (i = 0; i < CMDBUF_COUNT; i++) {
+        if(ctx->context.command_buffer[i]){
+            free.memory_handle = ctx->context.command_buffer[i];
+            VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_FREE, &free));
+            ctx->context.command_buffer[i] = 0;
+            ctx->context.command_buffer_logical[i] = 0;
+        }
     }
 
     return error;
@@ -3434,64 +3863,60 @@ static uint8_t PackColorComponent(vg_lite_float_t value)
 #if !defined(VG_DRIVER_SINGLE_THREAD)
 static void command_buffer_copy(void *new_cmd, void *old_cmd, uint32_t start, uint32_t end, uint32_t *cmd_count)
 {
-    uint32_t i = start,j;
-    uint32_t *p_new_cmd32,*p_cmd32,*temp;
-    uint32_t data_count = 0;
+    uint32_t i, j, pass;
+    uint32_t *p_new_cmd32,*p_cmd32;
+    uint32_t data_count = 0, address;
 
+    /* Only the states of the commands are copied. Every register in 0x0A00 - 0x0AFF is copied once,
+       with the value it was written last, so splitting a long draw again does not copy more. */
     memset(&hw,0,sizeof(vg_lite_hardware_t));
-    temp = NULL;
     p_new_cmd32 = (uint32_t *)new_cmd;
-    p_cmd32 = (uint32_t *)old_cmd;
-    while(i < end)
-    {
-        /* data command is 0x40000000 | count, and count = databytes / 8  ,and data command and databytes should align to 8 */
-        if((*p_cmd32 & 0xF0000000) == 0x40000000) {
-            data_count = *p_cmd32 & 0x0FFFFFFF;
-            data_count++;
-            p_cmd32 += 2 * data_count;
-            i += data_count * 8;
-         /* SEMAPHORE command is 0x10000000 | id,stall command is 0x20000000 | id , call command is is 0x20000000 | count,
-            and this three command should occupy 8bytes*/
-        }else if((*p_cmd32 & 0xF0000000) == 0x20000000 || (*p_cmd32 & 0xF0000000) == 0x10000000
-                || (*p_cmd32 & 0xF0000000) == 0x60000000 || (*p_cmd32 & 0xF0000000) == 0x80000000){
-            p_cmd32 += 2;
-            i += 8;
-            /* register command is 0x30000000 | ((count) << 16) | address,
-            and the bytes of this command add register count should align to 8 */
-        }else if((*p_cmd32 & 0xF0000000) == 0x30000000) {
-            /* get register data count */
-            data_count = (*p_cmd32 & 0x0FFFFFFF) >> 16;
-            if(data_count == 1)
-            {
-                temp = p_cmd32 + 1;
-                if(hw.hw_states[*p_cmd32 & 0xff].state != *temp || !hw.hw_states[*p_cmd32 & 0xff].init){
-                    hw.hw_states[*p_cmd32 & 0xff].state = *temp;
-                    hw.hw_states[*p_cmd32 & 0xff].init = 1;
-                    for(j = 0; j < 2; j++) {
-                        *p_new_cmd32 = *p_cmd32;
+    for(pass = 0; pass < 2; pass++) {
+        i = start;
+        p_cmd32 = (uint32_t *)old_cmd;
+        while(i < end)
+        {
+            /* data command is 0x40000000 | count, and count = databytes / 8  ,and data command and databytes should align to 8 */
+            if((*p_cmd32 & 0xF0000000) == 0x40000000) {
+                data_count = *p_cmd32 & 0x0FFFFFFF;
+                data_count++;
+                p_cmd32 += 2 * data_count;
+                i += data_count * 8;
+             /* SEMAPHORE command is 0x10000000 | id,stall command is 0x20000000 | id , call command is is 0x20000000 | count,
+                and this three command should occupy 8bytes*/
+            }else if((*p_cmd32 & 0xF0000000) == 0x20000000 || (*p_cmd32 & 0xF0000000) == 0x10000000
+                    || (*p_cmd32 & 0xF0000000) == 0x60000000 || (*p_cmd32 & 0xF0000000) == 0x80000000){
+                p_cmd32 += 2;
+                i += 8;
+                /* register command is 0x30000000 | ((count) << 16) | address,
+                and the bytes of this command add register count should align to 8 */
+            }else if((*p_cmd32 & 0xF0000000) == 0x30000000) {
+                /* get register data count */
+                data_count = (*p_cmd32 & 0x0FFFFFFF) >> 16;
+                address = *p_cmd32 & 0xFFFF;
+                if(address >= 0x0A00 && address + data_count <= 0x0B00) {
+                    for(j = 0; j < data_count; j++) {
+                        if(pass == 0) {
+                            hw.hw_states[(address + j) & 0xff].last = i;
+                        }
+                        else if(hw.hw_states[(address + j) & 0xff].last == i) {
+                            p_new_cmd32[0] = VG_LITE_STATE((address + j));
+                            p_new_cmd32[1] = p_cmd32[1 + j];
+                            p_new_cmd32 += 2;
+                            *cmd_count += 8;
+                        }
+                    }
+                }
+                else if(pass == 1) {
+                    /* the bytes of register count add register command */
+                    for(j = 0; j < VG_LITE_ALIGN(data_count + 1, 2); j++) {
+                        *p_new_cmd32 = p_cmd32[j];
                         p_new_cmd32++;
-                        p_cmd32++;
                         *cmd_count += 4;
-                        i += 4;
                     }
                 }
-                else
-                {
-                        p_cmd32 += 2;
-                        i += 8;
-                }
-            }else{
-                /* the bytes of register count add register command */
-                data_count++;
-                if(data_count % 2 != 0)
-                    data_count++;
-                for(j = 0; j < data_count; j++) {
-                    *p_new_cmd32 = *p_cmd32;
-                    p_new_cmd32++;
-                    p_cmd32++;
-                    *cmd_count += 4;
-                    i += 4;
-                }
+                p_cmd32 += VG_LITE_ALIGN(data_count + 1, 2);
+                i += VG_LITE_ALIGN(data_count + 1, 2) * 4;
             }
         }
     }
@@ -4161,6 +4586,141 @@ static vg_lite_error_t stall(vg_lite_context_t * context, uint32_t time_ms, uint
 #else
 static vg_lite_error_t stall(vg_lite_context_t * context, uint32_t time_ms);
 #endif /* VG_DRIVER_SINGLE_THREAD */
+
+#if VG_STATE_SHADOW
+/* Registers whose last written value is kept in the context. They are plain states, so writing the
+   value they already hold again has no effect. */
+static int is_shadowed_state(uint32_t address)
+{
+    return address == 0x0A00 || address == 0x0A02 || address == 0x0A34 || address == 0x0A3B ||
+           address == 0x0A3C || (address >= 0x0A40 && address <= 0x0A45);
+}
+#endif /* VG_STATE_SHADOW */
+
+/* Forget the shadowed values, e.g. when the next commands may run after another context's. */
+static void reset_state_shadow(vg_lite_context_t *context)
+{
+#if VG_STATE_SHADOW
+    memset(context->state_shadow_valid, 0, sizeof(context->state_shadow_valid));
+    context->state_run_end = 0;
+#endif /* VG_STATE_SHADOW */
+}
+
+/* Returns 1 if the register already holds data, so the write can be dropped. */
+static int state_shadow_hit(vg_lite_context_t *context, uint32_t address, uint32_t data)
+{
+#if VG_STATE_SHADOW
+    uint32_t index = address - 0x0A00;
+
+#if !defined(VG_DRIVER_SINGLE_THREAD)
+    /* The first state of a command buffer is the slot for the context buffer call. */
+    if (CMDBUF_OFFSET(*context) == 0)
+        return 0;
+#endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
+    if (context->recording == NULL && is_shadowed_state(address) &&
+        context->state_shadow_valid[index] && context->state_shadow[index] == data) {
+        context->states_elided++;
+        context->state_words_saved += 2;
+        return 1;
+    }
+#endif /* VG_STATE_SHADOW */
+
+    return 0;
+}
+
+/* Record a state command of count registers from address that was written at offset start. */
+static void state_written(vg_lite_context_t *context, uint32_t address, uint32_t count, uint32_t *data, uint32_t start)
+{
+#if VG_STATE_SHADOW
+    uint32_t i;
+
+    /* Command lists can be called with any states, their writes are not remembered. */
+    if (context->recording != NULL)
+        return;
+#if !defined(VG_DRIVER_SINGLE_THREAD)
+    /* The context buffer call may replace the first state on submit. */
+    if (start == 0) {
+        context->state_run_end = 0;
+        return;
+    }
+#endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
+    for (i = 0; i < count; i++) {
+        if (is_shadowed_state(address + i)) {
+            context->state_shadow[address + i - 0x0A00] = data[i];
+            context->state_shadow_valid[address + i - 0x0A00] = 1;
+        }
+    }
+    if (count == 1 && is_shadowed_state(address)) {
+        context->state_run_buffer = CMDBUF_INDEX(*context);
+        context->state_run_start = start;
+        context->state_run_end = CMDBUF_OFFSET(*context);
+    }
+    else {
+        context->state_run_end = 0;
+    }
+#endif /* VG_STATE_SHADOW */
+}
+
+/* Append a write to the state command that ends at the current offset when it covers the registers
+   right before address. Appending fills its NOP padding if it has one. Returns 1 if appended. */
+static int append_state(vg_lite_context_t *context, uint32_t address, uint32_t data)
+{
+#if VG_STATE_SHADOW
+    uint32_t *command;
+    uint32_t count, start;
+
+    if (context->recording != NULL || context->state_run_end == 0 ||
+        context->state_run_end != CMDBUF_OFFSET(*context) || context->state_run_buffer != CMDBUF_INDEX(*context) ||
+        !is_shadowed_state(address))
+        return 0;
+
+    start = context->state_run_start;
+    command = (uint32_t *) (CMDBUF_BUFFER(*context) + start);
+    count = (command[0] >> 16) & 0xFFF;
+    if ((command[0] >> 28) != 0x3 || (command[0] & 0xFFFF) + count != address ||
+        start + VG_LITE_ALIGN(count + 1, 2) * 4 != CMDBUF_OFFSET(*context))
+        return 0;
+
+    command[0] = VG_LITE_STATES(count + 1, (address - count));
+    command[1 + count] = data;
+    if (count % 2) {
+        command[2 + count] = VG_LITE_NOP();
+        CMDBUF_OFFSET(*context) += 8;
+    }
+    else {
+        /* The value took the place of the padding. */
+        context->state_words_saved += 2;
+    }
+    context->states_coalesced++;
+    context->state_shadow[address - 0x0A00] = data;
+    context->state_shadow_valid[address - 0x0A00] = 1;
+    context->state_run_end = CMDBUF_OFFSET(*context);
+
+    return 1;
+#else
+    return 0;
+#endif /* VG_STATE_SHADOW */
+}
+
+#if !defined(VG_DRIVER_SINGLE_THREAD)
+/* A command buffer continuing a split draw may run after other contexts, so the registers whose
+   writes were dropped are programmed again. */
+static void replay_state_shadow(vg_lite_context_t *context)
+{
+#if VG_STATE_SHADOW
+    uint32_t i;
+
+    for (i = 0; i < STATE_SHADOW_COUNT; i++) {
+        if (!context->state_shadow_replay[i])
+            continue;
+        ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0] = VG_LITE_STATE((0x0A00 + i));
+        ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[1] = context->state_shadow[i];
+        CMDBUF_OFFSET(*context) += 8;
+        context->state_shadow_valid[i] = 1;
+    }
+#endif /* VG_STATE_SHADOW */
+}
+#endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
  
 #if !defined(VG_DRIVER_SINGLE_THREAD)
 /* Push a state array into context buffer. */
@@ -4275,6 +4835,7 @@ static vg_lite_error_t push_states(vg_lite_context_t * context, uint32_t address
     }
 
     CMDBUF_OFFSET(*context) += VG_LITE_ALIGN(count + 1, 2) * 4;
+    state_written(context, address, count, data, CMDBUF_OFFSET(*context) - VG_LITE_ALIGN(count + 1, 2) * 4);
 
     return VG_LITE_SUCCESS;
 }
@@ -4285,16 +4846,22 @@ static vg_lite_error_t push_state(vg_lite_context_t * context, uint32_t address,
     vg_lite_error_t error;
     if (!has_valid_command_buffer(context))
         return VG_LITE_NO_CONTEXT;
+    if (state_shadow_hit(context, address, data))
+        return VG_LITE_SUCCESS;
 
     if (CMDBUF_OFFSET(*context) + 16 >= CMDBUF_SIZE(*context)) {
         VG_LITE_RETURN_ERROR(submit(context));
         VG_LITE_RETURN_ERROR(stall(context, 0, (uint32_t)~0));
     }
 
+    if (append_state(context, address, data))
+        return VG_LITE_SUCCESS;
+
     ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0] = VG_LITE_STATE(address);
     ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[1] = data;
 
     CMDBUF_OFFSET(*context) += 8;
+    state_written(context, address, 1, &data, CMDBUF_OFFSET(*context) - 8);
 
     return VG_LITE_SUCCESS;
 }
@@ -4302,22 +4869,7 @@ static vg_lite_error_t push_state(vg_lite_context_t * context, uint32_t address,
 /* Push a single state command with given address. */
 static vg_lite_error_t push_state_ptr(vg_lite_context_t * context, uint32_t address, void * data_ptr)
 {
-    vg_lite_error_t error;
-    uint32_t data = *(uint32_t *) data_ptr;
-    if (!has_valid_command_buffer(context))
-        return VG_LITE_NO_CONTEXT;
-
-    if (CMDBUF_OFFSET(*context) + 16 >= CMDBUF_SIZE(*context)) {
-        VG_LITE_RETURN_ERROR(submit(context));
-        VG_LITE_RETURN_ERROR(stall(context, 0, (uint32_t)~0));
-    }
-
-    ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0] = VG_LITE_STATE(address);
-    ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[1] = data;
-
-    CMDBUF_OFFSET(*context) += 8;
-
-    return VG_LITE_SUCCESS;
+    return push_state(context, address, *(uint32_t *) data_ptr);
 }
 
 /* Push a "call" command into the current command buffer. */
@@ -4427,6 +4979,9 @@ static vg_lite_error_t push_states(vg_lite_context_t * context, uint32_t address
     /* Reserve enough space in the command buffer for flush and submit */
     if (CMDBUF_OFFSET(*context) + 40 + VG_LITE_ALIGN(count + 1, 2) * 4 >= CMDBUF_SIZE(*context)) {
         uint32_t cmd_count = 0,start_offset = 0;
+        /* A command list can not be split across buffers. */
+        if (context->recording != NULL)
+            return VG_LITE_OUT_OF_RESOURCES;
         context->end_offset = CMDBUF_OFFSET(*context);
         start_offset = context->start_offset;
         VG_LITE_RETURN_ERROR(flush(context));
@@ -4447,10 +5002,11 @@ static vg_lite_error_t push_states(vg_lite_context_t * context, uint32_t address
         /* update start offset */
         context->start_offset = CMDBUF_OFFSET(*context);
 
-        index = (command_id? 0 : 1);
+        index = CMDBUF_PREV_INDEX(*context);
         command_buffer_copy((void *)(CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)), (void *)(context->command_buffer[index] + start_offset),
                 start_offset, context->end_offset, &cmd_count);
         CMDBUF_OFFSET(*context) += cmd_count;
+        replay_state_shadow(context);
     }
 
     ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0] = VG_LITE_STATES(count, address);
@@ -4492,6 +5048,7 @@ static vg_lite_error_t push_states(vg_lite_context_t * context, uint32_t address
 #endif
 
     CMDBUF_OFFSET(*context) += VG_LITE_ALIGN(count + 1, 2) * 4;
+    state_written(context, address, count, data, CMDBUF_OFFSET(*context) - VG_LITE_ALIGN(count + 1, 2) * 4);
 
     return VG_LITE_SUCCESS;
 }
@@ -4503,6 +5060,8 @@ static vg_lite_error_t push_state(vg_lite_context_t * context, uint32_t address,
     uint32_t command_id, index;
     if (!has_valid_command_buffer(context))
         return VG_LITE_NO_CONTEXT;
+    if (state_shadow_hit(context, address, data))
+        return VG_LITE_SUCCESS;
 
     command_id = CMDBUF_INDEX(*context);
     if(CMDBUF_IN_QUEUE(&context->context, command_id))
@@ -4511,6 +5070,9 @@ static vg_lite_error_t push_state(vg_lite_context_t * context, uint32_t address,
     /* Reserve enough space in the command buffer for flush and submit */
     if (CMDBUF_OFFSET(*context) + 56 >= CMDBUF_SIZE(*context)) {
         uint32_t cmd_count = 0,start_offset = 0;
+        /* A command list can not be split across buffers. */
+        if (context->recording != NULL)
+            return VG_LITE_OUT_OF_RESOURCES;
         context->end_offset = CMDBUF_OFFSET(*context);
         start_offset = context->start_offset;
         VG_LITE_RETURN_ERROR(flush(context));
@@ -4531,12 +5093,16 @@ static vg_lite_error_t push_state(vg_lite_context_t * context, uint32_t address,
         /* update start offset */
         context->start_offset = CMDBUF_OFFSET(*context);
 
-        index = (command_id? 0 : 1);
+        index = CMDBUF_PREV_INDEX(*context);
         command_buffer_copy((void *)(CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)), (void *)(context->command_buffer[index] + start_offset),
                 start_offset, context->end_offset, &cmd_count);
         CMDBUF_OFFSET(*context) += cmd_count;
+        replay_state_shadow(context);
     }
 
+    if (append_state(context, address, data))
+        return VG_LITE_SUCCESS;
+
     ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0] = VG_LITE_STATE(address);
     ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[1] = data;
 
@@ -4559,6 +5125,7 @@ static vg_lite_error_t push_state(vg_lite_context_t * context, uint32_t address,
 #endif
 
     CMDBUF_OFFSET(*context) += 8;
+    state_written(context, address, 1, &data, CMDBUF_OFFSET(*context) - 8);
 
     return VG_LITE_SUCCESS;
 }
@@ -4566,68 +5133,7 @@ static vg_lite_error_t push_state(vg_lite_context_t * context, uint32_t address,
 /* Push a single state command with given address. */
 static vg_lite_error_t push_state_ptr(vg_lite_context_t * context, uint32_t address, void * data_ptr)
 {
-    vg_lite_error_t error;
-    uint32_t command_id, index;
-    uint32_t data = *(uint32_t *) data_ptr;
-    if (!has_valid_command_buffer(context))
-        return VG_LITE_NO_CONTEXT;
-
-    command_id = CMDBUF_INDEX(*context);
-    if(CMDBUF_IN_QUEUE(&context->context, command_id))
-        VG_LITE_RETURN_ERROR(stall(context, 0));
-
-    /* Reserve enough space in the command buffer for flush and submit */
-    if (CMDBUF_OFFSET(*context) + 56 >= CMDBUF_SIZE(*context)) {
-        uint32_t cmd_count = 0,start_offset = 0;
-        context->end_offset = CMDBUF_OFFSET(*context);
-        start_offset = context->start_offset;
-        VG_LITE_RETURN_ERROR(flush(context));
-        VG_LITE_RETURN_ERROR(submit(context));
-        CMDBUF_SWAP(*context);
-        command_id = CMDBUF_INDEX(*context);
-        if(CMDBUF_IN_QUEUE(&context->context, command_id))
-            VG_LITE_RETURN_ERROR(stall(context, 0));
-
-        RESERVE_BYTES_IN_CMDBUF(*context);
-
-        if(context->ts_init){
-            memcpy(CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context), context->ts_record, 80);
-            CMDBUF_OFFSET(*context) += 80;
-            context->ts_init_used = 1;
-        }
-
-        /* update start offset */
-        context->start_offset = CMDBUF_OFFSET(*context);
-
-        index = (command_id? 0 : 1);
-        command_buffer_copy((void *)(CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)), (void *)(context->command_buffer[index] + start_offset),
-                start_offset, context->end_offset, &cmd_count);
-        CMDBUF_OFFSET(*context) += cmd_count;
-    }
-
-    ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0] = VG_LITE_STATE(address);
-    ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[1] = data;
-
-#if DUMP_COMMAND
-    if (strncmp(filename, "Commandbuffer", 13)) {
-        sprintf(filename, "Commandbuffer_pid%d.txt", getpid());
-    }
-
-    fp = fopen(filename, "a");
-
-    if (fp == NULL)
-        printf("error!\n");
-    fprintf(fp, "Command buffer: 0x%08x, 0x%08x,\n",
-            ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0],
-            ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[1]);
-
-    fclose(fp);
-    fp = NULL;
-#endif
-
-    CMDBUF_OFFSET(*context) += 8;
-
-    return VG_LITE_SUCCESS;
+    return push_state(context, address, *(uint32_t *) data_ptr);
 }
 
 /* Push a "call" command into the current command buffer. */
@@ -4645,6 +5151,9 @@ static vg_lite_error_t push_call(vg_lite_context_t * context, uint32_t address,
     /* Reserve enough space in the command buffer for flush and submit */
     if (CMDBUF_OFFSET(*context) + 56 >= CMDBUF_SIZE(*context)) {
         uint32_t cmd_count = 0,start_offset = 0;
+        /* A command list can not be split across buffers. */
+        if (context->recording != NULL)
+            return VG_LITE_OUT_OF_RESOURCES;
         context->end_offset = CMDBUF_OFFSET(*context);
         start_offset = context->start_offset;
         VG_LITE_RETURN_ERROR(flush(context));
@@ -4665,10 +5174,11 @@ static vg_lite_error_t push_call(vg_lite_context_t * context, uint32_t address,
         /* update start offset */
         context->start_offset = CMDBUF_OFFSET(*context);
 
-        index = (command_id? 0 : 1);
+        index = CMDBUF_PREV_INDEX(*context);
         command_buffer_copy((void *)(CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)), (void *)(context->command_buffer[index] + start_offset),
                 start_offset, context->end_offset, &cmd_count);
         CMDBUF_OFFSET(*context) += cmd_count;
+        replay_state_shadow(context);
     }
 
     ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0] = VG_LITE_CALL((bytes + 7) / 8);
@@ -4711,6 +5221,9 @@ static vg_lite_error_t push_rectangle(vg_lite_context_t * context, int x, int y,
     /* Reserve enough space in the command buffer for flush and submit */
     if (CMDBUF_OFFSET(*context) + 56 >= CMDBUF_SIZE(*context)) {
         uint32_t cmd_count = 0,start_offset = 0;
+        /* A command list can not be split across buffers. */
+        if (context->recording != NULL)
+            return VG_LITE_OUT_OF_RESOURCES;
         context->end_offset = CMDBUF_OFFSET(*context);
         start_offset = context->start_offset;
         VG_LITE_RETURN_ERROR(flush(context));
@@ -4731,10 +5244,11 @@ static vg_lite_error_t push_rectangle(vg_lite_context_t * context, int x, int y,
         /* update start offset */
         context->start_offset = CMDBUF_OFFSET(*context);
 
-        index = (command_id? 0 : 1);
+        index = CMDBUF_PREV_INDEX(*context);
         command_buffer_copy((void *)(CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)), (void *)(context->command_buffer[index] + start_offset),
                start_offset, context->end_offset, &cmd_count);
         CMDBUF_OFFSET(*context) += cmd_count;
+        replay_state_shadow(context);
     }
 
     ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0] = VG_LITE_DATA(1);
@@ -4789,6 +5303,9 @@ static vg_lite_error_t push_data(vg_lite_context_t * context, int size, void * d
     /* Reserve enough space in the command buffer for flush and submit */
     if (CMDBUF_OFFSET(*context) + 48 + bytes >= CMDBUF_SIZE(*context)) {
         uint32_t cmd_count = 0,start_offset = 0;
+        /* A command list can not be split across buffers. */
+        if (context->recording != NULL)
+            return VG_LITE_OUT_OF_RESOURCES;
         context->end_offset = CMDBUF_OFFSET(*context);
         start_offset = context->start_offset;
         VG_LITE_RETURN_ERROR(flush(context));
@@ -4808,10 +5325,11 @@ static vg_lite_error_t push_data(vg_lite_context_t * context, int size, void * d
 
         /* update start offset */
         context->start_offset = CMDBUF_OFFSET(*context);
-        index = (command_id? 0 : 1);
+        index = CMDBUF_PREV_INDEX(*context);
         command_buffer_copy((void *)(CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)), (void *)(context->command_buffer[index] + start_offset),
                 start_offset, context->end_offset, &cmd_count);
         CMDBUF_OFFSET(*context) += cmd_count;
+        replay_state_shadow(context);
     }
 
     ((uint64_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[(bytes / 8)] = 0;
@@ -4865,6 +5383,9 @@ static vg_lite_error_t push_stall(vg_lite_context_t * context, uint32_t module)
     /* Reserve enough space in the command buffer for flush and submit */
     if (CMDBUF_OFFSET(*context) + 56 >= CMDBUF_SIZE(*context)) {
         uint32_t cmd_count = 0,start_offset = 0;
+        /* A command list can not be split across buffers. */
+        if (context->recording != NULL)
+            return VG_LITE_OUT_OF_RESOURCES;
         context->end_offset = CMDBUF_OFFSET(*context);
         start_offset = context->start_offset;
         VG_LITE_RETURN_ERROR(flush(context));
@@ -4885,10 +5406,11 @@ static vg_lite_error_t push_stall(vg_lite_context_t * context, uint32_t module)
         /* update start offset */
         context->start_offset = CMDBUF_OFFSET(*context);
 
-        index = (command_id? 0 : 1);
+        index = CMDBUF_PREV_INDEX(*context);
         command_buffer_copy((void *)(CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)), (void *)(context->command_buffer[index] + start_offset),
                 start_offset, context->end_offset, &cmd_count);
         CMDBUF_OFFSET(*context) += cmd_count;
+        replay_state_shadow(context);
     }
 
     ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0] = VG_LITE_SEMAPHORE(module);
@@ -4985,6 +5507,14 @@ static vg_lite_error_t submit(vg_lite_context_t *context)
     /* Append END command into the command buffer. */
     ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[0] = VG_LITE_END(0);
     ((uint32_t *) (CMDBUF_BUFFER(*context) + CMDBUF_OFFSET(*context)))[1] = 0;
+#if VG_STATE_SHADOW
+    /* Other contexts may run before the next command buffer. */
+    memcpy(context->state_shadow_replay, context->state_shadow_valid, sizeof(context->state_shadow_replay));
+    reset_state_shadow(context);
+#endif /* VG_STATE_SHADOW */
+#if VG_STALL_ELISION
+    context->tessellation_idle = 0;
+#endif /* VG_STALL_ELISION */
 
 #if DUMP_COMMAND
     if (strncmp(filename, "Commandbuffer", 13)) {
@@ -5024,6 +5554,8 @@ static vg_lite_error_t submit(vg_lite_context_t *context)
     VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_SUBMIT, &submit));
 #if defined(VG_DRIVER_SINGLE_THREAD)
     submit_flag = 1;
+#else
+    context->command_serial[CMDBUF_INDEX(*context)] = ++context->submit_serial;
 #endif /* VG_DRIVER_SINGLE_THREAD */
 
     vglitemDUMP_BUFFER("command", (unsigned int)CMDBUF_BUFFER(*context),
@@ -5064,6 +5596,41 @@ static vg_lite_error_t stall(vg_lite_context_t *context, uint32_t time_ms)
     return VG_LITE_SUCCESS;
 }
 
+#if !defined(VG_DRIVER_SINGLE_THREAD)
+/* Check whether any command buffer of the ring is still queued or executing. */
+static int has_queued_command_buffer(vg_lite_context_t *context)
+{
+    uint32_t i;
+
+    for (i = 0; i < CMDBUF_COUNT; i++) {
+        if (CMDBUF_IN_QUEUE(&context->context, i))
+            return 1;
+    }
+
+    return 0;
+}
+
+/* Wait for all submitted command buffers, oldest first. */
+static vg_lite_error_t stall_all(vg_lite_context_t *context)
+{
+    vg_lite_error_t error;
+    vg_lite_kernel_wait_t wait;
+    uint32_t i, id;
+
+    wait.context = &context->context;
+    wait.timeout_ms = VG_LITE_MAX_WAIT_TIME;
+    for (i = 1; i <= CMDBUF_COUNT; i++) {
+        id = (context->command_buffer_current + i) % CMDBUF_COUNT;
+        if (CMDBUF_IN_QUEUE(&context->context, id)) {
+            wait.command_id = id;
+            VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_WAIT, &wait));
+        }
+    }
+
+    return VG_LITE_SUCCESS;
+}
+#endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
+
 /* Get the inversion of a matrix. */
 VG_LITE_OPTIMIZE(LOW) static int inverse(vg_lite_matrix_t * result, vg_lite_matrix_t * matrix)
 {
@@ -5150,6 +5717,39 @@ static int transform(vg_lite_point_t * result, vg_lite_float_t x, vg_lite_float_
     return 1;
 }
 
+vg_lite_error_t vg_lite_get_path_bounds(vg_lite_path_t *path, vg_lite_matrix_t *matrix, vg_lite_rectangle_t *bounds)
+{
+    vg_lite_point_t point_min, point_max, temp;
+    int i;
+
+    if (path == NULL || bounds == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    /* Same corners as vg_lite_draw. */
+    if (!transform(&point_min, (vg_lite_float_t)path->bounding_box[0], (vg_lite_float_t)path->bounding_box[1], matrix))
+        return VG_LITE_INVALID_ARGUMENT;
+    point_max = point_min;
+
+    for (i = 1; i < 4; i++) {
+        if (!transform(&temp, (vg_lite_float_t)path->bounding_box[(i == 1 || i == 2) ? 2 : 0],
+                       (vg_lite_float_t)path->bounding_box[(i >= 2) ? 3 : 1], matrix))
+            return VG_LITE_INVALID_ARGUMENT;
+
+        if (temp.x < point_min.x) point_min.x = temp.x;
+        if (temp.y < point_min.y) point_min.y = temp.y;
+        if (temp.x > point_max.x) point_max.x = temp.x;
+        if (temp.y > point_max.y) point_max.y = temp.y;
+    }
+
+    /* transform() truncates, grow by a pixel on every side. */
+    bounds->x      = point_min.x - 1;
+    bounds->y      = point_min.y - 1;
+    bounds->width  = point_max.x - point_min.x + 3;
+    bounds->height = point_max.y - point_min.y + 3;
+
+    return VG_LITE_SUCCESS;
+}
+
 /*!
  Flush specific VG module.
  */
@@ -5177,6 +5777,51 @@ static vg_lite_error_t flush_target()
     return error;
 }
 
+/* Flush at the end of a draw. With stall elision the flush waits for the whole pipeline, which is the
+   stall the next tessellation needs, so that one can be skipped. */
+static vg_lite_error_t flush_draw(vg_lite_context_t *ctx)
+{
+#if VG_STALL_ELISION
+    vg_lite_error_t error;
+
+    if (!ctx->stall_elision_off) {
+        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A1B, 0x00000001));
+        VG_LITE_RETURN_ERROR(push_stall(ctx, 15));
+        ctx->tessellation_idle = 1;
+        return VG_LITE_SUCCESS;
+    }
+#endif /* VG_STALL_ELISION */
+
+    return flush_target();
+}
+
+/* Add a patch table entry for the command being recorded; color_offset locates its color word, 0 if it has none. */
+static vg_lite_error_t add_command_list_entry(vg_lite_context_t *ctx, uint32_t color_offset, uint32_t luminance)
+{
+    vg_lite_command_list_t *list = ctx->recording;
+    vg_lite_command_list_entry_t *entries;
+
+    if (list->entry_count == list->entry_capacity) {
+        entries = (vg_lite_command_list_entry_t *)vg_lite_os_malloc((list->entry_capacity + 8) * sizeof(*entries));
+        if (entries == NULL)
+            return VG_LITE_OUT_OF_MEMORY;
+        if (list->entries != NULL) {
+            memcpy(entries, list->entries, list->entry_count * sizeof(*entries));
+            vg_lite_os_free(list->entries);
+        }
+        list->entries = entries;
+        list->entry_capacity += 8;
+    }
+
+    list->entries[list->entry_count].color_offset = color_offset;
+    list->entries[list->entry_count].matrix_offset = 0;
+    list->entries[list->entry_count].stroke_color_offset = 0;
+    list->entries[list->entry_count].luminance = luminance;
+    list->entry_count++;
+
+    return VG_LITE_SUCCESS;
+}
+
 /****************** FAST_CLEAR feature implementation. ***************/
 #if VG_TARGET_FAST_CLEAR
 static vg_lite_error_t convert_color(vg_lite_buffer_format_t format, uint32_t value, uint32_t *result, int *bpp)
@@ -6093,6 +6738,9 @@ vg_lite_error_t vg_lite_clear(vg_lite_buffer_t * target,
         } else {
             VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A00, 0x10000001));
         }
+        if (ctx->recording != NULL) {
+            VG_LITE_RETURN_ERROR(add_command_list_entry(ctx, CMDBUF_OFFSET(*ctx) + 4, target->format == VG_LITE_L8));
+        }
         VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, color32));
         VG_LITE_RETURN_ERROR(push_rectangle(ctx, x, y, width, height));
         VG_LITE_RETURN_ERROR(flush_target());
@@ -6278,6 +6926,9 @@ vg_lite_error_t vg_lite_blit(vg_lite_buffer_t * target,
         /* enable pre-multiplied from VG to VGPE */
         VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A00, 0x00000001 | imageMode | blend_mode | transparency_mode));
     }
+    if (ctx->recording != NULL) {
+        VG_LITE_RETURN_ERROR(add_command_list_entry(ctx, CMDBUF_OFFSET(*ctx) + 4, 0));
+    }
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, color));
     VG_LITE_RETURN_ERROR(set_interpolation_steps(target, source->width, source->height, matrix));
 
@@ -6522,6 +7173,9 @@ vg_lite_error_t vg_lite_blit_rect(vg_lite_buffer_t * target,
         /* enable pre-multiplied from VG to VGPE */
         VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A00, 0x00000001 | imageMode | blend_mode | transparency_mode));
     }
+    if (ctx->recording != NULL) {
+        VG_LITE_RETURN_ERROR(add_command_list_entry(ctx, CMDBUF_OFFSET(*ctx) + 4, 0));
+    }
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, color));
 
     VG_LITE_RETURN_ERROR(set_interpolation_steps(target, rect_w, rect_h, matrix));
@@ -6604,6 +7258,7 @@ vg_lite_error_t vg_lite_init(int32_t tessellation_width,
 {
     vg_lite_error_t error;
     vg_lite_kernel_initialize_t initialize;
+    uint32_t i;
 
     s_context.rtbuffer = (vg_lite_buffer_t *)malloc(sizeof(vg_lite_buffer_t));
     if(!s_context.rtbuffer)
@@ -6639,11 +7294,11 @@ vg_lite_error_t vg_lite_init(int32_t tessellation_width,
 
     /* Save draw context. */
     s_context.capabilities = initialize.capabilities;
-    s_context.command_buffer[0] = (uint8_t *)initialize.command_buffer[0];
-    s_context.command_buffer[1] = (uint8_t *)initialize.command_buffer[1];
+    for (i = 0; i < CMDBUF_COUNT; i++) {
+        s_context.command_buffer[i] = (uint8_t *)initialize.command_buffer[i];
+        s_context.command_offset[i] = 0;
+    }
     s_context.command_buffer_size = initialize.command_buffer_size;
-    s_context.command_offset[0] = 0;
-    s_context.command_offset[1] = 0;
 
     if ((tessellation_width  > 0) &&
         (tessellation_height > 0))
@@ -6700,6 +7355,7 @@ vg_lite_error_t vg_lite_init(int32_t tessellation_width,
     vg_lite_error_t error;
     vg_lite_kernel_initialize_t initialize;
     vg_lite_tls_t* task_tls;
+    uint32_t i;
 
     task_tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
     if(task_tls)
@@ -6735,17 +7391,15 @@ vg_lite_error_t vg_lite_init(int32_t tessellation_width,
 
     /* Save draw context. */
     task_tls->t_context.capabilities = initialize.capabilities;
-    task_tls->t_context.command_buffer[0] = (uint8_t *)initialize.command_buffer[0];
-    task_tls->t_context.command_buffer[1] = (uint8_t *)initialize.command_buffer[1];
+    for (i = 0; i < CMDBUF_COUNT; i++) {
+        task_tls->t_context.command_buffer[i] = (uint8_t *)initialize.command_buffer[i];
+        task_tls->t_context.command_offset[i] = 0;
+        task_tls->t_context.context_buffer[i] = (uint8_t *)initialize.context_buffer[i];
+        task_tls->t_context.context_buffer_offset[i] = 0;
+    }
     task_tls->t_context.command_buffer_size = initialize.command_buffer_size;
-    task_tls->t_context.command_offset[0] = 0;
-    task_tls->t_context.command_offset[1] = 0;
     task_tls->t_context.command_buffer_current = 0;
-    task_tls->t_context.context_buffer[0] = (uint8_t *)initialize.context_buffer[0];
-    task_tls->t_context.context_buffer[1] = (uint8_t *)initialize.context_buffer[1];
     task_tls->t_context.context_buffer_size = initialize.context_buffer_size;
-    task_tls->t_context.context_buffer_offset[0] = 0;
-    task_tls->t_context.context_buffer_offset[1] = 0;
     task_tls->t_context.start_offset = 0;
     task_tls->t_context.end_offset = 0;
     task_tls->t_context.ts_init = 0;
@@ -6814,6 +7468,238 @@ vg_lite_error_t vg_lite_set_draw_path_type(vg_lite_path_t * path,vg_lite_draw_pa
     return VG_LITE_SUCCESS;
 }
 
+/* Free the GPU copy of a cached path once no submitted draw calls it any more. */
+static vg_lite_error_t _path_cache_release(vg_lite_context_t *ctx, vg_lite_path_cache_entry_t *entry)
+{
+    vg_lite_error_t error;
+    vg_lite_kernel_free_t free_cmd;
+
+    if (entry->handle != NULL) {
+        VG_LITE_RETURN_ERROR(vg_lite_fence_wait(&entry->fence, VG_LITE_FENCE_INFINITE));
+
+        free_cmd.memory_handle = entry->handle;
+        VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_FREE, &free_cmd));
+        ctx->path_cache_bytes -= entry->bytes;
+    }
+    memset(entry, 0, sizeof(*entry));
+
+    return VG_LITE_SUCCESS;
+}
+
+/* Release the least recently used GPU copy other than keep, if there is one. */
+static vg_lite_error_t _path_cache_evict(vg_lite_context_t *ctx, vg_lite_path_cache_entry_t *keep, uint8_t *evicted)
+{
+    vg_lite_path_cache_entry_t *entry, *lru = NULL, saved;
+    vg_lite_error_t error;
+
+    *evicted = 0;
+    for (entry = ctx->path_cache; entry < ctx->path_cache + VG_PATH_CACHE_ENTRIES; entry++) {
+        if (entry != keep && entry->handle != NULL && (lru == NULL || entry->last_use < lru->last_use))
+            lru = entry;
+    }
+    if (lru == NULL)
+        return VG_LITE_SUCCESS;
+
+    /* Keep counting draws of the path, it is uploaded again when memory allows. The path itself is not
+       read, the application may have freed it since its last draw. */
+    saved = *lru;
+    VG_LITE_RETURN_ERROR(_path_cache_release(ctx, lru));
+    ctx->path_cache_evictions++;
+    lru->path = saved.path;
+    lru->data = saved.data;
+    lru->length = saved.length;
+    lru->draws = saved.draws;
+    lru->last_use = saved.last_use;
+    *evicted = 1;
+
+    return VG_LITE_SUCCESS;
+}
+
+static vg_lite_error_t _path_cache_upload(vg_lite_context_t *ctx, vg_lite_path_cache_entry_t *entry, vg_lite_path_t *path)
+{
+    vg_lite_error_t error;
+    vg_lite_kernel_allocate_t allocate;
+    uint32_t *memory;
+    uint32_t bytes;
+    uint8_t evicted;
+
+    /* Same layout as vg_lite_upload_path. */
+    bytes = (8 + path->path_length + 7 + 8) & ~7;
+    if (bytes > VG_PATH_CACHE_SIZE)
+        return VG_LITE_OUT_OF_RESOURCES;
+
+    while (ctx->path_cache_bytes + bytes > VG_PATH_CACHE_SIZE) {
+        VG_LITE_RETURN_ERROR(_path_cache_evict(ctx, entry, &evicted));
+        if (!evicted)
+            return VG_LITE_OUT_OF_RESOURCES;
+    }
+
+    allocate.bytes = bytes;
+    allocate.contiguous = 1;
+    while ((error = vg_lite_kernel(VG_LITE_ALLOCATE, &allocate)) != VG_LITE_SUCCESS) {
+        /* Make room in GPU memory by dropping older copies. */
+        VG_LITE_RETURN_ERROR(_path_cache_evict(ctx, entry, &evicted));
+        if (!evicted)
+            return error;
+    }
+
+    memory = (uint32_t *)allocate.memory;
+    memory[0] = 0x40000000 | ((path->path_length + 7) / 8);
+    memory[1] = 0;
+    memcpy(memory + 2, path->path, path->path_length);
+    memory[bytes / 4 - 2] = 0x70000000;
+    memory[bytes / 4 - 1] = 0;
+
+    entry->handle = allocate.memory_handle;
+    entry->address = allocate.memory_gpu;
+    entry->bytes = bytes;
+    ctx->path_cache_bytes += bytes;
+    ctx->path_cache_uploads++;
+
+    return VG_LITE_SUCCESS;
+}
+
+/* Count a fill draw of a path that was not uploaded by the application. Returns the cache entry with the
+   GPU copy of the path to call, or NULL if the path data is copied into the command buffer. */
+static vg_lite_error_t _path_cache_lookup(vg_lite_context_t *ctx, vg_lite_path_t *path, vg_lite_path_cache_entry_t **cached)
+{
+    vg_lite_error_t error;
+    vg_lite_path_cache_entry_t *entry, *found = NULL, *lru = NULL;
+
+    *cached = NULL;
+    if (VG_PATH_CACHE_SIZE == 0 || ctx->recording != NULL)
+        return VG_LITE_SUCCESS;
+
+    for (entry = ctx->path_cache; entry < ctx->path_cache + VG_PATH_CACHE_ENTRIES; entry++) {
+        if (entry->path == path) {
+            found = entry;
+            break;
+        }
+        if (lru == NULL || entry->path == NULL || (lru->path != NULL && entry->last_use < lru->last_use))
+            lru = entry;
+    }
+
+    if (found == NULL) {
+        found = lru;
+        if (found->handle != NULL)
+            ctx->path_cache_evictions++;
+        VG_LITE_RETURN_ERROR(_path_cache_release(ctx, found));
+    }
+    else if (path->path_changed || found->data != path->path || found->length != path->path_length) {
+        /* The path changed since it was counted or uploaded, start over. */
+        VG_LITE_RETURN_ERROR(_path_cache_release(ctx, found));
+    }
+    path->path_changed = 0;
+
+    found->path = path;
+    found->data = path->path;
+    found->length = path->path_length;
+    found->draws++;
+    found->last_use = ++ctx->path_cache_clock;
+
+    if (found->handle != NULL) {
+        ctx->path_cache_hits++;
+        *cached = found;
+        return VG_LITE_SUCCESS;
+    }
+
+    ctx->path_cache_misses++;
+    if (found->draws >= VG_PATH_CACHE_HOT && _path_cache_upload(ctx, found, path) == VG_LITE_SUCCESS)
+        *cached = found;
+
+    return VG_LITE_SUCCESS;
+}
+
+/* Drop the cache entry of a path, e.g. before it is cleared. */
+static void _path_cache_forget(vg_lite_path_t *path)
+{
+    vg_lite_path_cache_entry_t *entry;
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    vg_lite_context_t *ctx = &s_context;
+
+    if (!s_context.init)
+        return;
+#else
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t *tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return;
+
+    ctx = &tls->t_context;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+
+    for (entry = ctx->path_cache; entry < ctx->path_cache + VG_PATH_CACHE_ENTRIES; entry++) {
+        if (entry->path == path)
+            _path_cache_release(ctx, entry);
+    }
+}
+
+/* Stall the pipeline before a tessellation overwrites the tessellation buffer, unless no tessellation
+   was pushed since the end of a draw or vg_lite_finish drained the pipeline. */
+static vg_lite_error_t push_tessellation_stall(vg_lite_context_t *ctx)
+{
+#if VG_STALL_ELISION
+    if (ctx->tessellation_idle && !ctx->stall_elision_off) {
+        ctx->tessellation_idle = 0;
+        return VG_LITE_SUCCESS;
+    }
+    ctx->tessellation_idle = 0;
+#endif /* VG_STALL_ELISION */
+
+    return push_stall(ctx, 15);
+}
+
+/* Target area a path drawn with matrix can touch, clipped to the target and the scissor rectangle. */
+static void _get_draw_bounds(vg_lite_context_t *ctx, vg_lite_buffer_t *target, vg_lite_path_t *path,
+                             vg_lite_matrix_t *matrix, int32_t dst_align_width, uint8_t fullscreen,
+                             vg_lite_point_t *point_min, vg_lite_point_t *point_max)
+{
+    vg_lite_point_t temp = {0};
+
+    if (fullscreen) {
+        point_min->x = 0;
+        point_min->y = 0;
+        point_max->x = dst_align_width;
+        point_max->y = target->height;
+    }
+    else {
+        transform(&temp, (vg_lite_float_t)path->bounding_box[0], (vg_lite_float_t)path->bounding_box[1], matrix);
+        *point_min = *point_max = temp;
+
+        transform(&temp, (vg_lite_float_t)path->bounding_box[2], (vg_lite_float_t)path->bounding_box[1], matrix);
+        if (temp.x < point_min->x) point_min->x = temp.x;
+        if (temp.y < point_min->y) point_min->y = temp.y;
+        if (temp.x > point_max->x) point_max->x = temp.x;
+        if (temp.y > point_max->y) point_max->y = temp.y;
+
+        transform(&temp, (vg_lite_float_t)path->bounding_box[2], (vg_lite_float_t)path->bounding_box[3], matrix);
+        if (temp.x < point_min->x) point_min->x = temp.x;
+        if (temp.y < point_min->y) point_min->y = temp.y;
+        if (temp.x > point_max->x) point_max->x = temp.x;
+        if (temp.y > point_max->y) point_max->y = temp.y;
+
+        transform(&temp, (vg_lite_float_t)path->bounding_box[0], (vg_lite_float_t)path->bounding_box[3], matrix);
+        if (temp.x < point_min->x) point_min->x = temp.x;
+        if (temp.y < point_min->y) point_min->y = temp.y;
+        if (temp.x > point_max->x) point_max->x = temp.x;
+        if (temp.y > point_max->y) point_max->y = temp.y;
+
+        if (point_min->x < 0) point_min->x = 0;
+        if (point_min->y < 0) point_min->y = 0;
+        if (point_max->x > dst_align_width) point_max->x = dst_align_width;
+        if (point_max->y > target->height) point_max->y = target->height;
+    }
+
+    if (ctx->scissor_enabled) {
+        point_min->x = MAX(point_min->x, ctx->scissor[0]);
+        point_min->y = MAX(point_min->y, ctx->scissor[1]);
+        point_max->x = MIN(point_max->x, ctx->scissor[0] + ctx->scissor[2]);
+        point_max->y = MIN(point_max->y, ctx->scissor[1] + ctx->scissor[3]);
+    }
+}
+
 vg_lite_error_t vg_lite_draw(vg_lite_buffer_t * target,
                              vg_lite_path_t * path,
                              vg_lite_fill_t fill_rule,
@@ -6825,7 +7711,7 @@ vg_lite_error_t vg_lite_draw(vg_lite_buffer_t * target,
     uint32_t format, quality, tiling, fill;
     uint32_t tessellation_size;
     vg_lite_error_t error;
-    vg_lite_point_t point_min = {0}, point_max = {0}, temp = {0};
+    vg_lite_point_t point_min = {0}, point_max = {0};
     int x, y, width, height;
     uint8_t ts_is_fullscreen = 0;
 #if DUMP_COMMAND
@@ -6834,6 +7720,7 @@ vg_lite_error_t vg_lite_draw(vg_lite_buffer_t * target,
 #endif
     int32_t dst_align_width;
     uint32_t mul, div, align;
+    vg_lite_path_cache_entry_t *cached = NULL;
 #if defined(VG_DRIVER_SINGLE_THREAD)
     vg_lite_context_t *ctx = &s_context;
 #else
@@ -6860,63 +7747,10 @@ vg_lite_error_t vg_lite_draw(vg_lite_buffer_t * target,
         return VG_LITE_NOT_SUPPORT;
     }
 
-    error = set_render_target(target);
-    if (error != VG_LITE_SUCCESS) {
-        return error;
-    } else if (error == VG_LITE_NO_CONTEXT) {
-        /* If scissoring is enabled and no valid scissoring rectangles
-           are present, no drawing occurs */
-        return VG_LITE_SUCCESS;
-    }
-
-    width = ctx->tsbuffer.tessellation_width_height & 0xFFFF;
-    height = ctx->tsbuffer.tessellation_width_height >> 16;
-    get_format_bytes(target->format, &mul, &div, &align);
-    dst_align_width = target->stride * div / mul;
-    if(width == 0 || height == 0)
-        return VG_LITE_NO_CONTEXT;
-    if ((dst_align_width <= width) && (target->height <= height))
-    {
-        ts_is_fullscreen = 1;
-        point_min.x = 0;
-        point_min.y = 0;
-        point_max.x = dst_align_width;
-        point_max.y = target->height;
-    }
-
-    if (ts_is_fullscreen == 0){
-        transform(&temp, (vg_lite_float_t)path->bounding_box[0], (vg_lite_float_t)path->bounding_box[1], matrix);
-        point_min = point_max = temp;
-
-        transform(&temp, (vg_lite_float_t)path->bounding_box[2], (vg_lite_float_t)path->bounding_box[1], matrix);
-        if (temp.x < point_min.x) point_min.x = temp.x;
-        if (temp.y < point_min.y) point_min.y = temp.y;
-        if (temp.x > point_max.x) point_max.x = temp.x;
-        if (temp.y > point_max.y) point_max.y = temp.y;
-
-        transform(&temp, (vg_lite_float_t)path->bounding_box[2], (vg_lite_float_t)path->bounding_box[3], matrix);
-        if (temp.x < point_min.x) point_min.x = temp.x;
-        if (temp.y < point_min.y) point_min.y = temp.y;
-        if (temp.x > point_max.x) point_max.x = temp.x;
-        if (temp.y > point_max.y) point_max.y = temp.y;
-
-        transform(&temp, (vg_lite_float_t)path->bounding_box[0], (vg_lite_float_t)path->bounding_box[3], matrix);
-        if (temp.x < point_min.x) point_min.x = temp.x;
-        if (temp.y < point_min.y) point_min.y = temp.y;
-        if (temp.x > point_max.x) point_max.x = temp.x;
-        if (temp.y > point_max.y) point_max.y = temp.y;
-
-        if (point_min.x < 0) point_min.x = 0;
-        if (point_min.y < 0) point_min.y = 0;
-        if (point_max.x > dst_align_width) point_max.x = dst_align_width;
-        if (point_max.y > target->height) point_max.y = target->height;
-    }
-
-    if (ctx->scissor_enabled) {
-        point_min.x = MAX(point_min.x, ctx->scissor[0]);
-        point_min.y = MAX(point_min.y, ctx->scissor[1]);
-        point_max.x = MIN(point_max.x, ctx->scissor[0] + ctx->scissor[2]);
-        point_max.y = MIN(point_max.y, ctx->scissor[1] + ctx->scissor[3]);
+    /* Paths the application did not upload are uploaded by the driver once they are reused. This may
+       flush, so it happens before any command of the draw is pushed. */
+    if ((path->path_type & 0x1) == VG_LITE_DRAW_FILL_PATH && VLM_PATH_GET_UPLOAD_BIT(*path) == 0) {
+        VG_LITE_RETURN_ERROR(_path_cache_lookup(ctx, path, &cached));
     }
 
     /* Convert states into hardware values. */
@@ -6930,8 +7764,37 @@ vg_lite_error_t vg_lite_draw(vg_lite_buffer_t * target,
                          : ctx->tsbuffer.tessellation_buffer_size[1]
                          );
 
+    error = set_render_target(target);
+    if (error != VG_LITE_SUCCESS) {
+        return error;
+    } else if (error == VG_LITE_NO_CONTEXT) {
+        /* If scissoring is enabled and no valid scissoring rectangles
+           are present, no drawing occurs */
+        return VG_LITE_SUCCESS;
+    }
+
+    width = ctx->tsbuffer.tessellation_width_height & 0xFFFF;
+    height = ctx->tsbuffer.tessellation_width_height >> 16;
+    get_format_bytes(target->format, &mul, &div, &align);
+    dst_align_width = target->stride * div / mul;
+    if(width == 0 || height == 0)
+        return VG_LITE_NO_CONTEXT;
+    if ((dst_align_width <= width) && (target->height <= height))
+        ts_is_fullscreen = 1;
+    _get_draw_bounds(ctx, target, path, matrix, dst_align_width, ts_is_fullscreen, &point_min, &point_max);
+
 #if !defined(VG_DRIVER_SINGLE_THREAD)
-    if(ctx->ts_dirty){
+    if(ctx->recording != NULL){
+        /* A command list carries its own tessellation buffer states, so it can be called from any command buffer. */
+        if(!ctx->recording->tessellation){
+            if (CMDBUF_OFFSET(*ctx) + 80 >= CMDBUF_SIZE(*ctx))
+                return VG_LITE_OUT_OF_RESOURCES;
+            memcpy(CMDBUF_BUFFER(*ctx) + CMDBUF_OFFSET(*ctx), ctx->ts_record, 80);
+            CMDBUF_OFFSET(*ctx) += 80;
+            ctx->recording->tessellation = 1;
+        }
+    }
+    else if(ctx->ts_dirty){
         memcpy(CMDBUF_BUFFER(*ctx) + CMDBUF_OFFSET(*ctx), ctx->ts_record, 80);
         CMDBUF_OFFSET(*ctx) += 80;
         ctx->ts_dirty = 0;
@@ -6950,12 +7813,18 @@ vg_lite_error_t vg_lite_draw(vg_lite_buffer_t * target,
     } else {
         VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A00, 0x10000000 | ctx->capabilities.cap.tiled | blend_mode));
     }
+    if (ctx->recording != NULL) {
+        VG_LITE_RETURN_ERROR(add_command_list_entry(ctx, CMDBUF_OFFSET(*ctx) + 4, 0));
+    }
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, color));
     /* Program tessellation control: for TS module. */
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000200 | format | quality | tiling | fill));
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3B, 0x3F800000));      /* Path tessellation SCALE. */
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3C, 0x00000000));      /* Path tessellation BIAS.  */
     /* Program matrix. */
+    if (ctx->recording != NULL) {
+        ctx->recording->entries[ctx->recording->entry_count - 1].matrix_offset = CMDBUF_OFFSET(*ctx);
+    }
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A40, (void *) &matrix->m[0][0]));
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A41, (void *) &matrix->m[0][1]));
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A42, (void *) &matrix->m[0][2]));
@@ -6972,13 +7841,13 @@ vg_lite_error_t vg_lite_draw(vg_lite_buffer_t * target,
         for (y = point_min.y; y < point_max.y; y += height) {
             for (x = point_min.x; x < point_max.x; x += width) {
                 /* Tessellate path. */
-                VG_LITE_RETURN_ERROR(push_stall(ctx, 15));
+                VG_LITE_RETURN_ERROR(push_tessellation_stall(ctx));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A1B, 0x00011000));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A01, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A39, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3D, tessellation_size / 64));
 
-                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1) {
+                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1 && ctx->recording == NULL) {
                     VG_LITE_RETURN_ERROR(push_call(ctx, path->uploaded.address, path->uploaded.bytes));
 #if  (DUMP_COMMAND)
                     if (strncmp(filename, "Commandbuffer", 13)) {
@@ -7018,25 +7887,36 @@ vg_lite_error_t vg_lite_draw(vg_lite_buffer_t * target,
                     fclose(fp);
                     fp = NULL;
 #endif
+                } else if (cached != NULL) {
+                    VG_LITE_RETURN_ERROR(push_call(ctx, cached->address, cached->bytes));
                 } else {
                         push_data(ctx, path->path_length, path->path);
                 }
             }
         }
+        if (cached != NULL)
+            VG_LITE_RETURN_ERROR(vg_lite_fence_insert(&cached->fence));
     }
     /* Setup tessellation loop. */
     if(path->path_type == VG_LITE_DRAW_STROKE_PATH || path->path_type == VG_LITE_DRAW_FILL_STROKE_PATH) {
+        /* The stroke color is programmed once for all tiles, so a recorded one can be patched in one place. */
+        if (ctx->recording != NULL) {
+            ctx->recording->entries[ctx->recording->entry_count - 1].stroke_color_offset = CMDBUF_OFFSET(*ctx) + 4;
+        }
+        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, path->stroke_color));
         for (y = point_min.y; y < point_max.y; y += height) {
             for (x = point_min.x; x < point_max.x; x += width) {
                 /* Tessellate path. */
-                VG_LITE_RETURN_ERROR(push_stall(ctx, 15));
+                VG_LITE_RETURN_ERROR(push_tessellation_stall(ctx));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A1B, 0x00011000));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A01, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A39, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3D, tessellation_size / 64));
 
-                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1) {
-                    VG_LITE_RETURN_ERROR(push_call(ctx, path->uploaded.address, path->uploaded.bytes));
+                format = convert_path_format(path->stroke_conversion ? path->stroke_conversion->stroke_path_format : VG_LITE_FP32);
+                VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000200 | format | quality | tiling | 0x0));
+                if (path->stroke_conversion != NULL && path->stroke_conversion->uploaded_handle != NULL && ctx->recording == NULL) {
+                    VG_LITE_RETURN_ERROR(push_call(ctx, path->stroke_conversion->uploaded_address, path->stroke_conversion->uploaded_bytes));
 #if  (DUMP_COMMAND)
                     if (strncmp(filename, "Commandbuffer", 13)) {
                         sprintf(filename, "Commandbuffer_pid%d.txt", getpid());
@@ -7076,9 +7956,6 @@ vg_lite_error_t vg_lite_draw(vg_lite_buffer_t * target,
                     fp = NULL;
 #endif
                 } else {
-                        format = convert_path_format(VG_LITE_FP32);
-                        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000200 | format | quality | tiling | 0x0));
-                        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, path->stroke_color));
                         push_data(ctx, path->stroke_path_size, path->stroke_path_data);
                 }
             }
@@ -7087,10 +7964,280 @@ vg_lite_error_t vg_lite_draw(vg_lite_buffer_t * target,
 
     /* Finialize command buffer. */
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0));
-    VG_LITE_RETURN_ERROR(flush_target());
+    VG_LITE_RETURN_ERROR(flush_draw(ctx));
+#if !defined(VG_DRIVER_SINGLE_THREAD)
+    ctx->ts_init = 1;
+#endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
+    return error;
+}
+
+/* GPU copy of a path in the path cache, without counting a draw. */
+static vg_lite_path_cache_entry_t *_path_cache_find(vg_lite_context_t *ctx, vg_lite_path_t *path)
+{
+    vg_lite_path_cache_entry_t *entry;
+
+    for (entry = ctx->path_cache; entry < ctx->path_cache + VG_PATH_CACHE_ENTRIES; entry++) {
+        if (entry->path == path)
+            return (entry->handle != NULL && !path->path_changed && entry->data == path->path &&
+                    entry->length == path->path_length) ? entry : NULL;
+    }
+
+    return NULL;
+}
+
+/* Tessellate one fill or stroke of a batched draw in the current tile. States that are still
+   programmed from the previous path of the batch are not sent again. */
+static vg_lite_error_t _draw_paths_layer(vg_lite_context_t *ctx, vg_lite_draw_item_t *item, uint8_t stroke,
+                                         uint32_t control, uint32_t *last_control, vg_lite_color_t *last_color,
+                                         vg_lite_matrix_t **last_matrix)
+{
+    vg_lite_error_t error;
+    vg_lite_path_t *path = item->path;
+    vg_lite_path_cache_entry_t *cached;
+    vg_lite_color_t color = stroke ? path->stroke_color : item->color;
+
+    /* No state is programmed before the first path, whose control word is never 0. */
+    if (*last_control == 0 || color != *last_color) {
+        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, color));
+        *last_color = color;
+    }
+    if (control != *last_control) {
+        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, control));
+        *last_control = control;
+    }
+    if (*last_matrix == NULL || memcmp(&(*last_matrix)->m[0][0], &item->matrix->m[0][0], sizeof(vg_lite_float_t) * 6) != 0) {
+        VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A40, (void *) &item->matrix->m[0][0]));
+        VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A41, (void *) &item->matrix->m[0][1]));
+        VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A42, (void *) &item->matrix->m[0][2]));
+        VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A43, (void *) &item->matrix->m[1][0]));
+        VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A44, (void *) &item->matrix->m[1][1]));
+        VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A45, (void *) &item->matrix->m[1][2]));
+        *last_matrix = item->matrix;
+    }
+
+    if (stroke) {
+        if (path->stroke_conversion != NULL && path->stroke_conversion->uploaded_handle != NULL)
+            return push_call(ctx, path->stroke_conversion->uploaded_address, path->stroke_conversion->uploaded_bytes);
+        return push_data(ctx, path->stroke_path_size, path->stroke_path_data);
+    }
+
+    if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1)
+        return push_call(ctx, path->uploaded.address, path->uploaded.bytes);
+    cached = _path_cache_find(ctx, path);
+    if (cached != NULL)
+        return push_call(ctx, cached->address, cached->bytes);
+    return push_data(ctx, path->path_length, path->path);
+}
+
+vg_lite_error_t vg_lite_draw_paths(vg_lite_buffer_t * target,
+                                   vg_lite_draw_item_t * items,
+                                   uint32_t count,
+                                   vg_lite_blend_t blend)
+{
+    vg_lite_error_t error = VG_LITE_SUCCESS;
+    vg_lite_path_cache_entry_t *cached;
+    vg_lite_point_t point_min, point_max;
+    vg_lite_matrix_t *last_matrix = NULL;
+    vg_lite_color_t last_color = 0;
+    vg_lite_path_t *path;
+    uint32_t *bins = NULL, *refs = NULL, *ranges = NULL;
+    uint32_t tiles_x, tiles_y, tile, tx, ty, i, k;
+    uint32_t format, quality, tiling, fill, tessellation_size;
+    uint32_t last_control = 0;
+    int32_t dst_align_width, width, height;
+    uint32_t mul, div, align;
+    uint8_t ts_is_fullscreen = 0, tile_started;
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    vg_lite_context_t *ctx = &s_context;
+#else
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t *tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    ctx = &tls->t_context;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+
+    if (items == NULL && count != 0)
+        return VG_LITE_INVALID_ARGUMENT;
+    if (count == 0)
+        return VG_LITE_SUCCESS;
+
+    for (i = 0; i < count; i++) {
+        path = items[i].path;
+        if (path == NULL || items[i].matrix == NULL || (path->path_length && path->path == NULL))
+            return VG_LITE_INVALID_ARGUMENT;
+        if(!vg_lite_query_feature(gcFEATURE_BIT_VG_QUALITY_8X) && path->quality == VG_LITE_UPPER)
+            return VG_LITE_NOT_SUPPORT;
+    }
+
+    /* A command list records every draw on its own. */
+    if (ctx->recording != NULL) {
+        for (i = 0; i < count; i++) {
+            VG_LITE_RETURN_ERROR(vg_lite_draw(target, items[i].path, items[i].fill_rule, items[i].matrix,
+                                              blend, items[i].color));
+        }
+        return VG_LITE_SUCCESS;
+    }
+
+    /* Count the draws for the path cache before any command is pushed, as for vg_lite_draw. */
+    for (i = 0; i < count; i++) {
+        path = items[i].path;
+        if (path->path_length && (path->path_type & 0x1) == VG_LITE_DRAW_FILL_PATH && VLM_PATH_GET_UPLOAD_BIT(*path) == 0)
+            VG_LITE_RETURN_ERROR(_path_cache_lookup(ctx, path, &cached));
+    }
+
+    error = set_render_target(target);
+    if (error != VG_LITE_SUCCESS)
+        return error;
+
+    width = ctx->tsbuffer.tessellation_width_height & 0xFFFF;
+    height = ctx->tsbuffer.tessellation_width_height >> 16;
+    get_format_bytes(target->format, &mul, &div, &align);
+    dst_align_width = target->stride * div / mul;
+    if(width == 0 || height == 0)
+        return VG_LITE_NO_CONTEXT;
+    if ((dst_align_width <= width) && (target->height <= height))
+        ts_is_fullscreen = 1;
+
+    /* Bin the paths into the tessellation tiles their bounds touch. bins[tile] is the start of the
+       tile's path indices in refs, ranges keeps the tile rectangle of every path. */
+    tiles_x = (dst_align_width + width - 1) / width;
+    tiles_y = (target->height + height - 1) / height;
+    bins = (uint32_t *)vg_lite_os_malloc((tiles_x * tiles_y + 1) * sizeof(uint32_t) + count * 4 * sizeof(uint32_t));
+    if (bins == NULL)
+        return VG_LITE_OUT_OF_RESOURCES;
+    memset(bins, 0, (tiles_x * tiles_y + 1) * sizeof(uint32_t));
+    ranges = bins + tiles_x * tiles_y + 1;
+
+    for (i = 0; i < count; i++) {
+        uint32_t *range = ranges + i * 4;
+
+        range[0] = range[1] = range[2] = range[3] = 0;
+        if (!items[i].path->path_length)
+            continue;
+        _get_draw_bounds(ctx, target, items[i].path, items[i].matrix, dst_align_width, ts_is_fullscreen, &point_min, &point_max);
+        if (point_min.x >= point_max.x || point_min.y >= point_max.y)
+            continue;
+
+        /* Tiles [range[0], range[2]) x [range[1], range[3]). */
+        range[0] = point_min.x / width;
+        range[1] = point_min.y / height;
+        range[2] = (point_max.x - 1) / width + 1;
+        range[3] = (point_max.y - 1) / height + 1;
+        for (ty = range[1]; ty < range[3]; ty++)
+            for (tx = range[0]; tx < range[2]; tx++)
+                bins[ty * tiles_x + tx + 1]++;
+    }
+    for (tile = 0; tile < tiles_x * tiles_y; tile++)
+        bins[tile + 1] += bins[tile];
+
+    if (bins[tiles_x * tiles_y] != 0) {
+        refs = (uint32_t *)vg_lite_os_malloc(bins[tiles_x * tiles_y] * sizeof(uint32_t));
+        if (refs == NULL) {
+            vg_lite_os_free(bins);
+            return VG_LITE_OUT_OF_RESOURCES;
+        }
+        /* Paths stay in draw order within a tile. */
+        for (i = 0; i < count; i++) {
+            uint32_t *range = ranges + i * 4;
+
+            for (ty = range[1]; ty < range[3]; ty++)
+                for (tx = range[0]; tx < range[2]; tx++)
+                    refs[bins[ty * tiles_x + tx]++] = i;
+        }
+        /* The fill moved every start to the next tile. */
+        for (tile = tiles_x * tiles_y; tile > 0; tile--)
+            bins[tile] = bins[tile - 1];
+        bins[0] = 0;
+    }
+
+    tiling = (ctx->capabilities.cap.tiled == 2) ? 0x2000000 : 0;
+    tessellation_size = (  ctx->tsbuffer.tessellation_buffer_size[2]
+                         ? ctx->tsbuffer.tessellation_buffer_size[2]
+                         : ctx->tsbuffer.tessellation_buffer_size[1]
+                         );
+
+#if !defined(VG_DRIVER_SINGLE_THREAD)
+    if(ctx->ts_dirty){
+        memcpy(CMDBUF_BUFFER(*ctx) + CMDBUF_OFFSET(*ctx), ctx->ts_record, 80);
+        CMDBUF_OFFSET(*ctx) += 80;
+        ctx->ts_dirty = 0;
+        ctx->ts_init_used = 1;
+    }
+    else
+    {
+        ctx->ts_init_use = 1;
+    }
+#endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
+
+    /* Blend and tessellation scale are shared by all paths. */
+    if(ctx->premultiply_enabled) {
+        VG_LITE_ERROR_HANDLER(push_state(ctx, 0x0A00, ctx->capabilities.cap.tiled | convert_blend(blend)));
+    } else {
+        VG_LITE_ERROR_HANDLER(push_state(ctx, 0x0A00, 0x10000000 | ctx->capabilities.cap.tiled | convert_blend(blend)));
+    }
+    VG_LITE_ERROR_HANDLER(push_state(ctx, 0x0A3B, 0x3F800000));      /* Path tessellation SCALE. */
+    VG_LITE_ERROR_HANDLER(push_state(ctx, 0x0A3C, 0x00000000));      /* Path tessellation BIAS.  */
+
+    for (tile = 0; refs != NULL && tile < tiles_x * tiles_y; tile++) {
+        tile_started = 0;
+        for (k = bins[tile]; k < bins[tile + 1]; k++) {
+            vg_lite_draw_item_t *item = &items[refs[k]];
+
+            path = item->path;
+            quality = convert_path_quality(path->quality);
+            for (i = 0; i < 2; i++) {
+                if (i == 0) {
+                    if ((path->path_type & 0x1) != VG_LITE_DRAW_FILL_PATH)
+                        continue;
+                    format = convert_path_format(path->format);
+                    fill = (item->fill_rule == VG_LITE_FILL_EVEN_ODD) ? 0x10 : 0;
+                }
+                else {
+                    if ((path->path_type != VG_LITE_DRAW_STROKE_PATH && path->path_type != VG_LITE_DRAW_FILL_STROKE_PATH) ||
+                        path->stroke_path_data == NULL)
+                        continue;
+                    format = convert_path_format(path->stroke_conversion ? path->stroke_conversion->stroke_path_format : VG_LITE_FP32);
+                    fill = 0;
+                }
+
+                /* Tessellate path, the tile origin is programmed once per tile. */
+                VG_LITE_ERROR_HANDLER(push_tessellation_stall(ctx));
+                VG_LITE_ERROR_HANDLER(push_state(ctx, 0x0A1B, 0x00011000));
+                if (!tile_started) {
+                    tx = (tile % tiles_x) * width;
+                    ty = (tile / tiles_x) * height;
+                    VG_LITE_ERROR_HANDLER(push_state(ctx, 0x0A01, tx | (ty << 16)));
+                    VG_LITE_ERROR_HANDLER(push_state(ctx, 0x0A39, tx | (ty << 16)));
+                    VG_LITE_ERROR_HANDLER(push_state(ctx, 0x0A3D, tessellation_size / 64));
+                    tile_started = 1;
+                }
+                VG_LITE_ERROR_HANDLER(_draw_paths_layer(ctx, item, (uint8_t)i, 0x01000200 | format | quality | tiling | fill,
+                                                        &last_control, &last_color, &last_matrix));
+            }
+        }
+    }
+
+    /* Finialize command buffer. */
+    VG_LITE_ERROR_HANDLER(push_state(ctx, 0x0A34, 0));
+    VG_LITE_ERROR_HANDLER(flush_draw(ctx));
 #if !defined(VG_DRIVER_SINGLE_THREAD)
     ctx->ts_init = 1;
 #endif /* not defined(VG_DRIVER_SINGLE_THREAD) */
+
+    for (i = 0; i < count; i++) {
+        cached = _path_cache_find(ctx, items[i].path);
+        if (cached != NULL)
+            VG_LITE_ERROR_HANDLER(vg_lite_fence_insert(&cached->fence));
+    }
+
+ErrorHandler:
+    if (refs != NULL)
+        vg_lite_os_free(refs);
+    vg_lite_os_free(bins);
     return error;
 }
 
@@ -7098,6 +8245,7 @@ vg_lite_error_t vg_lite_close(void)
 {
     vg_lite_error_t error;
     vg_lite_kernel_terminate_t terminate;
+    uint32_t i;
 #if defined(VG_DRIVER_SINGLE_THREAD)
     vg_lite_context_t *ctx = &s_context;
 #else
@@ -7111,6 +8259,10 @@ vg_lite_error_t vg_lite_close(void)
     ctx = &tls->t_context;
 #endif /* VG_DRIVER_SINGLE_THREAD */
 
+    /* Free the paths uploaded by the path cache. */
+    for (i = 0; i < VG_PATH_CACHE_ENTRIES; i++)
+        _path_cache_release(ctx, &ctx->path_cache[i]);
+
 #if VG_TARGET_FAST_CLEAR
     if (ctx->fcBuffer.handle != NULL) {
         vg_lite_free(&ctx->fcBuffer);
@@ -7570,182 +8722,714 @@ uint32_t vg_lite_get_product_info(char *name, uint32_t *chip_id, uint32_t *chip_
     return name_len;
 }
 
-uint32_t vg_lite_query_feature(vg_lite_feature_t feature)
+uint32_t vg_lite_query_feature(vg_lite_feature_t feature)
+{
+    uint32_t result;
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    vg_lite_context_t *ctx = &s_context;
+#else
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t *tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if (tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    ctx = &tls->t_context;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+
+    if (feature < gcFEATURE_COUNT)
+        result = ctx->s_ftable.ftable[feature];
+    else
+        result = 0;
+
+    return result;
+}
+
+#if defined(VG_DRIVER_SINGLE_THREAD)
+vg_lite_error_t vg_lite_finish()
+{
+    vg_lite_error_t  error;
+
+    /* Return if there is nothing to submit. */
+    if (CMDBUF_OFFSET(s_context) == 0)
+    {
+        if(submit_flag)
+            VG_LITE_RETURN_ERROR(stall(&s_context, 0, (uint32_t)~0));
+#if VG_STALL_ELISION
+        s_context.tessellation_idle = 1;
+#endif /* VG_STALL_ELISION */
+        return VG_LITE_SUCCESS;
+    }
+
+    /* Flush is moved from each draw to here. */
+    VG_LITE_RETURN_ERROR(flush_target());
+    VG_LITE_RETURN_ERROR(submit(&s_context));
+    VG_LITE_RETURN_ERROR(stall(&s_context, 0, (uint32_t)~0));
+
+#if VG_TARGET_FAST_CLEAR
+    /*Only used in cmodel/fpga. In final SOC this SW FC decoder should be removed. */
+    if (s_context.rtbuffer != NULL) {
+#if VG_TARGET_FC_DUMP
+        fc_buf_dump(s_context.rtbuffer, &s_context.fcBuffer);
+#endif /* VG_TARGET_FC_DUMP */
+    }
+#endif
+
+    CMDBUF_SWAP(s_context);
+    /* Reset command buffer. */
+    CMDBUF_OFFSET(s_context) = 0;
+#if VG_STALL_ELISION
+    s_context.tessellation_idle = 1;
+#endif /* VG_STALL_ELISION */
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_flush(void)
+{
+    vg_lite_error_t error;
+
+    /* Return if there is nothing to submit. */
+    if (CMDBUF_OFFSET(s_context) == 0)
+        return VG_LITE_SUCCESS;
+
+    /* Wait if GPU has not completed previous CMD buffer */
+    if (submit_flag)
+    {
+        VG_LITE_RETURN_ERROR(stall(&s_context, 0, (uint32_t)~0));
+    }
+
+    /* Submit the current command buffer. */
+    VG_LITE_RETURN_ERROR(flush_target());
+    VG_LITE_RETURN_ERROR(submit(&s_context));
+    CMDBUF_SWAP(s_context);
+    /* Reset command buffer. */
+    CMDBUF_OFFSET(s_context) = 0;
+
+    return VG_LITE_SUCCESS;
+}
+#else
+vg_lite_error_t vg_lite_finish()
+{
+    vg_lite_error_t  error;
+    vg_lite_tls_t* tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    /* Nothing can be submitted while a command list is being recorded. */
+    if(tls->t_context.recording != NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    if (CMDBUF_OFFSET(tls->t_context) <= 8){
+        /* Return if there is nothing to submit. */
+        if (!has_queued_command_buffer(&tls->t_context))
+                return VG_LITE_SUCCESS;
+        /* This frame has unfinished command. */
+        VG_LITE_RETURN_ERROR(stall_all(&tls->t_context));
+        CMDBUF_OFFSET(tls->t_context) = 0;
+        VG_LITE_RETURN_ERROR(push_state(&tls->t_context, 0x0A00, 0x0));
+#if VG_STALL_ELISION
+        tls->t_context.tessellation_idle = 1;
+#endif /* VG_STALL_ELISION */
+        return VG_LITE_SUCCESS;
+    }
+    else
+    {
+        /* Flush is moved from each draw to here. */
+        VG_LITE_RETURN_ERROR(flush_target());
+        VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_LOCK, NULL));
+        /* if context have been switched and this task need use index. */
+        VG_LITE_RETURN_ERROR(update_context_buffer());
+        VG_LITE_RETURN_ERROR(submit(&tls->t_context));
+        VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_UNLOCK, NULL));
+        VG_LITE_RETURN_ERROR(stall(&tls->t_context, 0));
+    }
+
+#if VG_TARGET_FAST_CLEAR
+    /*Only used in cmodel/fpga. In final SOC this SW FC decoder should be removed. */
+    if (tls->t_context.rtbuffer != NULL) {
+#if VG_TARGET_FC_DUMP
+        fc_buf_dump(tls->t_context.rtbuffer, &tls->t_context.fcBuffer);
+#endif /* VG_TARGET_FC_DUMP */
+    }
+#endif
+
+    CMDBUF_SWAP(tls->t_context);
+    CMDBUF_OFFSET(tls->t_context) = 0;
+    VG_LITE_RETURN_ERROR(push_state(&tls->t_context, 0x0A00, 0x0));
+    tls->t_context.ts_init_used = 0;
+    tls->t_context.ts_init_use = 0;
+    tls->t_context.ts_init = 0;
+#if VG_STALL_ELISION
+    tls->t_context.tessellation_idle = 1;
+#endif /* VG_STALL_ELISION */
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_flush(void)
+{
+    vg_lite_error_t error;
+    vg_lite_tls_t* tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    /* Nothing can be submitted while a command list is being recorded. */
+    if(tls->t_context.recording != NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    /* Return if there is nothing to submit. */
+    if (CMDBUF_OFFSET(tls->t_context) == 0)
+        return VG_LITE_SUCCESS;
+
+    /* Submit the current command buffer. */
+    VG_LITE_RETURN_ERROR(flush_target());
+    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_LOCK, NULL));
+    /* if context have been switched and this task need use index. */
+    VG_LITE_RETURN_ERROR(update_context_buffer());
+    VG_LITE_RETURN_ERROR(submit(&tls->t_context));
+    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_UNLOCK, NULL));
+
+    CMDBUF_SWAP(tls->t_context);
+    CMDBUF_OFFSET(tls->t_context) = 0;
+    VG_LITE_RETURN_ERROR(push_state(&tls->t_context, 0x0A00, 0x0));
+    tls->t_context.ts_init_used = 0;
+    tls->t_context.ts_init_use = 0;
+    tls->t_context.ts_init = 0;
+
+    return VG_LITE_SUCCESS;
+}
+#endif /* VG_DRIVER_SINGLE_THREAD */
+
+vg_lite_error_t vg_lite_fence_insert(vg_lite_fence_t *fence)
+{
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    vg_lite_context_t *ctx = &s_context;
+#else
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t* tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    ctx = &tls->t_context;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+
+    if (fence == NULL || ctx->recording != NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    /* Single thread driver has no submission tracking: the fence waits for everything. */
+    fence->serial = 0;
+    fence->command_id = 0;
+#else
+    /* Commands in the current buffer will be signaled with its next serial number. */
+    fence->command_id = CMDBUF_INDEX(*ctx);
+    if (CMDBUF_OFFSET(*ctx) > 8) {
+        fence->serial = ctx->submit_serial + 1;
+    } else {
+        fence->command_id = CMDBUF_PREV_INDEX(*ctx);
+        fence->serial = ctx->submit_serial;
+    }
+#endif /* VG_DRIVER_SINGLE_THREAD */
+
+    return VG_LITE_SUCCESS;
+}
+
+uint32_t vg_lite_fence_is_signaled(vg_lite_fence_t *fence)
+{
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    return (fence != NULL && !submit_flag && CMDBUF_OFFSET(s_context) == 0);
+#else
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t* tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL || fence == NULL)
+        return 0;
+
+    ctx = &tls->t_context;
+
+    /* Not submitted yet. */
+    if (fence->serial > ctx->submit_serial)
+        return 0;
+
+    /* A reused buffer has completed its earlier submission. */
+    if (fence->serial == 0 || ctx->command_serial[fence->command_id] != fence->serial)
+        return 1;
+
+    return !CMDBUF_IN_QUEUE(&ctx->context, fence->command_id);
+#endif /* VG_DRIVER_SINGLE_THREAD */
+}
+
+vg_lite_error_t vg_lite_fence_wait(vg_lite_fence_t *fence, uint32_t timeout)
+{
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    if (fence == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    (void)timeout;
+    return vg_lite_finish();
+#else
+    vg_lite_error_t error;
+    vg_lite_kernel_wait_t wait;
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t* tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    ctx = &tls->t_context;
+
+    if (fence == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    /* Submit the fenced commands if they are still in the current buffer. */
+    if (fence->serial > ctx->submit_serial)
+        VG_LITE_RETURN_ERROR(vg_lite_flush());
+
+    if (vg_lite_fence_is_signaled(fence))
+        return VG_LITE_SUCCESS;
+
+    if (timeout == 0)
+        return VG_LITE_TIMEOUT;
+
+    wait.context = &ctx->context;
+    wait.timeout_ms = timeout;
+    wait.command_id = fence->command_id;
+    return vg_lite_kernel(VG_LITE_WAIT, &wait);
+#endif /* VG_DRIVER_SINGLE_THREAD */
+}
+
+vg_lite_error_t vg_lite_fence_get_gpu_time(vg_lite_fence_t *fence, uint32_t *time)
+{
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    (void)fence;
+    (void)time;
+    return VG_LITE_NOT_SUPPORT;
+#else
+    vg_lite_os_async_event_t *event;
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t* tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    ctx = &tls->t_context;
+
+    if (fence == NULL || time == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    /* The times of a reused buffer belong to a later submission. */
+    if (fence->serial == 0 || ctx->command_serial[fence->command_id] != fence->serial)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    if (!vg_lite_fence_is_signaled(fence))
+        return VG_LITE_TIMEOUT;
+
+    event = &ctx->context.async_event[fence->command_id];
+    *time = event->end_time - event->start_time;
+
+    return VG_LITE_SUCCESS;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+}
+
+/* Host side record of a path uploaded into an arena, placed after its commands. */
+typedef struct vg_lite_arena_path {
+    vg_lite_path_t *path;
+    void *memory;
+    struct vg_lite_arena_path *next;
+} vg_lite_arena_path_t;
+
+/* Drop the uploads of the paths uploaded into the current frame, unless they were uploaded again since. */
+static void arena_release_paths(vg_lite_arena_t *arena)
+{
+    vg_lite_arena_path_t *record;
+
+    for (record = (vg_lite_arena_path_t *)arena->paths; record != NULL; record = record->next) {
+        if (record->path->uploaded.handle == NULL && record->path->uploaded.memory == record->memory)
+            memset(&record->path->uploaded, 0, sizeof(record->path->uploaded));
+    }
+    arena->paths = NULL;
+}
+
+vg_lite_error_t vg_lite_arena_create(vg_lite_arena_t *arena, uint32_t frame_bytes)
+{
+    vg_lite_error_t error;
+    vg_lite_kernel_allocate_t allocate;
+
+    if (arena == NULL || frame_bytes == 0)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    memset(arena, 0, sizeof(*arena));
+    arena->frame_bytes = VG_LITE_ALIGN(frame_bytes, 64);
+
+    allocate.bytes = arena->frame_bytes * VG_LITE_ARENA_FRAMES;
+    allocate.contiguous = 1;
+    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_ALLOCATE, &allocate));
+    arena->memory.handle = allocate.memory_handle;
+    arena->memory.memory = allocate.memory;
+    arena->memory.address = allocate.memory_gpu;
+    arena->memory.bytes = allocate.bytes;
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_arena_destroy(vg_lite_arena_t *arena)
+{
+    vg_lite_error_t error;
+    vg_lite_kernel_free_t free_cmd;
+    uint32_t i;
+
+    if (arena == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    /* The current frame may still be referenced by commands that are not submitted yet. */
+    if (arena->offset != 0)
+        VG_LITE_RETURN_ERROR(vg_lite_fence_insert(&arena->fences[arena->frame]));
+    for (i = 0; i < VG_LITE_ARENA_FRAMES; i++) {
+        VG_LITE_RETURN_ERROR(vg_lite_fence_wait(&arena->fences[i], VG_LITE_FENCE_INFINITE));
+    }
+
+    arena_release_paths(arena);
+    if (arena->memory.handle != NULL) {
+        free_cmd.memory_handle = arena->memory.handle;
+        VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_FREE, &free_cmd));
+    }
+    memset(arena, 0, sizeof(*arena));
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_arena_alloc(vg_lite_arena_t *arena, uint32_t bytes, void **memory, uint32_t *address)
+{
+    uint32_t offset;
+
+    if (arena == NULL || arena->memory.handle == NULL || memory == NULL || address == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    bytes = VG_LITE_ALIGN(bytes, 64);
+    if (bytes > arena->frame_bytes - arena->offset)
+        return VG_LITE_OUT_OF_MEMORY;
+
+    offset = arena->frame * arena->frame_bytes + arena->offset;
+    arena->offset += bytes;
+    if (arena->offset > arena->peak)
+        arena->peak = arena->offset;
+
+    *memory = (uint8_t *)arena->memory.memory + offset;
+    *address = arena->memory.address + offset;
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_arena_allocate_buffer(vg_lite_arena_t *arena, vg_lite_buffer_t *buffer)
+{
+    vg_lite_error_t error;
+    uint32_t mul, div, align;
+    void *alpha_memory;
+
+    if (buffer == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    if (buffer->format >= VG_LITE_NV12 && buffer->format <= VG_LITE_ANV12_TILED
+        && buffer->format != VG_LITE_AYUY2 && buffer->format != VG_LITE_YUY2_TILED)
+        return VG_LITE_NOT_SUPPORT;
+
+    /* Same layout as vg_lite_allocate. */
+    buffer->yuv.uv_planar =
+    buffer->yuv.v_planar =
+    buffer->yuv.alpha_planar = 0;
+    if (buffer->format >= VG_LITE_YUY2 && buffer->format <= VG_LITE_NV16) {
+        buffer->height = VG_LITE_ALIGN(buffer->height, 4);
+        buffer->yuv.swizzle = VG_LITE_SWIZZLE_UV;
+    }
+    if (buffer->format >= VG_LITE_YUY2_TILED && buffer->format <= VG_LITE_AYUY2_TILED) {
+        buffer->height = VG_LITE_ALIGN(buffer->height, 4);
+        buffer->tiled = VG_LITE_TILED;
+        buffer->yuv.swizzle = VG_LITE_SWIZZLE_UV;
+    }
+
+    get_format_bytes(buffer->format, &mul, &div, &align);
+    buffer->stride = VG_LITE_ALIGN((buffer->width * mul / div), align);
+    VG_LITE_RETURN_ERROR(vg_lite_arena_alloc(arena, buffer->stride * buffer->height, &buffer->memory, &buffer->address));
+
+    if (buffer->format == VG_LITE_AYUY2 || buffer->format == VG_LITE_AYUY2_TILED) {
+        VG_LITE_RETURN_ERROR(vg_lite_arena_alloc(arena, buffer->stride * buffer->height,
+                                                 &alpha_memory, &buffer->yuv.alpha_planar));
+    }
+
+    /* Nothing to free, the memory belongs to the arena. */
+    buffer->handle = NULL;
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_arena_upload_path(vg_lite_arena_t *arena, vg_lite_path_t * path)
+{
+    vg_lite_error_t error;
+    vg_lite_arena_path_t *record;
+    uint32_t bytes, address;
+    void *memory;
+
+    if (arena == NULL || path == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    /* Same layout as vg_lite_upload_path, followed by the record the reset finds the path with. */
+    bytes = (8 + path->path_length + 7 + 8) & ~7;
+    VG_LITE_RETURN_ERROR(vg_lite_arena_alloc(arena, bytes + sizeof(vg_lite_arena_path_t), &memory, &address));
+
+    ((uint32_t *) memory)[0] = 0x40000000 | ((path->path_length + 7) / 8);
+    ((uint32_t *) memory)[1] = 0;
+    memcpy((uint32_t *) memory + 2, path->path, path->path_length);
+    ((uint32_t *) memory)[bytes / 4 - 2] = 0x70000000;
+    ((uint32_t *) memory)[bytes / 4 - 1] = 0;
+
+    record = (vg_lite_arena_path_t *)((uint8_t *)memory + bytes);
+    record->path = path;
+    record->memory = memory;
+    record->next = (vg_lite_arena_path_t *)arena->paths;
+    arena->paths = record;
+
+    /* No handle, the memory is released with the frame. */
+    path->uploaded.handle = NULL;
+    path->uploaded.address = address;
+    path->uploaded.memory = memory;
+    path->uploaded.bytes = bytes;
+    path->path_changed = 0;
+    VLM_PATH_ENABLE_UPLOAD(*path);
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_arena_reset(vg_lite_arena_t *arena)
+{
+    vg_lite_error_t error;
+
+    if (arena == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    if (arena->offset == 0)
+        return VG_LITE_SUCCESS;
+
+    arena_release_paths(arena);
+    VG_LITE_RETURN_ERROR(vg_lite_fence_insert(&arena->fences[arena->frame]));
+    arena->frame = (arena->frame + 1) % VG_LITE_ARENA_FRAMES;
+    arena->offset = 0;
+
+    /* The GPU may still read the previous contents of the new segment. */
+    return vg_lite_fence_wait(&arena->fences[arena->frame], VG_LITE_FENCE_INFINITE);
+}
+
+vg_lite_error_t vg_lite_begin_command_list(vg_lite_command_list_t *list, uint32_t size)
+{
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    return VG_LITE_NOT_SUPPORT;
+#else
+    vg_lite_error_t error;
+    vg_lite_kernel_allocate_t allocate;
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t* tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    ctx = &tls->t_context;
+
+    if (list == NULL || size == 0 || ctx->recording != NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    memset(list, 0, sizeof(*list));
+
+    /* Allocate the list, with room for the final return command. */
+    allocate.bytes = VG_LITE_ALIGN(size, 8) + 8;
+    allocate.contiguous = 1;
+    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_ALLOCATE, &allocate));
+    list->buffer.handle = allocate.memory_handle;
+    list->buffer.memory = allocate.memory;
+    list->buffer.address = allocate.memory_gpu;
+    list->buffer.bytes = allocate.bytes;
+
+    /* Redirect the current command buffer slot to the list. */
+    ctx->recording = list;
+    ctx->record_buffer = CMDBUF_BUFFER(*ctx);
+    ctx->record_offset = CMDBUF_OFFSET(*ctx);
+    ctx->record_size = CMDBUF_SIZE(*ctx);
+    ctx->record_start_offset = ctx->start_offset;
+    ctx->record_ts_init = ctx->ts_init;
+    ctx->record_ts_dirty = ctx->ts_dirty;
+#if VG_STALL_ELISION
+    /* The list can be called after anything. */
+    ctx->tessellation_idle = 0;
+#endif /* VG_STALL_ELISION */
+
+    CMDBUF_BUFFER(*ctx) = (uint8_t *)list->buffer.memory;
+    CMDBUF_OFFSET(*ctx) = 0;
+    CMDBUF_SIZE(*ctx) = list->buffer.bytes - 8;
+
+    return VG_LITE_SUCCESS;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+}
+
+vg_lite_error_t vg_lite_end_command_list(vg_lite_command_list_t *list)
 {
-    uint32_t result;
 #if defined(VG_DRIVER_SINGLE_THREAD)
-    vg_lite_context_t *ctx = &s_context;
+    return VG_LITE_NOT_SUPPORT;
 #else
     vg_lite_context_t *ctx;
-    vg_lite_tls_t *tls;
+    vg_lite_tls_t* tls;
 
     tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
-    if (tls == NULL)
+    if(tls == NULL)
         return VG_LITE_NO_CONTEXT;
 
     ctx = &tls->t_context;
-#endif /* VG_DRIVER_SINGLE_THREAD */
 
-    if (feature < gcFEATURE_COUNT)
-        result = ctx->s_ftable.ftable[feature];
-    else
-        result = 0;
+    if (list == NULL || ctx->recording != list)
+        return VG_LITE_INVALID_ARGUMENT;
 
-    return result;
+    /* Terminate the list with a return command. */
+    ((uint32_t *) (CMDBUF_BUFFER(*ctx) + CMDBUF_OFFSET(*ctx)))[0] = VG_LITE_RETURN();
+    ((uint32_t *) (CMDBUF_BUFFER(*ctx) + CMDBUF_OFFSET(*ctx)))[1] = 0;
+    list->length = CMDBUF_OFFSET(*ctx) + 8;
+
+    /* Restore the command buffer slot. */
+    CMDBUF_BUFFER(*ctx) = ctx->record_buffer;
+    CMDBUF_OFFSET(*ctx) = ctx->record_offset;
+    CMDBUF_SIZE(*ctx) = ctx->record_size;
+    ctx->start_offset = ctx->record_start_offset;
+    ctx->ts_init = ctx->record_ts_init;
+    ctx->ts_dirty = ctx->record_ts_dirty;
+#if VG_STALL_ELISION
+    ctx->tessellation_idle = 0;
+#endif /* VG_STALL_ELISION */
+    ctx->recording = NULL;
+
+    return VG_LITE_SUCCESS;
+#endif /* VG_DRIVER_SINGLE_THREAD */
 }
 
+vg_lite_command_list_t *vg_lite_get_recording_list(void)
+{
 #if defined(VG_DRIVER_SINGLE_THREAD)
-vg_lite_error_t vg_lite_finish()
+    return NULL;
+#else
+    vg_lite_tls_t* tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return NULL;
+
+    return tls->t_context.recording;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+}
+
+vg_lite_error_t vg_lite_call_command_list(vg_lite_command_list_t *list)
 {
-    vg_lite_error_t  error;
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    return VG_LITE_NOT_SUPPORT;
+#else
+    vg_lite_error_t error;
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t* tls;
 
-    /* Return if there is nothing to submit. */
-    if (CMDBUF_OFFSET(s_context) == 0)
-    {
-        if(submit_flag)
-            VG_LITE_RETURN_ERROR(stall(&s_context, 0, (uint32_t)~0));
-        return VG_LITE_SUCCESS;
-    }
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return VG_LITE_NO_CONTEXT;
 
-    /* Flush is moved from each draw to here. */
-    VG_LITE_RETURN_ERROR(flush_target());
-    VG_LITE_RETURN_ERROR(submit(&s_context));
-    VG_LITE_RETURN_ERROR(stall(&s_context, 0, (uint32_t)~0));
+    ctx = &tls->t_context;
 
-#if VG_TARGET_FAST_CLEAR
-    /*Only used in cmodel/fpga. In final SOC this SW FC decoder should be removed. */
-    if (s_context.rtbuffer != NULL) {
-#if VG_TARGET_FC_DUMP
-        fc_buf_dump(s_context.rtbuffer, &s_context.fcBuffer);
-#endif /* VG_TARGET_FC_DUMP */
-    }
-#endif
+    /* Lists can not be nested. */
+    if (list == NULL || list->length == 0 || ctx->recording != NULL)
+        return VG_LITE_INVALID_ARGUMENT;
 
-    CMDBUF_SWAP(s_context);
-    /* Reset command buffer. */
-    CMDBUF_OFFSET(s_context) = 0;
+    /* The first command of a buffer is the slot for the context buffer call, fill it as finish does. */
+    if (CMDBUF_OFFSET(*ctx) == 0)
+        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A00, 0x0));
+    VG_LITE_RETURN_ERROR(push_call(ctx, list->buffer.address, list->length));
+    /* The list leaves its own states programmed, and may have tessellated. */
+    reset_state_shadow(ctx);
+#if VG_STALL_ELISION
+    ctx->tessellation_idle = 0;
+#endif /* VG_STALL_ELISION */
 
     return VG_LITE_SUCCESS;
+#endif /* VG_DRIVER_SINGLE_THREAD */
 }
 
-vg_lite_error_t vg_lite_flush(void)
+vg_lite_error_t vg_lite_command_list_set_color(vg_lite_command_list_t *list, uint32_t index, vg_lite_color_t color)
 {
-    vg_lite_error_t error;
-
-    /* Return if there is nothing to submit. */
-    if (CMDBUF_OFFSET(s_context) == 0)
-        return VG_LITE_SUCCESS;
+    vg_lite_command_list_entry_t *entry;
 
-    /* Wait if GPU has not completed previous CMD buffer */
-    if (submit_flag)
-    {
-        VG_LITE_RETURN_ERROR(stall(&s_context, 0, (uint32_t)~0));
-    }
+    if (list == NULL || index >= list->entry_count || list->entries[index].color_offset == 0)
+        return VG_LITE_INVALID_ARGUMENT;
 
-    /* Submit the current command buffer. */
-    VG_LITE_RETURN_ERROR(flush_target());
-    VG_LITE_RETURN_ERROR(submit(&s_context));
-    CMDBUF_SWAP(s_context);
-    /* Reset command buffer. */
-    CMDBUF_OFFSET(s_context) = 0;
+    entry = &list->entries[index];
+    *(uint32_t *)((uint8_t *)list->buffer.memory + entry->color_offset) = entry->luminance ? rgb_to_l(color) : color;
 
     return VG_LITE_SUCCESS;
 }
-#else
-vg_lite_error_t vg_lite_finish()
+
+vg_lite_error_t vg_lite_command_list_set_stroke_color(vg_lite_command_list_t *list, uint32_t index, vg_lite_color_t color)
 {
-    vg_lite_error_t  error;
-    vg_lite_tls_t* tls;
-    uint32_t command_id, index;
+    if (list == NULL || index >= list->entry_count || list->entries[index].stroke_color_offset == 0)
+        return VG_LITE_INVALID_ARGUMENT;
 
-    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
-    if(tls == NULL)
-        return VG_LITE_NO_CONTEXT;
+    *(uint32_t *)((uint8_t *)list->buffer.memory + list->entries[index].stroke_color_offset) = color;
 
-    command_id = CMDBUF_INDEX(tls->t_context);
-    index = command_id ? 0 : 1;
+    return VG_LITE_SUCCESS;
+}
 
-    if (CMDBUF_OFFSET(tls->t_context) <= 8){
-        /* Return if there is nothing to submit. */
-        if (!CMDBUF_IN_QUEUE(&tls->t_context.context, 0) && !CMDBUF_IN_QUEUE(&tls->t_context.context, 1) )
-                return VG_LITE_SUCCESS;
-        /* This frame has unfinished command. */
-        else if(CMDBUF_IN_QUEUE(&tls->t_context.context, index))
-        {
-            CMDBUF_SWAP(tls->t_context);
-            VG_LITE_RETURN_ERROR(stall(&tls->t_context, 0));
-        }
-        /* This frame has unfinished command. */
-        else if(CMDBUF_IN_QUEUE(&tls->t_context.context, command_id))
-        {
-            VG_LITE_RETURN_ERROR(stall(&tls->t_context, 0));
-        }
-        CMDBUF_OFFSET(tls->t_context) = 0;
-        VG_LITE_RETURN_ERROR(push_state(&tls->t_context, 0x0A00, 0x0));
-        return VG_LITE_SUCCESS;
-    }
-    else
-    {
-        /* Flush is moved from each draw to here. */
-        VG_LITE_RETURN_ERROR(flush_target());
-        VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_LOCK, NULL));
-        /* if context have been switched and this task need use index. */
-        VG_LITE_RETURN_ERROR(update_context_buffer());
-        VG_LITE_RETURN_ERROR(submit(&tls->t_context));
-        VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_UNLOCK, NULL));
-        VG_LITE_RETURN_ERROR(stall(&tls->t_context, 0));
-    }
+vg_lite_error_t vg_lite_command_list_set_matrix(vg_lite_command_list_t *list, uint32_t index, vg_lite_matrix_t *matrix)
+{
+    uint32_t *states;
 
-#if VG_TARGET_FAST_CLEAR
-    /*Only used in cmodel/fpga. In final SOC this SW FC decoder should be removed. */
-    if (tls->t_context.rtbuffer != NULL) {
-#if VG_TARGET_FC_DUMP
-        fc_buf_dump(tls->t_context.rtbuffer, &tls->t_context.fcBuffer);
-#endif /* VG_TARGET_FC_DUMP */
-    }
-#endif
+    if (list == NULL || matrix == NULL || index >= list->entry_count || list->entries[index].matrix_offset == 0)
+        return VG_LITE_INVALID_ARGUMENT;
 
-    CMDBUF_SWAP(tls->t_context);
-    CMDBUF_OFFSET(tls->t_context) = 0;
-    VG_LITE_RETURN_ERROR(push_state(&tls->t_context, 0x0A00, 0x0));
-    tls->t_context.ts_init_used = 0;
-    tls->t_context.ts_init_use = 0;
-    tls->t_context.ts_init = 0;
+    /* Matrix states 0x0A40 - 0x0A45 are recorded as consecutive state commands. */
+    states = (uint32_t *)((uint8_t *)list->buffer.memory + list->entries[index].matrix_offset);
+    memcpy(&states[1], &matrix->m[0][0], sizeof(uint32_t));
+    memcpy(&states[3], &matrix->m[0][1], sizeof(uint32_t));
+    memcpy(&states[5], &matrix->m[0][2], sizeof(uint32_t));
+    memcpy(&states[7], &matrix->m[1][0], sizeof(uint32_t));
+    memcpy(&states[9], &matrix->m[1][1], sizeof(uint32_t));
+    memcpy(&states[11], &matrix->m[1][2], sizeof(uint32_t));
 
     return VG_LITE_SUCCESS;
 }
 
-vg_lite_error_t vg_lite_flush(void)
+vg_lite_error_t vg_lite_free_command_list(vg_lite_command_list_t *list)
 {
     vg_lite_error_t error;
-    vg_lite_tls_t* tls;
-
-    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
-    if(tls == NULL)
-        return VG_LITE_NO_CONTEXT;
+    vg_lite_kernel_free_t free_cmd;
 
-    /* Return if there is nothing to submit. */
-    if (CMDBUF_OFFSET(tls->t_context) == 0)
-        return VG_LITE_SUCCESS;
-
-    /* Submit the current command buffer. */
-    VG_LITE_RETURN_ERROR(flush_target());
-    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_LOCK, NULL));
-    /* if context have been switched and this task need use index. */
-    VG_LITE_RETURN_ERROR(update_context_buffer());
-    VG_LITE_RETURN_ERROR(submit(&tls->t_context));
-    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_UNLOCK, NULL));
+    if (list == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
 
-    CMDBUF_SWAP(tls->t_context);
-    CMDBUF_OFFSET(tls->t_context) = 0;
-    VG_LITE_RETURN_ERROR(push_state(&tls->t_context, 0x0A00, 0x0));
-    tls->t_context.ts_init_used = 0;
-    tls->t_context.ts_init_use = 0;
-    tls->t_context.ts_init = 0;
+    if (list->release != NULL) {
+        list->release(list);
+    }
+    if (list->buffer.handle != NULL) {
+        free_cmd.memory_handle = list->buffer.handle;
+        VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_FREE, &free_cmd));
+    }
+    if (list->entries != NULL) {
+        vg_lite_os_free(list->entries);
+    }
+    memset(list, 0, sizeof(*list));
 
     return VG_LITE_SUCCESS;
 }
-#endif /* VG_DRIVER_SINGLE_THREAD */
 
 vg_lite_error_t vg_lite_init_arc_path(vg_lite_path_t * path,
                        vg_lite_format_t data_format,
@@ -8159,6 +9843,8 @@ vg_lite_error_t vg_lite_init_path(vg_lite_path_t * path,
 vg_lite_error_t vg_lite_clear_path(vg_lite_path_t * path)
 {
     vg_lite_error_t error;
+
+    _path_cache_forget(path);
     if (path->uploaded.handle != NULL)
     {
         vg_lite_kernel_free_t free_cmd;
@@ -8182,34 +9868,8 @@ vg_lite_error_t vg_lite_clear_path(vg_lite_path_t * path)
     }
 
     if (path->stroke_conversion) {
-        if(path->stroke_conversion->path_point_list) {
-            vg_lite_path_point_ptr temp_point;
-            while(path->stroke_conversion->path_point_list) {
-                temp_point = path->stroke_conversion->path_point_list->next;
-                vg_lite_os_free(path->stroke_conversion->path_point_list);
-                path->stroke_conversion->path_point_list = temp_point;
-            }
-            temp_point = NULL;
-        }
-
-        if(path->stroke_conversion->stroke_sub_path_list) {
-            vg_lite_sub_path_ptr temp_sub_path;
-            while(path->stroke_conversion->stroke_sub_path_list) {
-                temp_sub_path = path->stroke_conversion->stroke_sub_path_list->next;
-                if(path->stroke_conversion->stroke_sub_path_list->point_list) {
-                    vg_lite_path_point_ptr temp_point;
-                    while(path->stroke_conversion->stroke_sub_path_list->point_list) {
-                        temp_point = path->stroke_conversion->stroke_sub_path_list->point_list->next;
-                        vg_lite_os_free(path->stroke_conversion->stroke_sub_path_list->point_list);
-                        path->stroke_conversion->stroke_sub_path_list->point_list = temp_point;
-                    }
-                    temp_point = NULL;
-                }
-                vg_lite_os_free(path->stroke_conversion->stroke_sub_path_list);
-                path->stroke_conversion->stroke_sub_path_list = temp_sub_path;
-            }
-            temp_sub_path = NULL;
-        }
+        VG_LITE_RETURN_ERROR(_free_stroke_upload(path->stroke_conversion));
+        _stroke_free_blocks(path->stroke_conversion);
 
         vg_lite_os_free(path->stroke_conversion);
         path->stroke_conversion = NULL;
@@ -8505,6 +10165,9 @@ vg_lite_error_t vg_lite_draw_pattern(vg_lite_buffer_t * target,
         VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A25, convert_source_format(source->format) |
                                                             filter | pattern_tile | conversion));
     }
+    if (ctx->recording != NULL) {
+        VG_LITE_RETURN_ERROR(add_command_list_entry(ctx, CMDBUF_OFFSET(*ctx) + 4, 0));
+    }
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A27, pattern_color));
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A29, source->address));
 
@@ -8573,6 +10236,9 @@ vg_lite_error_t vg_lite_draw_pattern(vg_lite_buffer_t * target,
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3B, 0x3F800000));      /* Path tessellation SCALE. */
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3C, 0x00000000));      /* Path tessellation BIAS.  */
     /* Program matrix. */
+    if (ctx->recording != NULL) {
+        ctx->recording->entries[ctx->recording->entry_count - 1].matrix_offset = CMDBUF_OFFSET(*ctx);
+    }
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A40, (void *) &matrix->m[0][0]));
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A41, (void *) &matrix->m[0][1]));
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A42, (void *) &matrix->m[0][2]));
@@ -8592,13 +10258,13 @@ vg_lite_error_t vg_lite_draw_pattern(vg_lite_buffer_t * target,
         for (y = point_min.y; y < point_max.y; y += height) {
             for (x = point_min.x; x < point_max.x; x += width) {
                 /* Tessellate path. */
-                VG_LITE_RETURN_ERROR(push_stall(ctx, 15));
+                VG_LITE_RETURN_ERROR(push_tessellation_stall(ctx));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A1B, 0x00011000));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A01, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A39, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3D, tessellation_size / 64));
 
-                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1) {
+                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1 && ctx->recording == NULL) {
                     VG_LITE_RETURN_ERROR(push_call(ctx, path->uploaded.address, path->uploaded.bytes));
 #if  (DUMP_COMMAND)
                     if (strncmp(filename, "Commandbuffer", 13)) {
@@ -8646,17 +10312,24 @@ vg_lite_error_t vg_lite_draw_pattern(vg_lite_buffer_t * target,
     }
     /* Setup tessellation loop. */
     if(path->path_type == VG_LITE_DRAW_STROKE_PATH || path->path_type == VG_LITE_DRAW_FILL_STROKE_PATH) {
+        /* The stroke color is programmed once for all tiles, so a recorded one can be patched in one place. */
+        if (ctx->recording != NULL) {
+            ctx->recording->entries[ctx->recording->entry_count - 1].stroke_color_offset = CMDBUF_OFFSET(*ctx) + 4;
+        }
+        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, path->stroke_color));
         for (y = point_min.y; y < point_max.y; y += height) {
             for (x = point_min.x; x < point_max.x; x += width) {
                 /* Tessellate path. */
-                VG_LITE_RETURN_ERROR(push_stall(ctx, 15));
+                VG_LITE_RETURN_ERROR(push_tessellation_stall(ctx));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A1B, 0x00011000));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A01, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A39, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3D, tessellation_size / 64));
 
-                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1) {
-                    VG_LITE_RETURN_ERROR(push_call(ctx, path->uploaded.address, path->uploaded.bytes));
+                format = convert_path_format(path->stroke_conversion ? path->stroke_conversion->stroke_path_format : VG_LITE_FP32);
+                VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000200 | format | quality | tiling | 0x0));
+                if (path->stroke_conversion != NULL && path->stroke_conversion->uploaded_handle != NULL && ctx->recording == NULL) {
+                    VG_LITE_RETURN_ERROR(push_call(ctx, path->stroke_conversion->uploaded_address, path->stroke_conversion->uploaded_bytes));
 #if  (DUMP_COMMAND)
                     if (strncmp(filename, "Commandbuffer", 13)) {
                         sprintf(filename, "Commandbuffer_pid%d.txt", getpid());
@@ -8696,9 +10369,6 @@ vg_lite_error_t vg_lite_draw_pattern(vg_lite_buffer_t * target,
                     fp = NULL;
 #endif
                 } else {
-                        format = convert_path_format(VG_LITE_FP32);
-                        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000200 | format | quality | tiling | 0x0));
-                        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, path->stroke_color));
                         push_data(ctx, path->stroke_path_size, path->stroke_path_data);
                 }
             }
@@ -8707,7 +10377,7 @@ vg_lite_error_t vg_lite_draw_pattern(vg_lite_buffer_t * target,
 
     /* Finialize command buffer. */
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0));
-    VG_LITE_RETURN_ERROR(flush_target());
+    VG_LITE_RETURN_ERROR(flush_draw(ctx));
 
     vglitemDUMP_BUFFER("image", source->address, source->memory, 0, (source->stride)*(source->height));
 #if DUMP_IMAGE
@@ -9002,7 +10672,11 @@ vg_lite_error_t vg_lite_draw_linear_gradient(vg_lite_buffer_t * target,
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000400 | format | quality | tiling | fill));
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3B, 0x3F800000));      /* Path tessellation SCALE. */
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3C, 0x00000000));      /* Path tessellation BIAS.  */
-    /* Program matrix. */
+    /* Program matrix. Gradient draws have no solid color to patch. */
+    if (ctx->recording != NULL) {
+        VG_LITE_RETURN_ERROR(add_command_list_entry(ctx, 0, 0));
+        ctx->recording->entries[ctx->recording->entry_count - 1].matrix_offset = CMDBUF_OFFSET(*ctx);
+    }
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A40, (void *) &matrix->m[0][0]));
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A41, (void *) &matrix->m[0][1]));
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A42, (void *) &matrix->m[0][2]));
@@ -9052,13 +10726,13 @@ vg_lite_error_t vg_lite_draw_linear_gradient(vg_lite_buffer_t * target,
         for (y = point_min.y; y < point_max.y; y += height) {
             for (x = point_min.x; x < point_max.x; x += width) {
                 /* Tessellate path. */
-                VG_LITE_RETURN_ERROR(push_stall(ctx, 15));
+                VG_LITE_RETURN_ERROR(push_tessellation_stall(ctx));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A1B, 0x00011000));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A01, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A39, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3D, tessellation_size / 64));
 
-                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1) {
+                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1 && ctx->recording == NULL) {
                     VG_LITE_RETURN_ERROR(push_call(ctx, path->uploaded.address, path->uploaded.bytes));
 #if  (DUMP_COMMAND)
                     if (strncmp(filename, "Commandbuffer", 13)) {
@@ -9106,17 +10780,24 @@ vg_lite_error_t vg_lite_draw_linear_gradient(vg_lite_buffer_t * target,
     }
     /* Setup tessellation loop. */
     if(path->path_type == VG_LITE_DRAW_STROKE_PATH || path->path_type == VG_LITE_DRAW_FILL_STROKE_PATH) {
+        /* The stroke color is programmed once for all tiles, so a recorded one can be patched in one place. */
+        if (ctx->recording != NULL) {
+            ctx->recording->entries[ctx->recording->entry_count - 1].stroke_color_offset = CMDBUF_OFFSET(*ctx) + 4;
+        }
+        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, path->stroke_color));
         for (y = point_min.y; y < point_max.y; y += height) {
             for (x = point_min.x; x < point_max.x; x += width) {
                 /* Tessellate path. */
-                VG_LITE_RETURN_ERROR(push_stall(ctx, 15));
+                VG_LITE_RETURN_ERROR(push_tessellation_stall(ctx));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A1B, 0x00011000));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A01, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A39, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3D, tessellation_size / 64));
 
-                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1) {
-                    VG_LITE_RETURN_ERROR(push_call(ctx, path->uploaded.address, path->uploaded.bytes));
+                format = convert_path_format(path->stroke_conversion ? path->stroke_conversion->stroke_path_format : VG_LITE_FP32);
+                VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000200 | format | quality | tiling | 0x0));
+                if (path->stroke_conversion != NULL && path->stroke_conversion->uploaded_handle != NULL && ctx->recording == NULL) {
+                    VG_LITE_RETURN_ERROR(push_call(ctx, path->stroke_conversion->uploaded_address, path->stroke_conversion->uploaded_bytes));
 #if  (DUMP_COMMAND)
                     if (strncmp(filename, "Commandbuffer", 13)) {
                         sprintf(filename, "Commandbuffer_pid%d.txt", getpid());
@@ -9156,9 +10837,6 @@ vg_lite_error_t vg_lite_draw_linear_gradient(vg_lite_buffer_t * target,
                     fp = NULL;
 #endif
                 } else {
-                        format = convert_path_format(VG_LITE_FP32);
-                        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000200 | format | quality | tiling | 0x0));
-                        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, path->stroke_color));
                         push_data(ctx, path->stroke_path_size, path->stroke_path_data);
                 }
             }
@@ -9703,7 +11381,11 @@ vg_lite_error_t vg_lite_draw_radial_gradient(vg_lite_buffer_t * target,
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000400 | format | quality | tiling | fill));
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3B, 0x3F800000));      /* Path tessellation SCALE. */
     VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3C, 0x00000000));      /* Path tessellation BIAS.  */
-    /* Program matrix. */
+    /* Program matrix. Gradient draws have no solid color to patch. */
+    if (ctx->recording != NULL) {
+        VG_LITE_RETURN_ERROR(add_command_list_entry(ctx, 0, 0));
+        ctx->recording->entries[ctx->recording->entry_count - 1].matrix_offset = CMDBUF_OFFSET(*ctx);
+    }
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A40, (void *) &matrix->m[0][0]));
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A41, (void *) &matrix->m[0][1]));
     VG_LITE_RETURN_ERROR(push_state_ptr(ctx, 0x0A42, (void *) &matrix->m[0][2]));
@@ -9753,13 +11435,13 @@ vg_lite_error_t vg_lite_draw_radial_gradient(vg_lite_buffer_t * target,
         for (y = point_min.y; y < point_max.y; y += height) {
             for (x = point_min.x; x < point_max.x; x += width) {
                 /* Tessellate path. */
-                VG_LITE_RETURN_ERROR(push_stall(ctx, 15));
+                VG_LITE_RETURN_ERROR(push_tessellation_stall(ctx));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A1B, 0x00011000));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A01, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A39, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3D, tessellation_size / 64));
 
-                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1) {
+                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1 && ctx->recording == NULL) {
                     VG_LITE_RETURN_ERROR(push_call(ctx, path->uploaded.address, path->uploaded.bytes));
 #if  (DUMP_COMMAND)
                     if (strncmp(filename, "Commandbuffer", 13)) {
@@ -9807,17 +11489,24 @@ vg_lite_error_t vg_lite_draw_radial_gradient(vg_lite_buffer_t * target,
     }
     /* Setup tessellation loop. */
     if(path->path_type == VG_LITE_DRAW_STROKE_PATH || path->path_type == VG_LITE_DRAW_FILL_STROKE_PATH) {
+        /* The stroke color is programmed once for all tiles, so a recorded one can be patched in one place. */
+        if (ctx->recording != NULL) {
+            ctx->recording->entries[ctx->recording->entry_count - 1].stroke_color_offset = CMDBUF_OFFSET(*ctx) + 4;
+        }
+        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, path->stroke_color));
         for (y = point_min.y; y < point_max.y; y += height) {
             for (x = point_min.x; x < point_max.x; x += width) {
                 /* Tessellate path. */
-                VG_LITE_RETURN_ERROR(push_stall(ctx, 15));
+                VG_LITE_RETURN_ERROR(push_tessellation_stall(ctx));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A1B, 0x00011000));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A01, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A39, x | (y << 16)));
                 VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A3D, tessellation_size / 64));
 
-                if (VLM_PATH_GET_UPLOAD_BIT(*path) == 1) {
-                    VG_LITE_RETURN_ERROR(push_call(ctx, path->uploaded.address, path->uploaded.bytes));
+                format = convert_path_format(path->stroke_conversion ? path->stroke_conversion->stroke_path_format : VG_LITE_FP32);
+                VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000200 | format | quality | tiling | 0x0));
+                if (path->stroke_conversion != NULL && path->stroke_conversion->uploaded_handle != NULL && ctx->recording == NULL) {
+                    VG_LITE_RETURN_ERROR(push_call(ctx, path->stroke_conversion->uploaded_address, path->stroke_conversion->uploaded_bytes));
 #if  (DUMP_COMMAND)
                     if (strncmp(filename, "Commandbuffer", 13)) {
                         sprintf(filename, "Commandbuffer_pid%d.txt", getpid());
@@ -9857,9 +11546,6 @@ vg_lite_error_t vg_lite_draw_radial_gradient(vg_lite_buffer_t * target,
                     fp = NULL;
 #endif
                 } else {
-                        format = convert_path_format(VG_LITE_FP32);
-                        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A34, 0x01000200 | format | quality | tiling | 0x0));
-                        VG_LITE_RETURN_ERROR(push_state(ctx, 0x0A02, path->stroke_color));
                         push_data(ctx, path->stroke_path_size, path->stroke_path_data);
                 }
             }
@@ -10657,8 +12343,7 @@ vg_lite_error_t vg_lite_set_command_buffer_size(uint32_t size)
     }
     else{
 #else
-    if(CMDBUF_IN_QUEUE(&ctx->context, 0) ||
-            CMDBUF_IN_QUEUE(&ctx->context, 1))
+    if(has_queued_command_buffer(ctx))
         return VG_LITE_INVALID_ARGUMENT;
 #endif /* VG_DRIVER_SINGLE_THREAD */
 
@@ -10759,6 +12444,79 @@ vg_lite_error_t vg_lite_mem_avail(uint32_t *size)
     return error;
 }
 
+vg_lite_error_t vg_lite_mem_stats(vg_lite_mem_stats_t *stats)
+{
+    vg_lite_error_t error = VG_LITE_SUCCESS;
+    vg_lite_kernel_mem_t mem;
+
+    if (stats == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    VG_LITE_RETURN_ERROR(vg_lite_kernel(VG_LITE_QUERY_MEM,&mem));
+    stats->bytes_free   = mem.bytes;
+    stats->largest_free = mem.largest_free;
+    stats->free_blocks  = mem.free_blocks;
+    stats->used_blocks  = mem.used_blocks;
+
+    return error;
+}
+
+vg_lite_error_t vg_lite_get_path_cache_stats(vg_lite_path_cache_stats_t *stats)
+{
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    vg_lite_context_t *ctx = &s_context;
+#else
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t *tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if (tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    ctx = &tls->t_context;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+
+    if (stats == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    stats->hits      = ctx->path_cache_hits;
+    stats->misses    = ctx->path_cache_misses;
+    stats->uploads   = ctx->path_cache_uploads;
+    stats->evictions = ctx->path_cache_evictions;
+    stats->bytes     = ctx->path_cache_bytes;
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_get_state_stats(vg_lite_state_stats_t *stats)
+{
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    vg_lite_context_t *ctx = &s_context;
+#else
+    vg_lite_context_t *ctx;
+    vg_lite_tls_t *tls;
+
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if (tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    ctx = &tls->t_context;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+
+    if (stats == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+#if VG_STATE_SHADOW
+    stats->elided      = ctx->states_elided;
+    stats->coalesced   = ctx->states_coalesced;
+    stats->words_saved = ctx->state_words_saved;
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif /* VG_STATE_SHADOW */
+
+    return VG_LITE_SUCCESS;
+}
+
 vg_lite_error_t vg_lite_enable_premultiply(void)
 {
 #if defined(VG_DRIVER_SINGLE_THREAD)
@@ -10841,6 +12599,30 @@ vg_lite_error_t vg_lite_set_dither(int enable)
     return error;
 }
 
+vg_lite_error_t vg_lite_set_stall_elision(int enable)
+{
+#if VG_STALL_ELISION
+#if defined(VG_DRIVER_SINGLE_THREAD)
+    vg_lite_context_t *ctx = &s_context;
+#else
+    vg_lite_tls_t* tls;
+    vg_lite_context_t *ctx;
+    tls = (vg_lite_tls_t *) vg_lite_os_get_tls();
+    if(tls == NULL)
+        return VG_LITE_NO_CONTEXT;
+
+    ctx = &tls->t_context;
+#endif /* VG_DRIVER_SINGLE_THREAD */
+
+    ctx->stall_elision_off = !enable;
+    ctx->tessellation_idle = 0;
+
+    return VG_LITE_SUCCESS;
+#else
+    return VG_LITE_NOT_SUPPORT;
+#endif /* VG_STALL_ELISION */
+}
+
 vg_lite_error_t vg_lite_set_color_key(vg_lite_color_key4_t colorkey)
 {
     uint8_t i;
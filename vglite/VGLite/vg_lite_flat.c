@@ -32,12 +32,15 @@
 #endif
 
 #ifndef VG_CURVE_FLATTENING_TOLERANCE
-#define VG_CURVE_FLATTENING_TOLERANCE           0.25
+#define VG_CURVE_FLATTENING_TOLERANCE           0.25f
 #endif /* defined(VG_CURVE_FLATTENING_TOLERANCE) */
 
-#define FABSF(x)                                ((vg_lite_float_t) fabs(x))
-#define SQRTF(x)                                ((vg_lite_float_t) sqrt(x))
-#define CEILF(x)                                ((vg_lite_float_t) ceil(x))
+#define FABSF(x)                                ((vg_lite_float_t) fabsf(x))
+#define SQRTF(x)                                ((vg_lite_float_t) sqrtf(x))
+#define CEILF(x)                                ((vg_lite_float_t) ceilf(x))
+
+/* Number of curve points evaluated per batch. */
+#define FLATTEN_BATCH                           16
 
 #define VG_LITE_ERROR_HANDLER(func) \
 if ((error = func) != VG_LITE_SUCCESS) \
@@ -124,21 +127,30 @@ vg_lite_error_t _add_point_to_point_list_wdelta(
 
 
 /*
- * Evaluates the Bernstein polynomial that represents the curve, at 't'.
- * 't' should be a value between 0.0 and 1.0 (though it can be any float, but
- *      the relevant values are between 0 and 1).
- * 'x' and 'y' will contain the coordinates of the evaluated point.
+ * Evaluates the curve at 'count' values of 't' at once, 't' being between 0.0
+ * and 1.0. 'xy' receives the evaluated points as x/y pairs.
+ * The polynomial is expanded once so each point costs two multiply-adds per
+ * coordinate, all in single precision.
  */
-static void quad_bezier_eval(
+static void quad_bezier_eval_n(
     const quad_bezier_t *q,
-    vg_lite_float_t t,
-    vg_lite_float_t *x,
-    vg_lite_float_t *y
+    const vg_lite_float_t *t,
+    vg_lite_float_t *xy,
+    int count
     )
 {
-    const vg_lite_float_t omt = 1.0 - t;
-    *x = q->X0 * omt * omt + 2.0 * q->X1 * t * omt + q->X2 * t * t;
-    *y = q->Y0 * omt * omt + 2.0 * q->Y1 * t * omt + q->Y2 * t * t;
+    const vg_lite_float_t ax = q->X0 - 2.0f * q->X1 + q->X2;
+    const vg_lite_float_t ay = q->Y0 - 2.0f * q->Y1 + q->Y2;
+    const vg_lite_float_t bx = 2.0f * (q->X1 - q->X0);
+    const vg_lite_float_t by = 2.0f * (q->Y1 - q->Y0);
+    const vg_lite_float_t x0 = q->X0, y0 = q->Y0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        const vg_lite_float_t ti = t[i];
+        xy[2 * i]     = x0 + ti * (bx + ti * ax);
+        xy[2 * i + 1] = y0 + ti * (by + ti * ay);
+    }
 }
 
 /*
@@ -147,8 +159,8 @@ static void quad_bezier_eval(
  */
 static vg_lite_float_t approx_integral(vg_lite_float_t x)
 {
-    const vg_lite_float_t D = 0.67;
-    return x / (1.0 - D + FPOWF(FPOWF(D, 4) + 0.25 * x * x, 0.25));
+    const vg_lite_float_t D = 0.67f;
+    return x / (1.0f - D + FPOWF(FPOWF(D, 4.0f) + 0.25f * x * x, 0.25f));
 }
 
 /*
@@ -156,8 +168,8 @@ static vg_lite_float_t approx_integral(vg_lite_float_t x)
  */
 static vg_lite_float_t approx_inverse_integral(vg_lite_float_t x)
 {
-    const vg_lite_float_t B = 0.39;
-    return x * (1.0 - B + SQRTF(B * B + 0.25 * x * x));
+    const vg_lite_float_t B = 0.39f;
+    return x * (1.0f - B + SQRTF(B * B + 0.25f * x * x));
 }
 
 /*
@@ -165,8 +177,8 @@ static vg_lite_float_t approx_inverse_integral(vg_lite_float_t x)
  */
 static parabola_approx_t map_to_parabola(const quad_bezier_t *q)
 {
-    const vg_lite_float_t ddx = 2 * q->X1 - q->X0 - q->X2;
-    const vg_lite_float_t ddy = 2 * q->Y1 - q->Y0 - q->Y2;
+    const vg_lite_float_t ddx = 2.0f * q->X1 - q->X0 - q->X2;
+    const vg_lite_float_t ddy = 2.0f * q->Y1 - q->Y0 - q->Y2;
     const vg_lite_float_t u0 = (q->X1 - q->X0) * ddx + (q->Y1 - q->Y0) * ddy;
     const vg_lite_float_t u2 = (q->X2 - q->X1) * ddx + (q->Y2 - q->Y1) * ddy;
     const vg_lite_float_t cross = (q->X2 - q->X0) * ddy - (q->Y2 - q->Y0) * ddx;
@@ -182,6 +194,22 @@ static parabola_approx_t map_to_parabola(const quad_bezier_t *q)
     };
 }
 
+/*
+ * The tolerance is given in target pixels when the stroke knows the scale it
+ * will be drawn with, so convert it back into path coordinates.
+ */
+static vg_lite_float_t flatten_tolerance(
+    const vg_lite_stroke_conversion_t *stroke_conversion
+    )
+{
+    const vg_lite_float_t scale = stroke_conversion->flatten_scale;
+
+    if (scale > 0.0f)
+        return (vg_lite_float_t)VG_CURVE_FLATTENING_TOLERANCE / scale;
+
+    return (vg_lite_float_t)VG_CURVE_FLATTENING_TOLERANCE;
+}
+
 /*
  * Tolerance influences the number of lines generated. The lower the tolerance,
  * the more lines it generates, thus the flattening will have a higher quality,
@@ -199,7 +227,7 @@ static quad_bezier_flatten_params_t quad_bezier_flatten_params_init(
     const parabola_approx_t params = map_to_parabola(q);
     const vg_lite_float_t a0 = approx_integral(params.x0);
     const vg_lite_float_t a2 = approx_integral(params.x2);
-    const vg_lite_float_t count = 0.5 * FABSF(a2 - a0) * SQRTF(params.scale / tolerance);
+    const vg_lite_float_t count = 0.5f * FABSF(a2 - a0) * SQRTF(params.scale / tolerance);
     const int num_points = (int)CEILF(count);
     const vg_lite_float_t u0 = approx_inverse_integral(a0);
     const vg_lite_float_t u2 = approx_inverse_integral(a2);
@@ -214,31 +242,43 @@ static quad_bezier_flatten_params_t quad_bezier_flatten_params_init(
 }
 
 /*
- * Puts into (x, y) the coordinate to which a line should be drawn given the step.
- * This should be used in a loop to flatten a curve, like this:
+ * Adds the points of steps 'first' to 'last' - 1 to the point list, where step
+ * 'i' is the point a line should be drawn to after i / num_points of the curve.
+ * The points are computed in batches, like this:
  * ```
  * params = quad_bezier_flatten_params_init(&q, tolerance);
- * for (int i = 1; i < params.num_points; ++i) {
- *	vg_lite_float_t x, y;
- *	quad_bezier_flatten_at(&q, &params, i, &x, &y);
- *	draw_line_to(x, y);
- * }
+ * add_quad_bezier_points(stroke_conversion, &q, &params, 1, params.num_points);
  * ```
  */
-static void quad_bezier_flatten_at(
+static vg_lite_error_t add_quad_bezier_points(
+    vg_lite_stroke_conversion_t *stroke_conversion,
     const quad_bezier_t *q,
     const quad_bezier_flatten_params_t *params,
-    int step,
-    vg_lite_float_t *x,
-    vg_lite_float_t *y
+    int first,
+    int last
     )
 {
+    vg_lite_error_t error = VG_LITE_SUCCESS;
     const vg_lite_float_t a0 = params->a0, a2 = params->a2, u0 = params->u0, u2 = params->u2;
-    const int num_points = params->num_points;
-    const vg_lite_float_t u = approx_inverse_integral(a0 + ((a2 - a0) * step) / num_points);
-    const vg_lite_float_t t = (u - u0) / (u2 - u0);
+    const vg_lite_float_t step_a = (a2 - a0) / (vg_lite_float_t)params->num_points;
+    const vg_lite_float_t inv_u = 1.0f / (u2 - u0);
+    vg_lite_float_t t[FLATTEN_BATCH];
+    vg_lite_float_t xy[2 * FLATTEN_BATCH];
+    int step, count, i;
+
+    for (step = first; step < last; step += count) {
+        count = last - step < FLATTEN_BATCH ? last - step : FLATTEN_BATCH;
+
+        for (i = 0; i < count; i++)
+            t[i] = (approx_inverse_integral(a0 + step_a * (vg_lite_float_t)(step + i)) - u0) * inv_u;
+        quad_bezier_eval_n(q, t, xy, count);
 
-    quad_bezier_eval(q, t, x, y);
+        for (i = 0; i < count; i++)
+            VG_LITE_ERROR_HANDLER(_add_point_to_point_list(stroke_conversion, xy[2 * i], xy[2 * i + 1], vgcFLATTEN_MIDDLE));
+    }
+
+ErrorHandler:
+    return error;
 }
 
 vg_lite_error_t
@@ -254,9 +294,8 @@ _flatten_quad_bezier(
 {
     vg_lite_error_t error = VG_LITE_SUCCESS;
     vg_lite_path_point_ptr point0, point1;
-    vg_lite_float_t x, y;
+    quad_bezier_flatten_params_t params;
 
-    const vg_lite_float_t tolerance = VG_CURVE_FLATTENING_TOLERANCE;
     const quad_bezier_t q = {
         .X0 = X0,
         .Y0 = Y0,
@@ -265,11 +304,12 @@ _flatten_quad_bezier(
         .X2 = X2,
         .Y2 = Y2
     };
-    const quad_bezier_flatten_params_t params = quad_bezier_flatten_params_init(&q, tolerance);
 
     if(!stroke_conversion)
         return VG_LITE_INVALID_ARGUMENT;
 
+    params = quad_bezier_flatten_params_init(&q, flatten_tolerance(stroke_conversion));
+
     /* Add extra P0 for incoming tangent. */
     point0 = stroke_conversion->path_last_point;
     /* First add P1 to calculate incoming tangent, which is saved in P0. */
@@ -281,10 +321,7 @@ _flatten_quad_bezier(
     point1->y = Y0;
     point0->length = 0.0f;
 
-    for (int i = 1; i < params.num_points; ++i) {
-        quad_bezier_flatten_at(&q, &params, i, &x, &y);
-        _add_point_to_point_list(stroke_conversion, x, y, vgcFLATTEN_MIDDLE);
-    }
+    VG_LITE_ERROR_HANDLER(add_quad_bezier_points(stroke_conversion, &q, &params, 1, params.num_points));
 
     /* Add point 2 separately to avoid cumulative errors. */
     VG_LITE_ERROR_HANDLER(_add_point_to_point_list(stroke_conversion, X2, Y2, vgcFLATTEN_END));
@@ -310,34 +347,39 @@ ErrorHandler:
 }
 
 /*
- * Like eval_quad_bezier, computes the coordinates of the point which resides at
- * `t` for the cubic.
+ * Like quad_bezier_eval_n, evaluates the cubic at 'count' values of 't'.
  */
-static void cubic_bezier_eval(
+static void cubic_bezier_eval_n(
     const cubic_bezier_t *c,
-    vg_lite_float_t t,
-    vg_lite_float_t *x,
-    vg_lite_float_t *y
+    const vg_lite_float_t *t,
+    vg_lite_float_t *xy,
+    int count
     )
 {
-    const vg_lite_float_t omt = 1.0 - t;
-    const vg_lite_float_t omt2 = omt * omt;
-    const vg_lite_float_t omt3 = omt * omt2;
-    const vg_lite_float_t t2 = t * t;
-    const vg_lite_float_t t3 = t * t2;
-
-    *x = omt3 * c->X0 + 3.0 * t * omt2 * c->X1 + 3.0 * t2 * omt * c->X2 + t3 * c->X3;
-    *y = omt3 * c->Y0 + 3.0 * t * omt2 * c->Y1 + 3.0 * t2 * omt * c->Y2 + t3 * c->Y3;
+    const vg_lite_float_t ax = 3.0f * (c->X1 - c->X2) + c->X3 - c->X0;
+    const vg_lite_float_t ay = 3.0f * (c->Y1 - c->Y2) + c->Y3 - c->Y0;
+    const vg_lite_float_t bx = 3.0f * (c->X0 - 2.0f * c->X1 + c->X2);
+    const vg_lite_float_t by = 3.0f * (c->Y0 - 2.0f * c->Y1 + c->Y2);
+    const vg_lite_float_t cx = 3.0f * (c->X1 - c->X0);
+    const vg_lite_float_t cy = 3.0f * (c->Y1 - c->Y0);
+    const vg_lite_float_t x0 = c->X0, y0 = c->Y0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        const vg_lite_float_t ti = t[i];
+        xy[2 * i]     = x0 + ti * (cx + ti * (bx + ti * ax));
+        xy[2 * i + 1] = y0 + ti * (cy + ti * (by + ti * ay));
+    }
 }
 
 static quad_bezier_t cubic_bezier_derivative(const cubic_bezier_t *c)
 {
-    const vg_lite_float_t x0 = 3.0 * (c->X1 - c->X0);
-    const vg_lite_float_t y0 = 3.0 * (c->Y1 - c->Y0);
-    const vg_lite_float_t x1 = 3.0 * (c->X2 - c->X1);
-    const vg_lite_float_t y1 = 3.0 * (c->Y2 - c->Y1);
-    const vg_lite_float_t x2 = 3.0 * (c->X3 - c->X2);
-    const vg_lite_float_t y2 = 3.0 * (c->Y3 - c->Y2);
+    const vg_lite_float_t x0 = 3.0f * (c->X1 - c->X0);
+    const vg_lite_float_t y0 = 3.0f * (c->Y1 - c->Y0);
+    const vg_lite_float_t x1 = 3.0f * (c->X2 - c->X1);
+    const vg_lite_float_t y1 = 3.0f * (c->Y2 - c->Y1);
+    const vg_lite_float_t x2 = 3.0f * (c->X3 - c->X2);
+    const vg_lite_float_t y2 = 3.0f * (c->Y3 - c->Y2);
 
     return (quad_bezier_t) {
         .X0 = x0,
@@ -349,42 +391,6 @@ static quad_bezier_t cubic_bezier_derivative(const cubic_bezier_t *c)
     };
 }
 
-/*
- * Returns the cubic bezier that is between t0 and t1 of c.
- */
-static cubic_bezier_t cubic_bezier_split_at(
-    const cubic_bezier_t *c,
-    vg_lite_float_t t0,
-    vg_lite_float_t t1
-    )
-{
-    vg_lite_float_t p0x, p0y, p1x, p1y, p2x, p2y, p3x, p3y, d1x, d1y, d2x, d2y;
-    vg_lite_float_t scale;
-    quad_bezier_t derivative;
-
-    cubic_bezier_eval(c, t0, &p0x, &p0y);
-    cubic_bezier_eval(c, t1, &p3x, &p3y);
-    derivative = cubic_bezier_derivative(c);
-    scale = (t1 - t0) * (1.0 / 3.0);
-    quad_bezier_eval(&derivative, t0, &d1x, &d1y);
-    quad_bezier_eval(&derivative, t1, &d2x, &d2y);
-    p1x = p0x + scale * d1x;
-    p1y = p0y + scale * d1y;
-    p2x = p3x - scale * d2x;
-    p2y = p3y - scale * d2y;
-
-    return (cubic_bezier_t) {
-        .X0 = p0x,
-        .Y0 = p0y,
-        .X1 = p1x,
-        .Y1 = p1y,
-        .X2 = p2x,
-        .Y2 = p2y,
-        .X3 = p3x,
-        .Y3 = p3y
-    };
-}
-
 /*
  * This function returns the number of quadratic Bezier curves that are needed to
  * represent the given cubic, respecting the tolerance.
@@ -406,15 +412,15 @@ static int cubic_bezier_get_flatten_count(
     vg_lite_float_t tolerance
     )
 {
-    const vg_lite_float_t x = c->X0 - 3.0 * c->X1 + 3.0 * c->X2 - c->X3;
-    const vg_lite_float_t y = c->Y0 - 3.0 * c->Y1 + 3.0 * c->Y2 - c->Y3;
+    const vg_lite_float_t x = c->X0 - 3.0f * c->X1 + 3.0f * c->X2 - c->X3;
+    const vg_lite_float_t y = c->Y0 - 3.0f * c->Y1 + 3.0f * c->Y2 - c->Y3;
     const vg_lite_float_t err = x * x + y * y;
     vg_lite_float_t result;
 
-    result = FPOWF(err / (432.0 * tolerance * tolerance), 1.0 / 6.0);
+    result = FPOWF(err / (432.0f * tolerance * tolerance), 1.0f / 6.0f);
     result = CEILF(result);
 
-    return result > 1.0 ? (int)result : 1;
+    return result > 1.0f ? (int)result : 1;
 }
 
 vg_lite_error_t
@@ -442,17 +448,24 @@ _flatten_cubic_bezier(
         .X3 = X3,
         .Y3 = Y3
     };
-    const vg_lite_float_t tolerance = VG_CURVE_FLATTENING_TOLERANCE;
-    int num_curves = cubic_bezier_get_flatten_count(&c, tolerance);
-    vg_lite_float_t fnum_curves = (vg_lite_float_t)num_curves;
-    vg_lite_float_t fi, t0, t1, p1x, p1y, p2x, p2y, x, y;
-    cubic_bezier_t subsegment;
+    vg_lite_float_t tolerance;
+    int num_curves;
+    vg_lite_float_t fnum_curves, dt;
+    vg_lite_float_t t[FLATTEN_BATCH];
+    vg_lite_float_t pos[2 * FLATTEN_BATCH];
+    vg_lite_float_t der[2 * FLATTEN_BATCH];
+    quad_bezier_t derivative;
     quad_bezier_t current_curve;
     quad_bezier_flatten_params_t params;
+    int first, count, i;
 
     if(!stroke_conversion)
         return VG_LITE_INVALID_ARGUMENT;
 
+    tolerance = flatten_tolerance(stroke_conversion);
+    num_curves = cubic_bezier_get_flatten_count(&c, tolerance);
+    fnum_curves = (vg_lite_float_t)num_curves;
+
     /* Add extra P0 for incoming tangent. */
     point0 = stroke_conversion->path_last_point;
     /* First add P1/P2/P3 to calculate incoming tangent, which is saved in P0. */
@@ -474,27 +487,32 @@ _flatten_cubic_bezier(
     point1->y = Y0;
     point0->length = 0.0f;
 
-    for (int i = 0; i < num_curves; ++i) {
-        fi = (vg_lite_float_t)i;
-        t0 = fi / fnum_curves;
-        t1 = (fi + 1.0) / fnum_curves;
-        subsegment = cubic_bezier_split_at(&c, t0, t1);
-        p1x = 3.0 * subsegment.X1 - subsegment.X0;
-        p1y = 3.0 * subsegment.Y1 - subsegment.Y0;
-        p2x = 3.0 * subsegment.X2 - subsegment.X3;
-        p2y = 3.0 * subsegment.Y2 - subsegment.Y3;
-        current_curve = (quad_bezier_t) {
-            .X0 = subsegment.X0,
-            .Y0 = subsegment.Y0,
-            .X1 = (p1x + p2x) / 4.0,
-            .Y1 = (p1y + p2y) / 4.0,
-            .X2 = subsegment.X3,
-            .Y2 = subsegment.Y3
-        };
-        params = quad_bezier_flatten_params_init(&current_curve, tolerance);
-        for (int j = 0; j < params.num_points; ++j) {
-            quad_bezier_flatten_at(&current_curve, &params, j, &x, &y);
-            _add_point_to_point_list(stroke_conversion, x, y, vgcFLATTEN_MIDDLE);
+    /*
+     * Split the cubic evenly and approximate each piece with one quadratic,
+     * whose control point follows from the piece's end points and tangents.
+     * The piece boundaries are evaluated a batch at a time.
+     */
+    derivative = cubic_bezier_derivative(&c);
+    dt = 1.0f / fnum_curves;
+    for (first = 0; first < num_curves; first += count) {
+        count = num_curves - first < FLATTEN_BATCH - 1 ? num_curves - first : FLATTEN_BATCH - 1;
+
+        for (i = 0; i <= count; i++)
+            t[i] = (vg_lite_float_t)(first + i) / fnum_curves;
+        cubic_bezier_eval_n(&c, t, pos, count + 1);
+        quad_bezier_eval_n(&derivative, t, der, count + 1);
+
+        for (i = 0; i < count; i++) {
+            current_curve = (quad_bezier_t) {
+                .X0 = pos[2 * i],
+                .Y0 = pos[2 * i + 1],
+                .X1 = (2.0f * (pos[2 * i] + pos[2 * i + 2]) + dt * (der[2 * i] - der[2 * i + 2])) * 0.25f,
+                .Y1 = (2.0f * (pos[2 * i + 1] + pos[2 * i + 3]) + dt * (der[2 * i + 1] - der[2 * i + 3])) * 0.25f,
+                .X2 = pos[2 * i + 2],
+                .Y2 = pos[2 * i + 3]
+            };
+            params = quad_bezier_flatten_params_init(&current_curve, tolerance);
+            VG_LITE_ERROR_HANDLER(add_quad_bezier_points(stroke_conversion, &current_curve, &params, 0, params.num_points));
         }
     }
 
@@ -111,3 +111,38 @@ void vg_lite_rotate(vg_lite_float_t degrees, vg_lite_matrix_t * matrix)
     /* Multiply with current matrix. */
     multiply(matrix, &r);
 }
+
+void vg_lite_transform_points(vg_lite_matrix_t * matrix, const vg_lite_float_t * points,
+                              vg_lite_float_t * result, uint32_t count)
+{
+    /* Keep the matrix in locals so the loop does not reload it after every store. */
+    const vg_lite_float_t m00 = matrix->m[0][0], m01 = matrix->m[0][1], m02 = matrix->m[0][2];
+    const vg_lite_float_t m10 = matrix->m[1][0], m11 = matrix->m[1][1], m12 = matrix->m[1][2];
+    const vg_lite_float_t m20 = matrix->m[2][0], m21 = matrix->m[2][1], m22 = matrix->m[2][2];
+    vg_lite_float_t x, y, w;
+    uint32_t i;
+
+    if (m20 == 0.0f && m21 == 0.0f && m22 == 1.0f) {
+        /* Affine, no divide. */
+        for (i = 0; i < count; i++) {
+            x = points[2 * i];
+            y = points[2 * i + 1];
+            result[2 * i]     = x * m00 + y * m01 + m02;
+            result[2 * i + 1] = x * m10 + y * m11 + m12;
+        }
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        x = points[2 * i];
+        y = points[2 * i + 1];
+        w = x * m20 + y * m21 + m22;
+        if (w <= 0.0f) {
+            result[2 * i] = result[2 * i + 1] = 0.0f;
+            continue;
+        }
+        w = 1.0f / w;
+        result[2 * i]     = (x * m00 + y * m01 + m02) * w;
+        result[2 * i + 1] = (x * m10 + y * m11 + m12) * w;
+    }
+}
@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <math.h>
 #include "vg_lite.h"
 
 vg_lite_error_t vg_lite_upload_path(vg_lite_path_t * path)
@@ -351,3 +352,441 @@ vg_lite_error_t vg_lite_path_append(vg_lite_path_t *path,
 
     return error;
 }
+
+/* State of vg_lite_optimize_path. The same walk runs twice: the first pass
+   measures the optimized commands, the second one writes them. */
+typedef struct path_optimizer
+{
+    uint8_t             *out;
+    uint32_t            offset;
+    vg_lite_format_t    out_format;
+    int32_t             out_size;
+    uint8_t             write;
+
+    /* Largest coordinate size a merged line may need, 0 for no limit. */
+    int32_t             max_size;
+
+    /* Current and sub path start point of the optimized path. */
+    float               x, y;
+    float               start_x, start_y;
+
+    /* A MOVE or LINE held back so following commands can be merged into it. */
+    uint8_t             pending;
+    float               pending_x, pending_y;
+
+    /* Smallest integer coordinate size that holds all commands, 0 if a coordinate is not integral. */
+    int32_t             need_size;
+    float               bounds[4];
+    uint8_t             has_bounds;
+} path_optimizer_t;
+
+static float get_coordinate(uint8_t *data, vg_lite_format_t format)
+{
+    switch (format) {
+        case VG_LITE_S8:
+            return (float)*(int8_t *)data;
+
+        case VG_LITE_S16:
+            return (float)*(int16_t *)data;
+
+        case VG_LITE_S32:
+            return (float)*(int32_t *)data;
+
+        default:
+            return *(float *)data;
+    }
+}
+
+/* Bytes needed to store the values as integers, 0 if one of them is not an integer. */
+static int32_t get_integer_size(float *values, int32_t count)
+{
+    int32_t size = sizeof(int8_t), i;
+
+    for (i = 0; i < count; i++) {
+        if (values[i] < -2147483520.0f || values[i] > 2147483520.0f || (float)(int32_t)values[i] != values[i])
+            return 0;
+        if (values[i] < -32768.0f || values[i] > 32767.0f)
+            size = sizeof(int32_t);
+        else if ((values[i] < -128.0f || values[i] > 127.0f) && size < (int32_t)sizeof(int16_t))
+            size = sizeof(int16_t);
+    }
+
+    return size;
+}
+
+/* Compute the coordinates relative to the current point and the smaller integer size of both forms. */
+static int32_t get_command_size(path_optimizer_t *opt, float *coords, float *delta, int32_t count,
+                                int32_t *abs_size)
+{
+    int32_t rel_size, i;
+
+    for (i = 0; i < count; i++)
+        delta[i] = coords[i] - ((i & 1) ? opt->y : opt->x);
+
+    *abs_size = get_integer_size(coords, count);
+    rel_size = get_integer_size(delta, count);
+
+    return (rel_size && rel_size < *abs_size) ? rel_size : *abs_size;
+}
+
+static void optimizer_add_bounds(path_optimizer_t *opt, float x, float y)
+{
+    if (!opt->has_bounds) {
+        opt->bounds[0] = opt->bounds[2] = x;
+        opt->bounds[1] = opt->bounds[3] = y;
+        opt->has_bounds = 1;
+    }
+    else {
+        compute_pathbounds(&opt->bounds[0], &opt->bounds[1], &opt->bounds[2], &opt->bounds[3], x, y);
+    }
+}
+
+/* Add the extremes of one axis of a quadratic (count 3) or cubic (count 4) Bezier curve. */
+static void optimizer_add_curve_bounds(path_optimizer_t *opt, float *p, int32_t count, int32_t axis)
+{
+    float a, b, c, d, s, u, v, t[2];
+    int32_t roots = 0, i;
+
+    if (count == 3) {
+        a = p[0] - 2.0f * p[1] + p[2];
+        if (a != 0.0f)
+            t[roots++] = (p[0] - p[1]) / a;
+    }
+    else {
+        a = -p[0] + 3.0f * p[1] - 3.0f * p[2] + p[3];
+        b = 2.0f * (p[0] - 2.0f * p[1] + p[2]);
+        c = p[1] - p[0];
+        if (a == 0.0f) {
+            if (b != 0.0f)
+                t[roots++] = -c / b;
+        }
+        else {
+            d = b * b - 4.0f * a * c;
+            if (d >= 0.0f) {
+                s = sqrtf(d);
+                t[roots++] = (-b + s) / (2.0f * a);
+                t[roots++] = (-b - s) / (2.0f * a);
+            }
+        }
+    }
+
+    for (i = 0; i < roots; i++) {
+        if (t[i] <= 0.0f || t[i] >= 1.0f)
+            continue;
+        u = t[i];
+        v = 1.0f - u;
+        if (count == 3)
+            s = v * v * p[0] + 2.0f * u * v * p[1] + u * u * p[2];
+        else
+            s = v * v * v * p[0] + 3.0f * u * v * v * p[1] + 3.0f * u * u * v * p[2] + u * u * u * p[3];
+
+        if (axis == 0)
+            optimizer_add_bounds(opt, s, opt->bounds[1]);
+        else
+            optimizer_add_bounds(opt, opt->bounds[0], s);
+    }
+}
+
+/* Emit one command given in absolute coordinates. Integer formats use the relative form if
+   the absolute coordinates do not fit. */
+static void optimizer_emit(path_optimizer_t *opt, uint8_t opcode, float *coords, int32_t count)
+{
+    float delta[6], px[4], py[4];
+    int32_t abs_size, size, i;
+    uint8_t relative;
+
+    size = get_command_size(opt, coords, delta, count, &abs_size);
+    relative = count && opt->out_format != VG_LITE_FP32 && (!abs_size || abs_size > opt->out_size);
+
+    if (!opt->write) {
+        if (count && opt->need_size && (!size || size > opt->need_size))
+            opt->need_size = size;
+
+        /* Bounds of the drawn geometry, a MOVE only counts once something is drawn from it. */
+        if (count && opcode != VLC_OP_MOVE) {
+            optimizer_add_bounds(opt, opt->x, opt->y);
+            optimizer_add_bounds(opt, coords[count - 2], coords[count - 1]);
+            if (count > 2) {
+                px[0] = opt->x;
+                py[0] = opt->y;
+                for (i = 0; i < count; i += 2) {
+                    px[i / 2 + 1] = coords[i];
+                    py[i / 2 + 1] = coords[i + 1];
+                }
+                optimizer_add_curve_bounds(opt, px, count / 2 + 1, 0);
+                optimizer_add_curve_bounds(opt, py, count / 2 + 1, 1);
+            }
+        }
+    }
+    else {
+        opt->out[opt->offset] = relative ? (uint8_t)(opcode | 1) : opcode;
+    }
+    opt->offset++;
+
+    if (count) {
+        while (opt->offset & (opt->out_size - 1)) {
+            if (opt->write)
+                opt->out[opt->offset] = 0;
+            opt->offset++;
+        }
+        for (i = 0; i < count; i++, opt->offset += opt->out_size) {
+            if (!opt->write)
+                continue;
+            switch (opt->out_format) {
+                case VG_LITE_S8:
+                    *(int8_t *)(opt->out + opt->offset) = (int8_t)(relative ? delta[i] : coords[i]);
+                    break;
+
+                case VG_LITE_S16:
+                    *(int16_t *)(opt->out + opt->offset) = (int16_t)(relative ? delta[i] : coords[i]);
+                    break;
+
+                case VG_LITE_S32:
+                    *(int32_t *)(opt->out + opt->offset) = (int32_t)(relative ? delta[i] : coords[i]);
+                    break;
+
+                default:
+                    *(float *)(opt->out + opt->offset) = coords[i];
+                    break;
+            }
+        }
+    }
+
+    if (opcode == VLC_OP_MOVE) {
+        opt->start_x = coords[0];
+        opt->start_y = coords[1];
+    }
+    if (opcode == VLC_OP_CLOSE) {
+        opt->x = opt->start_x;
+        opt->y = opt->start_y;
+    }
+    else if (count) {
+        opt->x = coords[count - 2];
+        opt->y = coords[count - 1];
+    }
+}
+
+static void optimizer_flush(path_optimizer_t *opt)
+{
+    float coords[2];
+
+    if (opt->pending) {
+        coords[0] = opt->pending_x;
+        coords[1] = opt->pending_y;
+        optimizer_emit(opt, opt->pending, coords, 2);
+        opt->pending = 0;
+    }
+}
+
+/* Feed one command with absolute coordinates into the optimizer. */
+static void optimizer_add(path_optimizer_t *opt, uint8_t opcode, float *coords, int32_t count)
+{
+    float x, y, delta[2];
+    double cross, dot;
+    int32_t abs_size, size, i;
+
+    if (opcode == VLC_OP_MOVE) {
+        /* A MOVE directly followed by another one has no effect. */
+        if (opt->pending != VLC_OP_MOVE)
+            optimizer_flush(opt);
+        opt->pending = VLC_OP_MOVE;
+        opt->pending_x = coords[0];
+        opt->pending_y = coords[1];
+        return;
+    }
+
+    /* The point the command starts from. */
+    x = opt->pending ? opt->pending_x : opt->x;
+    y = opt->pending ? opt->pending_y : opt->y;
+
+    if (opcode == VLC_OP_LINE || opcode == VLC_OP_QUAD || opcode == VLC_OP_CUBIC) {
+        /* Drop segments that do not leave the current point. */
+        for (i = 0; i < count; i += 2) {
+            if (coords[i] != x || coords[i + 1] != y)
+                break;
+        }
+        if (i == count)
+            return;
+    }
+
+    if (opcode == VLC_OP_LINE) {
+        if (opt->pending == VLC_OP_LINE) {
+            /* Extend the held line if the new point continues it in the same direction. */
+            cross = ((double)opt->pending_x - opt->x) * ((double)coords[1] - y) -
+                    ((double)opt->pending_y - opt->y) * ((double)coords[0] - x);
+            dot = ((double)opt->pending_x - opt->x) * ((double)coords[0] - x) +
+                  ((double)opt->pending_y - opt->y) * ((double)coords[1] - y);
+            size = get_command_size(opt, coords, delta, 2, &abs_size);
+            if (cross == 0.0 && dot > 0.0 && (!opt->max_size || (size && size <= opt->max_size))) {
+                opt->pending_x = coords[0];
+                opt->pending_y = coords[1];
+                return;
+            }
+        }
+        optimizer_flush(opt);
+        opt->pending = VLC_OP_LINE;
+        opt->pending_x = coords[0];
+        opt->pending_y = coords[1];
+        return;
+    }
+
+    optimizer_flush(opt);
+    optimizer_emit(opt, opcode, coords, count);
+}
+
+static vg_lite_error_t optimize_path_pass(vg_lite_path_t *path, path_optimizer_t *opt)
+{
+    uint8_t *data = (uint8_t *)path->path;
+    int32_t offset = 0, data_size, count, i;
+    float coords[6];
+    float x = 0.0f, y = 0.0f, start_x = 0.0f, start_y = 0.0f;
+    uint8_t opcode;
+
+    data_size = get_data_size(path->format);
+    opt->offset = 0;
+    opt->x = opt->y = opt->start_x = opt->start_y = 0.0f;
+    opt->pending = 0;
+    if (!opt->write)
+        opt->has_bounds = 0;
+
+    while (offset < path->path_length) {
+        opcode = data[offset++];
+        count = get_data_count(opcode);
+        if (count < 0)
+            return VG_LITE_INVALID_ARGUMENT;
+        if (opcode >= VLC_OP_SCCWARC)
+            return VG_LITE_NOT_SUPPORT;
+
+        if (count > 0) {
+            offset = CDALIGN(offset, data_size);
+            if (offset + count * data_size > path->path_length)
+                return VG_LITE_INVALID_ARGUMENT;
+            for (i = 0; i < count; i++, offset += data_size) {
+                coords[i] = get_coordinate(data + offset, path->format);
+                /* Make relative coordinates absolute. */
+                if (opcode & 1)
+                    coords[i] += (i & 1) ? y : x;
+            }
+            opcode &= ~1;
+            x = coords[count - 2];
+            y = coords[count - 1];
+            if (opcode == VLC_OP_MOVE) {
+                start_x = x;
+                start_y = y;
+            }
+        }
+        else if (opcode == VLC_OP_CLOSE) {
+            x = start_x;
+            y = start_y;
+        }
+
+        optimizer_add(opt, opcode, coords, count);
+        if (opcode == VLC_OP_END)
+            break;
+    }
+    optimizer_flush(opt);
+
+    return VG_LITE_SUCCESS;
+}
+
+/* Free the GPU copy of a path once earlier draws are done with it. */
+static vg_lite_error_t free_path_upload(vg_lite_path_t *path)
+{
+    vg_lite_error_t error;
+    vg_lite_buffer_t buffer;
+    vg_lite_fence_t fence;
+
+    /* Arena uploads have no handle, they go away with their frame. */
+    if (path->uploaded.handle != NULL) {
+        error = vg_lite_fence_insert(&fence);
+        if (error == VG_LITE_SUCCESS)
+            error = vg_lite_fence_wait(&fence, VG_LITE_FENCE_INFINITE);
+        if (error != VG_LITE_SUCCESS)
+            return error;
+
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.handle = path->uploaded.handle;
+        error = vg_lite_free(&buffer);
+        if (error != VG_LITE_SUCCESS)
+            return error;
+    }
+    memset(&path->uploaded, 0, sizeof(path->uploaded));
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_optimize_path(vg_lite_path_t *path)
+{
+    vg_lite_error_t error;
+    path_optimizer_t opt;
+    int32_t data_size;
+
+    if (path == NULL || path->path == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+    if (path->path_length == 0)
+        return VG_LITE_SUCCESS;
+
+    data_size = get_data_size(path->format);
+
+    /* Measure the optimized path and the smallest format that holds it. */
+    memset(&opt, 0, sizeof(opt));
+    opt.out_format = VG_LITE_FP32;
+    opt.out_size = sizeof(float);
+    opt.need_size = sizeof(int8_t);
+    error = optimize_path_pass(path, &opt);
+    if (error != VG_LITE_SUCCESS)
+        return error;
+
+    if (path->format != VG_LITE_FP32 && opt.need_size > data_size) {
+        /* Merged lines outgrew the integer format, merge only as far as it allows. */
+        opt.max_size = data_size;
+        opt.need_size = sizeof(int8_t);
+        error = optimize_path_pass(path, &opt);
+        if (error != VG_LITE_SUCCESS)
+            return error;
+    }
+
+    switch (opt.need_size) {
+        case sizeof(int8_t):
+            opt.out_format = VG_LITE_S8;
+            break;
+
+        case sizeof(int16_t):
+            opt.out_format = VG_LITE_S16;
+            break;
+
+        default:
+            /* S32 is not smaller than FP32, keep the format. */
+            opt.out_format = path->format;
+            break;
+    }
+    if (get_data_size(opt.out_format) > data_size)
+        opt.out_format = path->format;
+    opt.out_size = get_data_size(opt.out_format);
+
+    /* Rewrite the path in place, no optimized command is longer than its source. */
+    opt.out = (uint8_t *)path->path;
+    opt.write = 1;
+    error = optimize_path_pass(path, &opt);
+    if (error != VG_LITE_SUCCESS)
+        return error;
+
+    /* The upload holds the old commands, draws must use the new ones. */
+    if (VLM_PATH_GET_UPLOAD_BIT(*path)) {
+        error = free_path_upload(path);
+        if (error != VG_LITE_SUCCESS)
+            return error;
+    }
+
+    path->format = opt.out_format;
+    path->path_length = opt.offset;
+    if (opt.has_bounds) {
+        path->bounding_box[0] = opt.bounds[0];
+        path->bounding_box[1] = opt.bounds[1];
+        path->bounding_box[2] = opt.bounds[2];
+        path->bounding_box[3] = opt.bounds[3];
+    }
+    path->path_changed = 1;
+
+    return VG_LITE_SUCCESS;
+}
@@ -29,6 +29,9 @@
 #include "vg_lite_hal.h"
 #include "vg_lite_hw.h"
 #include "vg_lite_os.h"
+#if VG_LITE_SIM
+#include "vg_lite_sim.h"
+#endif
 
 #if !_BAREMETAL
 #include "FreeRTOS.h"
@@ -67,42 +70,6 @@ void vg_lite_init_mem(uint32_t register_mem_base,
     heap_size       = contiguous_mem_size;
 }
 
-/* Implementation of list. ****************************************/
-typedef struct list_head {
-    struct list_head *next;
-    struct list_head *prev;
-}list_head_t;
-
-#define INIT_LIST_HEAD(entry) \
-        (entry)->next = (entry);\
-        (entry)->prev = (entry);
-
-/* Add the list item in front of "head". */
-static inline void add_list(list_head_t *to_add, list_head_t *head)
-{
-    /* Link the new item. */
-    to_add->next = head;
-    to_add->prev = head->prev;
-
-  /* Modify the neighbor. */
-    head->prev = to_add;
-    if (to_add->prev != NULL) {
-        to_add->prev->next = to_add;
-    }
-}
-
-/* Remove an entry out of the list. */
-static inline void delete_list(list_head_t *entry)
-{
-    if (entry->prev != NULL) {
-        entry->prev->next = entry->next;
-    }
-    if (entry->next != NULL) {
-        entry->next->prev = entry->prev;
-    }
-}
-
-/* End of list implementation. ***********/
 static inline void _memset(void *mem, unsigned char value, int size)
 {
     int i;
@@ -111,16 +78,34 @@ static inline void _memset(void *mem, unsigned char value, int size)
     }
 }
 
+/* Implementation of the heap. ************************************
+ * Two-level segregated fit: the first level splits the block sizes by power
+ * of two, the second level splits each power of two into HEAP_SL_COUNT
+ * ranges. Every class keeps a list of free blocks and a bit in the bitmaps,
+ * so allocation and free are O(1). The block header lives in the heap in
+ * front of the block, in a 64 byte slot of its own so that the returned
+ * memory stays 64 byte aligned. */
+#define HEAP_NODE_SIZE  64
+#define HEAP_FL_COUNT   32
+#define HEAP_SL_BITS    3
+#define HEAP_SL_COUNT   (1 << HEAP_SL_BITS)
+
 typedef struct heap_node {
-    list_head_t list; /* TODO: Linux specific, needs to rewrite. */
-    uint32_t offset;
-    unsigned long size;
+    struct heap_node *prev_phys;    /* Block right before this one, NULL for the first. */
+    uint32_t size;                  /* Block size including the header. */
     uint32_t status;
+    struct heap_node *prev_free;    /* Free list links, only valid while free. */
+    struct heap_node *next_free;
 }heap_node_t;
 
 struct memory_heap {
-    uint32_t free;
-    list_head_t list;
+    uint32_t free;                  /* Bytes in free blocks including their headers. */
+    uint32_t free_blocks;
+    uint32_t used_blocks;
+    uint8_t * end;
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[HEAP_FL_COUNT];
+    heap_node_t * free_list[HEAP_FL_COUNT][HEAP_SL_COUNT];
 };
 
 struct mapped_memory {
@@ -179,6 +164,8 @@ void vg_lite_hal_barrier(void)
      /*Memory barrier. */
 #if _BAREMETAL
      Xil_DCacheFlush();
+#elif VG_LITE_SIM
+    __sync_synchronize();
 #else
     __asm("DSB");
 #endif
@@ -203,179 +190,255 @@ void vg_lite_hal_deinitialize(void)
     /* TODO: Remove power. */
 }
 
-static int split_node(heap_node_t * node, unsigned long size)
+/* Index of the highest set bit, -1 for 0. */
+static inline int heap_fls(uint32_t word)
 {
-    /* TODO: the original is linux specific list based, needs rewrite.
-    */
-    heap_node_t * split;
+#if defined(__GNUC__)
+    return word ? 31 - __builtin_clz(word) : -1;
+#else
+    int bit = 31;
 
-    /*
-     * If the newly allocated object fits exactly the size of the free
-     * node, there is no need to split.
-     */
-    if (node->size - size == 0)
-        return 0;
+    if (word == 0)
+        return -1;
+    while ((word & (1u << bit)) == 0)
+        bit--;
+    return bit;
+#endif
+}
 
-    /* Allocate a new node. */
-    split = (heap_node_t *)vg_lite_os_malloc(sizeof(heap_node_t));
+/* Index of the lowest set bit, -1 for 0. */
+static inline int heap_ffs(uint32_t word)
+{
+    return heap_fls(word & (~word + 1));
+}
 
-    if (split == NULL)
-        return -1;
+static inline void heap_mapping(uint32_t size, int *fl, int *sl)
+{
+    *fl = heap_fls(size);
+    *sl = (int)(size >> (*fl - HEAP_SL_BITS)) & (HEAP_SL_COUNT - 1);
+}
 
-    /* Fill in the data of this node of the remaning size. */
-    split->offset = node->offset + size;
-    split->size = node->size - size;
-    split->status = 0;
+static inline heap_node_t * heap_next_phys(heap_node_t * node)
+{
+    uint8_t * next = (uint8_t *)node + node->size;
 
-    /* Add the new node behind the current node. */
-    add_list(&split->list, &node->list);
+    return next < device->heap.end ? (heap_node_t *)next : NULL;
+}
 
-    /* Adjust the size of the current node. */
-    node->size = size;
-    return 0;
+static void heap_insert_free(heap_node_t * node)
+{
+    heap_node_t * head;
+    int fl, sl;
+
+    heap_mapping(node->size, &fl, &sl);
+    head = device->heap.free_list[fl][sl];
+
+    node->status = 0;
+    node->prev_free = NULL;
+    node->next_free = head;
+    if (head != NULL)
+        head->prev_free = node;
+    device->heap.free_list[fl][sl] = node;
+
+    device->heap.fl_bitmap |= 1u << fl;
+    device->heap.sl_bitmap[fl] |= 1u << sl;
+    device->heap.free += node->size;
+    device->heap.free_blocks++;
+}
+
+static void heap_remove_free(heap_node_t * node)
+{
+    int fl, sl;
+
+    heap_mapping(node->size, &fl, &sl);
+
+    if (node->prev_free != NULL)
+        node->prev_free->next_free = node->next_free;
+    else
+        device->heap.free_list[fl][sl] = node->next_free;
+    if (node->next_free != NULL)
+        node->next_free->prev_free = node->prev_free;
+
+    if (device->heap.free_list[fl][sl] == NULL) {
+        device->heap.sl_bitmap[fl] &= ~(1u << sl);
+        if (device->heap.sl_bitmap[fl] == 0)
+            device->heap.fl_bitmap &= ~(1u << fl);
+    }
+    device->heap.free -= node->size;
+    device->heap.free_blocks--;
+}
+
+static heap_node_t * heap_find_free(uint32_t size)
+{
+    heap_node_t * node;
+    uint32_t sl_map, fl_map;
+    int fl, sl;
+
+    /* Round up to the next class, any block in it or above is big enough. */
+    heap_mapping(size + (1u << (heap_fls(size) - HEAP_SL_BITS)) - 1, &fl, &sl);
+
+    sl_map = device->heap.sl_bitmap[fl] & (~0u << sl);
+    if (sl_map == 0) {
+        fl_map = (fl + 1 < HEAP_FL_COUNT) ? device->heap.fl_bitmap & (~0u << (fl + 1)) : 0;
+        if (fl_map != 0) {
+            fl = heap_ffs(fl_map);
+            sl_map = device->heap.sl_bitmap[fl];
+        }
+    }
+    if (sl_map != 0)
+        return device->heap.free_list[fl][heap_ffs(sl_map)];
+
+    /* Only blocks of the request's own class are left, check them one by one. */
+    heap_mapping(size, &fl, &sl);
+    for (node = device->heap.free_list[fl][sl]; node != NULL; node = node->next_free) {
+        if (node->size >= size)
+            return node;
+    }
+    return NULL;
 }
 
 vg_lite_error_t vg_lite_hal_allocate_contiguous(unsigned long size, void ** logical, uint32_t * physical,void ** node)
 {
     unsigned long aligned_size;
-    heap_node_t * pos;
+    uint32_t block_size;
+    heap_node_t * pos, * split, * next;
 
     /* Align the size to 64 bytes. */
     aligned_size = (size + 63) & ~63;
+    block_size = aligned_size + HEAP_NODE_SIZE;
 
     /* Check if there is enough free memory available. */
-    if (aligned_size > device->heap.free) {
+    if (block_size > device->heap.free) {
         return VG_LITE_OUT_OF_MEMORY;
     }
 
-    /* Walk the heap backwards. */
-    for (pos = (heap_node_t*)device->heap.list.prev;
-                 &pos->list != &device->heap.list;
-                 pos = (heap_node_t*) pos->list.prev) {
-        /* Check if the current node is free and is big enough. */
-        if (pos->status == 0 && pos->size >= aligned_size) {
-            /* See if we the current node is big enough to split. */
-                if (0 != split_node(pos, aligned_size))
-                {
-                    return VG_LITE_OUT_OF_RESOURCES;
-                }
-            /* Mark the current node as used. */
-            pos->status = HEAP_NODE_USED;
-
-            /*  Return the logical/physical address. */
-            /* *logical = (uint8_t *) private_data->contiguous_mapped + pos->offset; */
-            *logical = (uint8_t *)device->virtual + pos->offset;
-            *physical = gpuMemBase + (uint32_t)(*logical);/* device->physical + pos->offset; */
-            device->heap.free -= aligned_size;
-
-            *node = pos;
-            return VG_LITE_SUCCESS;
-        }
+    pos = heap_find_free(block_size);
+    if (pos == NULL) {
+        /* Out of memory. */
+        return VG_LITE_OUT_OF_MEMORY;
+    }
+    heap_remove_free(pos);
+
+    /* Give the tail back to the heap if it can hold another allocation. */
+    if (pos->size - block_size >= HEAP_NODE_SIZE + 64) {
+        split = (heap_node_t *)((uint8_t *)pos + block_size);
+        split->size = pos->size - block_size;
+        split->prev_phys = pos;
+        pos->size = block_size;
+
+        next = heap_next_phys(split);
+        if (next != NULL)
+            next->prev_phys = split;
+        heap_insert_free(split);
     }
 
-    /* Out of memory. */
-    return VG_LITE_OUT_OF_MEMORY;
+    /* Mark the current node as used. */
+    pos->status = HEAP_NODE_USED;
+    device->heap.used_blocks++;
+
+    /*  Return the logical/physical address. */
+    *logical = (uint8_t *)pos + HEAP_NODE_SIZE;
+    *physical = gpuMemBase + (uint32_t)(*logical);/* device->physical + offset; */
+
+    *node = pos;
+    return VG_LITE_SUCCESS;
 }
 
 void vg_lite_hal_free_contiguous(void * memory_handle)
 {
-    /* TODO: no list available in RTOS. */
-    heap_node_t * pos, * node;
+    heap_node_t * node, * pos;
 
     /* Get pointer to node. */
     node = memory_handle;
 
-    if (node->status != HEAP_NODE_USED) {
+    if (node == NULL || node->status != HEAP_NODE_USED) {
         return;
     }
 
     /* Mark node as free. */
     node->status = 0;
+    device->heap.used_blocks--;
 
-    /* Add node size to free count. */
-    device->heap.free += node->size;
-
-    /* Check if next node is free. */
-    pos = node;
-    for (pos = (heap_node_t *)pos->list.next;
-         &pos->list != &device->heap.list;
-         pos = (heap_node_t *)pos->list.next) {
-        if (pos->status == 0) {
-            /* Merge the nodes. */
-            node->size += pos->size;
-            if(node->offset > pos->offset)
-                node->offset = pos->offset;
-            /* Delete the next node from the list. */
-            delete_list(&pos->list);
-            vg_lite_os_free(pos);
-        }
-        break;
+    /* Merge with the next node if it is free. */
+    pos = heap_next_phys(node);
+    if (pos != NULL && pos->status != HEAP_NODE_USED) {
+        heap_remove_free(pos);
+        node->size += pos->size;
     }
 
-    /* Check if the previous node is free. */
-    pos = node;
-    for (pos = (heap_node_t *)pos->list.prev;
-         &pos->list != &device->heap.list;
-         pos = (heap_node_t *)pos->list.prev) {
-        if (pos->status == 0) {
-            /* Merge the nodes. */
-            pos->size += node->size;
-            if(pos->offset > node->offset)
-                pos->offset = node->offset;
-            /* Delete the current node from the list. */
-            delete_list(&node->list);
-            vg_lite_os_free(node);
-        }
-        break;
-    }
-    /* when release command buffer node and ts buffer node to exit,release the linked list*/
-    if(device->heap.list.next == device->heap.list.prev) {
-        delete_list(&pos->list);
-        vg_lite_os_free(pos);
+    /* Merge with the previous node if it is free. */
+    pos = node->prev_phys;
+    if (pos != NULL && pos->status != HEAP_NODE_USED) {
+        heap_remove_free(pos);
+        pos->size += node->size;
+        node = pos;
     }
+
+    pos = heap_next_phys(node);
+    if (pos != NULL)
+        pos->prev_phys = node;
+    heap_insert_free(node);
 }
 
 void vg_lite_hal_free_os_heap(void)
 {
-    struct heap_node    *pos, *n;
-
-    /* Check for valid device. */
-    if (device != NULL) {
-        /* Process each node. */
-        for (pos = (heap_node_t *)device->heap.list.next,
-             n = (heap_node_t *)pos->list.next;
-             &pos->list != &device->heap.list;
-             pos = n, n = (heap_node_t *)n->list.next) {
-                /* Remove it from the linked list. */
-                delete_list(&pos->list);
-                /* Free up the memory. */
-                vg_lite_os_free(pos);
-        }
-    }
+    /* The heap keeps its nodes inside the contiguous memory, nothing to release. */
 }
 
 /* Portable: read register value. */
 uint32_t vg_lite_hal_peek(uint32_t address)
 {
+#if VG_LITE_SIM
+    return vg_lite_sim_peek(address);
+#else
     /* Read data from the GPU register. */
     return (uint32_t) (*(volatile uint32_t *) (device->gpu + address));
+#endif
 }
 
 /* Portable: write register. */
 void vg_lite_hal_poke(uint32_t address, uint32_t data)
 {
+#if VG_LITE_SIM
+    vg_lite_sim_poke(address, data);
+    /* The simulator completes in the calling task, not in an ISR, so use the task-context signal. */
+    if (vg_lite_sim_irq_pending())
+        vg_lite_os_signal_interrupt();
+#else
     /* Write data to the GPU register. */
     uint32_t *LocalAddr = (uint32_t *)(device->gpu + address);
     *LocalAddr = data;
+#endif
 }
 
 vg_lite_error_t vg_lite_hal_query_mem(vg_lite_kernel_mem_t *mem)
 {
+    heap_node_t * pos;
+    uint32_t largest = 0;
+    int fl;
+
     if(device != NULL){
-        mem->bytes  = device->heap.free;
+        /* The largest free block is in the highest non empty class. */
+        fl = heap_fls(device->heap.fl_bitmap);
+        if (fl >= 0) {
+            pos = device->heap.free_list[fl][heap_fls(device->heap.sl_bitmap[fl])];
+            for (; pos != NULL; pos = pos->next_free) {
+                if (pos->size > largest)
+                    largest = pos->size;
+            }
+            largest -= HEAP_NODE_SIZE;
+        }
+
+        mem->bytes        = device->heap.free - device->heap.free_blocks * HEAP_NODE_SIZE;
+        mem->largest_free = largest;
+        mem->free_blocks  = device->heap.free_blocks;
+        mem->used_blocks  = device->heap.used_blocks;
         return VG_LITE_SUCCESS;
     }
-    mem->bytes = 0;
+    mem->bytes        = 0;
+    mem->largest_free = 0;
+    mem->free_blocks  = 0;
+    mem->used_blocks  = 0;
     return VG_LITE_NO_CONTEXT;
 }
 
@@ -419,25 +482,11 @@ vg_lite_error_t vg_lite_hal_wait(uint32_t timeout, vg_lite_os_async_event_t *eve
 
 static void vg_lite_exit(void)
 {
-    heap_node_t * pos;
-    heap_node_t * n;
-
     /* Check for valid device. */
     if (device != NULL) {
         /* TODO: unmap register mem should be unnecessary. */
         device->gpu = 0;
 
-        /* Process each node. */
-        for (pos = (heap_node_t *)device->heap.list.next, n = (heap_node_t *)pos->list.next;
-             &pos->list != &device->heap.list;
-             pos = n, n = (heap_node_t *)n->list.next) {
-            /* Remove it from the linked list. */
-            delete_list(&pos->list);
-
-            /* Free up the memory. */
-            vg_lite_os_free(pos);
-        }
-
         /* Free up the device structure. */
         vg_lite_os_free(device);
     }
@@ -478,21 +527,22 @@ static int vg_lite_init(void)
     device->virtual = (void *)device->contiguous;
     device->physical = gpuMemBase + (uint32_t)device->virtual;
     device->size = device->heap_size;
+#if VG_LITE_SIM
+    vg_lite_sim_reset();
+    vg_lite_sim_map_memory(device->physical, device->virtual, device->size);
+#endif
 
-    /* Create the heap. */
-    INIT_LIST_HEAD(&device->heap.list);
-    device->heap.free = device->size;
-
-    node = (heap_node_t *)vg_lite_os_malloc(sizeof(heap_node_t));
-
-    if (node == NULL) {
+    /* Create the heap with one free block covering all of it. */
+    device->heap.end = (uint8_t *)device->virtual + (device->size & ~63);
+    if (device->size < HEAP_NODE_SIZE + 64) {
         vg_lite_exit();
         return -1;
     }
-    node->offset = 0;
-    node->size = device->size;
-    node->status = 0;
-    add_list(&node->list, &device->heap.list);
+
+    node = (heap_node_t *)device->virtual;
+    node->prev_phys = NULL;
+    node->size = device->size & ~63;
+    heap_insert_free(node);
 #if defined(VG_DRIVER_SINGLE_THREAD)
 #if !_BAREMETAL /*for rt500*/
         device->int_queue = xSemaphoreCreateBinary();
@@ -32,6 +32,11 @@
 
 #define _BAREMETAL 0
 
+/* Set to 1 to run the driver against the software GPU in vg_lite_sim.c instead of the hardware (host builds). */
+#ifndef VG_LITE_SIM
+#define VG_LITE_SIM 0
+#endif
+
 /*!
 @brief Initialize the hardware mem setting.
 */
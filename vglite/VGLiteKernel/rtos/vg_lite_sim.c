@@ -0,0 +1,918 @@
+/****************************************************************************
+*
+*    The MIT License (MIT)
+*
+*    Copyright (c) 2014 - 2020 Vivante Corporation
+*
+*    Permission is hereby granted, free of charge, to any person obtaining a
+*    copy of this software and associated documentation files (the "Software"),
+*    to deal in the Software without restriction, including without limitation
+*    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*    and/or sell copies of the Software, and to permit persons to whom the
+*    Software is furnished to do so, subject to the following conditions:
+*
+*    The above copyright notice and this permission notice shall be included in
+*    all copies or substantial portions of the Software.
+*
+*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+*    DEALINGS IN THE SOFTWARE.
+*
+*****************************************************************************/
+
+#include "vg_lite_platform.h"
+
+#if VG_LITE_SIM
+#include <string.h>
+#include <math.h>
+#include "vg_lite_hw.h"
+#include "vg_lite_sim.h"
+
+/* Identity reported by the simulator: GCNanoLiteV as found on i.MX RT1160/RT1170. */
+#define SIM_CHIP_ID             0x255
+#define SIM_CHIP_REV            0x1311
+#define SIM_CHIP_CID            0x404
+
+#define SIM_REG_COUNT           (0x1000 / 4)
+#define SIM_STATE_COUNT         0x1000
+#define SIM_CALL_DEPTH          4
+#define SIM_SOFT_RESET          (1 << 12)
+
+/* Command opcodes, see vg_lite.c. */
+#define SIM_OP_END              0x0
+#define SIM_OP_SEMAPHORE        0x1
+#define SIM_OP_STALL            0x2
+#define SIM_OP_STATE            0x3
+#define SIM_OP_DATA             0x4
+#define SIM_OP_CALL             0x6
+#define SIM_OP_RETURN           0x7
+#define SIM_OP_NOP              0x8
+
+/* Pixel layouts shared by source and target formats. */
+typedef enum sim_layout {
+    SIM_A8,
+    SIM_A4,
+    SIM_L8,
+    SIM_RGB565,
+    SIM_RGBX8888,
+    SIM_RGBA8888,
+    SIM_RGBA4444,
+    SIM_RGBA5551,
+    SIM_RGBA2222,
+    SIM_UNSUPPORTED
+} sim_layout_t;
+
+typedef struct sim_surface {
+    uint8_t *   memory;
+    uint32_t    stride;
+    int32_t     width;
+    int32_t     height;
+    sim_layout_t layout;
+    uint32_t    swizzle;
+} sim_surface_t;
+
+typedef struct sim_edge {
+    float x0, y0, x1, y1;
+} sim_edge_t;
+
+typedef struct sim_crossing {
+    float x;
+    int32_t dir;
+} sim_crossing_t;
+
+static struct {
+    uint32_t        regs[SIM_REG_COUNT];
+    uint32_t        states[SIM_STATE_COUNT];
+    uint32_t        intr_status;
+
+    uint32_t        physical;
+    uint8_t *       logical;
+    uint32_t        size;
+
+    sim_edge_t *    edges;
+    sim_crossing_t *crossings;
+    uint32_t        edge_count;
+    uint32_t        edge_capacity;
+    float *         coverage;
+    int32_t         coverage_width;
+
+    vg_lite_sim_stats_t stats;
+} sim;
+
+/* Channels from LSB to MSB for each swizzle: 0 = red, 1 = green, 2 = blue, 3 = alpha. */
+static const uint8_t sim_order[4][4] = {
+    { 2, 1, 0, 3 },     /* BGRA */
+    { 3, 2, 1, 0 },     /* ABGR */
+    { 0, 1, 2, 3 },     /* RGBA */
+    { 3, 0, 1, 2 },     /* ARGB */
+};
+
+static float sim_float(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void * sim_map(uint32_t address, uint32_t bytes)
+{
+    uint32_t offset = address - sim.physical;
+
+    if (sim.logical != NULL && offset < sim.size && bytes <= sim.size - offset)
+        return sim.logical + offset;
+#if UINTPTR_MAX == 0xFFFFFFFFu
+    /* Flat 32-bit host: the driver hands out CPU addresses. */
+    return (void *)(uintptr_t)address;
+#else
+    sim.stats.errors++;
+    return NULL;
+#endif
+}
+
+/*************** Pixel access *****************************************************/
+
+static uint32_t sim_channel_bits(sim_layout_t layout, uint32_t channel)
+{
+    switch (layout) {
+        case SIM_RGB565:
+            return (channel == 3) ? 0 : (channel == 1) ? 6 : 5;
+        case SIM_RGBX8888:
+        case SIM_RGBA8888:
+            return 8;
+        case SIM_RGBA4444:
+            return 4;
+        case SIM_RGBA5551:
+            return (channel == 3) ? 1 : 5;
+        case SIM_RGBA2222:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+static uint32_t sim_bytes_per_pixel(sim_layout_t layout)
+{
+    switch (layout) {
+        case SIM_RGBX8888:
+        case SIM_RGBA8888:
+            return 4;
+        case SIM_RGB565:
+        case SIM_RGBA4444:
+        case SIM_RGBA5551:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+static sim_layout_t sim_target_layout(uint32_t format)
+{
+    switch (format & 0xF) {
+        case 0x0: return SIM_A8;
+        case 0x1: return SIM_RGB565;
+        case 0x2: return SIM_RGBX8888;
+        case 0x3: return SIM_RGBA8888;
+        case 0x4: return SIM_RGBA4444;
+        case 0x5: return SIM_RGBA5551;
+        case 0x6: return SIM_L8;
+        case 0x7: return SIM_RGBA2222;
+        default:  return SIM_UNSUPPORTED;
+    }
+}
+
+static sim_layout_t sim_source_layout(uint32_t format)
+{
+    if ((format & 0xE00) == 0xA00)
+        return SIM_RGBA2222;
+    if (format & 0xE00)
+        return SIM_UNSUPPORTED;     /* Indexed formats need the CLUT, not simulated. */
+
+    switch (format & 0xF) {
+        case 0x0: return SIM_L8;
+        case 0x1: return SIM_A4;
+        case 0x2: return SIM_A8;
+        case 0x3: return SIM_RGBA4444;
+        case 0x4: return SIM_RGBA5551;
+        case 0x5: return SIM_RGB565;
+        case 0x6: return SIM_RGBX8888;
+        case 0x7: return SIM_RGBA8888;
+        default:  return SIM_UNSUPPORTED;
+    }
+}
+
+/* Read a pixel as straight RGBA in [0, 1]. */
+static void sim_read_pixel(const sim_surface_t * surface, int32_t x, int32_t y, float rgba[4])
+{
+    uint8_t * p = surface->memory + y * surface->stride;
+    uint32_t value = 0, shift = 0, i;
+
+    rgba[0] = rgba[1] = rgba[2] = rgba[3] = 1.0f;
+
+    switch (surface->layout) {
+        case SIM_A8:
+            rgba[3] = p[x] / 255.0f;
+            return;
+
+        case SIM_A4:
+            rgba[3] = ((p[x >> 1] >> ((x & 1) * 4)) & 0xF) / 15.0f;
+            return;
+
+        case SIM_L8:
+            rgba[0] = rgba[1] = rgba[2] = p[x] / 255.0f;
+            return;
+
+        default:
+            break;
+    }
+
+    p += x * sim_bytes_per_pixel(surface->layout);
+    for (i = 0; i < sim_bytes_per_pixel(surface->layout); i++)
+        value |= (uint32_t)p[i] << (i * 8);
+
+    for (i = 0; i < 4; i++) {
+        uint32_t channel = sim_order[surface->swizzle][i];
+        uint32_t bits = sim_channel_bits(surface->layout, channel);
+        uint32_t max = (1u << bits) - 1;
+
+        if (bits == 0)
+            continue;
+        if (surface->layout != SIM_RGBX8888 || channel != 3)
+            rgba[channel] = ((value >> shift) & max) / (float)max;
+        shift += bits;
+    }
+}
+
+/* Write a straight RGBA pixel in [0, 1]. */
+static void sim_write_pixel(const sim_surface_t * surface, int32_t x, int32_t y, const float rgba[4])
+{
+    uint8_t * p = surface->memory + y * surface->stride;
+    uint32_t value = 0, shift = 0, i;
+
+    switch (surface->layout) {
+        case SIM_A8:
+            p[x] = (uint8_t)(rgba[3] * 255.0f + 0.5f);
+            return;
+
+        case SIM_L8:
+            p[x] = (uint8_t)((0.2126f * rgba[0] + 0.7152f * rgba[1] + 0.0722f * rgba[2]) * 255.0f + 0.5f);
+            return;
+
+        case SIM_A4:
+        case SIM_UNSUPPORTED:
+            return;
+
+        default:
+            break;
+    }
+
+    for (i = 0; i < 4; i++) {
+        uint32_t channel = sim_order[surface->swizzle][i];
+        uint32_t bits = sim_channel_bits(surface->layout, channel);
+        uint32_t max = (1u << bits) - 1;
+        float c = (surface->layout == SIM_RGBX8888 && channel == 3) ? 1.0f : rgba[channel];
+
+        if (bits == 0)
+            continue;
+        value |= ((uint32_t)(c * max + 0.5f) & max) << shift;
+        shift += bits;
+    }
+
+    p += x * sim_bytes_per_pixel(surface->layout);
+    for (i = 0; i < sim_bytes_per_pixel(surface->layout); i++)
+        p[i] = (uint8_t)(value >> (i * 8));
+}
+
+/*************** Pixel engine *****************************************************/
+
+static int32_t sim_get_target(sim_surface_t * target)
+{
+    uint32_t clip = sim.states[0x0A13];
+
+    target->layout  = sim_target_layout(sim.states[0x0A10]);
+    target->swizzle = (sim.states[0x0A10] >> 4) & 3;
+    target->stride  = sim.states[0x0A12] & 0x0FFFFFFF;
+    target->width   = clip & 0xFFFF;
+    target->height  = clip >> 16;
+
+    if (target->layout == SIM_UNSUPPORTED || (sim.states[0x0A12] & 0x10000000)) {
+        /* YUV and tiled targets are not simulated. */
+        sim.stats.errors++;
+        return 0;
+    }
+
+    target->memory = (uint8_t *)sim_map(sim.states[0x0A11], target->stride * target->height);
+    return target->memory != NULL;
+}
+
+static int32_t sim_get_source(sim_surface_t * source)
+{
+    uint32_t size = sim.states[0x0A2F];
+    uint32_t origin_x = sim.states[0x0A2D] & 0xFFFF;
+    uint32_t origin_y = sim.states[0x0A2D] >> 16;
+
+    source->layout  = sim_source_layout(sim.states[0x0A25] & 0xE3F);
+    source->swizzle = (sim.states[0x0A25] >> 4) & 3;
+    source->stride  = sim.states[0x0A2B] & 0x0FFFFFFF;
+    source->width   = size & 0xFFFF;
+    source->height  = size >> 16;
+
+    if (source->layout == SIM_UNSUPPORTED || (sim.states[0x0A2B] & 0x10000000)) {
+        sim.stats.errors++;
+        return 0;
+    }
+
+    /* The image starts at the origin of the rectangle given to vg_lite_blit_rect. */
+    if (source->layout == SIM_A4 && (origin_x & 1)) {
+        sim.stats.errors++;
+        return 0;
+    }
+    source->memory = (uint8_t *)sim_map(sim.states[0x0A29], source->stride * (origin_y + source->height));
+    if (source->memory == NULL)
+        return 0;
+    source->memory += origin_y * source->stride;
+    source->memory += (source->layout == SIM_A4) ? origin_x / 2 : origin_x * sim_bytes_per_pixel(source->layout);
+    return 1;
+}
+
+/* Compute the premultiplied paint color of a pixel. Returns 0 if the pixel is not covered by the image. */
+static int32_t sim_paint(const sim_surface_t * source, int32_t x, int32_t y, float rgba[4])
+{
+    uint32_t color = sim.states[0x0A02];
+    uint32_t image_mode = sim.states[0x0A00] & 0x3000;
+
+    rgba[0] = (color & 0xFF) / 255.0f;
+    rgba[1] = ((color >> 8) & 0xFF) / 255.0f;
+    rgba[2] = ((color >> 16) & 0xFF) / 255.0f;
+    rgba[3] = (color >> 24) / 255.0f;
+
+    if (image_mode != 0 && source != NULL) {
+        float texel[4], u, v, w;
+        int32_t sx, sy, i;
+
+        /* Interpolation steps, see set_interpolation_steps() in vg_lite.c. */
+        u = sim_float(sim.states[0x0A18]) + x * sim_float(sim.states[0x0A1C]) + y * sim_float(sim.states[0x0A20]);
+        v = sim_float(sim.states[0x0A19]) + x * sim_float(sim.states[0x0A1D]) + y * sim_float(sim.states[0x0A21]);
+        w = sim_float(sim.states[0x0A1A]) + x * sim_float(sim.states[0x0A1E]) + y * sim_float(sim.states[0x0A22]);
+        if (w == 0.0f)
+            return 0;
+
+        sx = (int32_t)floorf(u / w * source->width);
+        sy = (int32_t)floorf(v / w * source->height);
+        if (sx < 0 || sy < 0 || sx >= source->width || sy >= source->height)
+            return 0;
+
+        sim_read_pixel(source, sx, sy, texel);
+        if (image_mode == 0x2000) {
+            for (i = 0; i < 4; i++)
+                rgba[i] *= texel[i];
+        } else {
+            for (i = 0; i < 4; i++)
+                rgba[i] = texel[i];
+        }
+    }
+
+    rgba[0] *= rgba[3];
+    rgba[1] *= rgba[3];
+    rgba[2] *= rgba[3];
+    return 1;
+}
+
+/* Blend a premultiplied source into the target, weighted by the pixel coverage. */
+static void sim_blend(const sim_surface_t * target, int32_t x, int32_t y, const float s[4], float coverage)
+{
+    float d[4], r[4];
+    int32_t i;
+
+    sim_read_pixel(target, x, y, d);
+    d[0] *= d[3];
+    d[1] *= d[3];
+    d[2] *= d[3];
+
+    for (i = 0; i < 4; i++) {
+        float sa = s[3], da = d[3];
+        switch ((sim.states[0x0A00] >> 8) & 0xF) {
+            case 0x1: r[i] = s[i] + (1.0f - sa) * d[i]; break;
+            case 0x2: r[i] = (1.0f - da) * s[i] + d[i]; break;
+            case 0x3: r[i] = da * s[i]; break;
+            case 0x4: r[i] = sa * d[i]; break;
+            case 0x5: r[i] = s[i] * (1.0f - da) + d[i] * (1.0f - sa) + s[i] * d[i]; break;
+            case 0x6: r[i] = s[i] + d[i] - s[i] * d[i]; break;
+            case 0x9: r[i] = s[i] + d[i]; break;
+            case 0xA: r[i] = d[i] * (1.0f - s[i]); break;
+            default:  r[i] = s[i]; break;
+        }
+        r[i] = d[i] + (r[i] - d[i]) * coverage;
+        r[i] = (r[i] < 0.0f) ? 0.0f : (r[i] > 1.0f) ? 1.0f : r[i];
+    }
+
+    /* Targets hold straight color. */
+    if (r[3] > 0.0f) {
+        r[0] /= r[3];
+        r[1] /= r[3];
+        r[2] /= r[3];
+    }
+    for (i = 0; i < 3; i++)
+        r[i] = (r[i] > 1.0f) ? 1.0f : r[i];
+
+    sim_write_pixel(target, x, y, r);
+    sim.stats.pixels++;
+}
+
+static void sim_rectangle(const uint16_t * rect)
+{
+    sim_surface_t target, source, * image = NULL;
+    int32_t x0 = (int16_t)rect[0], y0 = (int16_t)rect[1];
+    int32_t x1 = x0 + rect[2], y1 = y0 + rect[3];
+    int32_t x, y;
+    float rgba[4];
+
+    sim.stats.rectangles++;
+    if (!sim_get_target(&target))
+        return;
+    if ((sim.states[0x0A00] & 0x3000) != 0) {
+        if (!sim_get_source(&source))
+            return;
+        image = &source;
+    }
+
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > target.width) x1 = target.width;
+    if (y1 > target.height) y1 = target.height;
+
+    for (y = y0; y < y1; y++) {
+        for (x = x0; x < x1; x++) {
+            if (sim_paint(image, x, y, rgba))
+                sim_blend(&target, x, y, rgba, 1.0f);
+        }
+    }
+}
+
+/*************** Path rasterizer **************************************************/
+
+static int32_t sim_add_edge(float x0, float y0, float x1, float y1)
+{
+    if (y0 == y1)
+        return 1;
+
+    if (sim.edge_count == sim.edge_capacity) {
+        uint32_t capacity = sim.edge_capacity ? sim.edge_capacity * 2 : 256;
+        sim_edge_t * edges = (sim_edge_t *)realloc(sim.edges, capacity * sizeof(sim_edge_t));
+        sim_crossing_t * crossings = (sim_crossing_t *)realloc(sim.crossings, capacity * sizeof(sim_crossing_t));
+
+        if (edges != NULL)
+            sim.edges = edges;
+        if (crossings != NULL)
+            sim.crossings = crossings;
+        if (edges == NULL || crossings == NULL)
+            return 0;
+        sim.edge_capacity = capacity;
+    }
+
+    sim.edges[sim.edge_count].x0 = x0;
+    sim.edges[sim.edge_count].y0 = y0;
+    sim.edges[sim.edge_count].x1 = x1;
+    sim.edges[sim.edge_count].y1 = y1;
+    sim.edge_count++;
+    return 1;
+}
+
+static void sim_transform(float x, float y, float * tx, float * ty)
+{
+    *tx = sim_float(sim.states[0x0A40]) * x + sim_float(sim.states[0x0A41]) * y + sim_float(sim.states[0x0A42]);
+    *ty = sim_float(sim.states[0x0A43]) * x + sim_float(sim.states[0x0A44]) * y + sim_float(sim.states[0x0A45]);
+}
+
+/* Flatten a curve given in device space. Control points include the start point. */
+static void sim_add_curve(const float * px, const float * py, int32_t order)
+{
+    float length = 0.0f, x = px[0], y = py[0];
+    int32_t i, segments;
+
+    for (i = 1; i <= order; i++)
+        length += fabsf(px[i] - px[i - 1]) + fabsf(py[i] - py[i - 1]);
+    segments = (int32_t)sqrtf(length) + 1;
+    segments = (segments < 4) ? 4 : (segments > 64) ? 64 : segments;
+
+    for (i = 1; i <= segments; i++) {
+        float t = (float)i / segments, mt = 1.0f - t, nx, ny;
+
+        if (order == 2) {
+            nx = mt * mt * px[0] + 2 * mt * t * px[1] + t * t * px[2];
+            ny = mt * mt * py[0] + 2 * mt * t * py[1] + t * t * py[2];
+        } else {
+            nx = mt * mt * mt * px[0] + 3 * mt * mt * t * px[1] + 3 * mt * t * t * px[2] + t * t * t * px[3];
+            ny = mt * mt * mt * py[0] + 3 * mt * mt * t * py[1] + 3 * mt * t * t * py[2] + t * t * t * py[3];
+        }
+        sim_add_edge(x, y, nx, ny);
+        x = nx;
+        y = ny;
+    }
+}
+
+static float sim_path_value(const uint8_t * data, uint32_t format)
+{
+    float value;
+
+    switch (format) {
+        case 0:  value = *(const int8_t *)data; break;
+        case 1:  { int16_t v; memcpy(&v, data, 2); value = v; } break;
+        case 2:  { int32_t v; memcpy(&v, data, 4); value = (float)v; } break;
+        default: memcpy(&value, data, 4); break;
+    }
+
+    return value * sim_float(sim.states[0x0A3B]) + sim_float(sim.states[0x0A3C]);
+}
+
+/* Decode a path into device space edges, see vg_lite_path_calc_length() for the layout. */
+static void sim_build_edges(const uint8_t * data, uint32_t bytes, uint32_t format)
+{
+    static const int8_t counts[] = { 0, 0, 2, 2, 2, 2, 4, 4, 6, 6, 5, 5, 5, 5, 5, 5, 5, 5 };
+    uint32_t size = (format == 0) ? 1 : (format == 1) ? 2 : 4;
+    uint32_t offset = 0;
+    float start_x = 0, start_y = 0, cur_x = 0, cur_y = 0;
+    float dev_start_x, dev_start_y, dev_x, dev_y;
+    int32_t open = 0;
+
+    sim.edge_count = 0;
+    sim_transform(0, 0, &dev_x, &dev_y);
+    dev_start_x = dev_x;
+    dev_start_y = dev_y;
+
+    while (offset < bytes) {
+        uint8_t op = data[offset++];
+        float v[6], px[4], py[4];
+        int32_t i, count, relative;
+
+        if (op == 0x00 || op >= sizeof(counts))
+            break;
+
+        count = counts[op];
+        if (count > 0) {
+            offset = (offset + size - 1) & ~(size - 1);
+            if (offset + count * size > bytes)
+                break;
+        }
+        for (i = 0; i < count; i++, offset += size)
+            v[i] = sim_path_value(data + offset, format);
+
+        relative = (op & 1) && op != 0x01;
+        if (relative && count == 5) {
+            /* Only the end point of an arc is relative. */
+            v[3] += cur_x;
+            v[4] += cur_y;
+        } else if (relative) {
+            for (i = 0; i < count; i += 2) {
+                v[i] += cur_x;
+                v[i + 1] += cur_y;
+            }
+        }
+
+        switch (op) {
+            case 0x01:  /* CLOSE */
+                if (open)
+                    sim_add_edge(dev_x, dev_y, dev_start_x, dev_start_y);
+                cur_x = start_x;
+                cur_y = start_y;
+                dev_x = dev_start_x;
+                dev_y = dev_start_y;
+                open = 0;
+                break;
+
+            case 0x02:  /* MOVE */
+            case 0x03:
+                if (open)
+                    sim_add_edge(dev_x, dev_y, dev_start_x, dev_start_y);
+                start_x = cur_x = v[0];
+                start_y = cur_y = v[1];
+                sim_transform(cur_x, cur_y, &dev_x, &dev_y);
+                dev_start_x = dev_x;
+                dev_start_y = dev_y;
+                open = 0;
+                break;
+
+            case 0x06:  /* QUAD */
+            case 0x07:
+            case 0x08:  /* CUBIC */
+            case 0x09:
+                px[0] = dev_x;
+                py[0] = dev_y;
+                for (i = 0; i < count / 2; i++)
+                    sim_transform(v[2 * i], v[2 * i + 1], &px[i + 1], &py[i + 1]);
+                sim_add_curve(px, py, count / 2);
+                cur_x = v[count - 2];
+                cur_y = v[count - 1];
+                dev_x = px[count / 2];
+                dev_y = py[count / 2];
+                open = 1;
+                break;
+
+            default:    /* LINE; arcs are expected to be converted by the driver, treat them as lines. */
+                if (count == 5) {
+                    cur_x = v[3];
+                    cur_y = v[4];
+                } else {
+                    cur_x = v[0];
+                    cur_y = v[1];
+                }
+                sim_transform(cur_x, cur_y, &px[0], &py[0]);
+                sim_add_edge(dev_x, dev_y, px[0], py[0]);
+                dev_x = px[0];
+                dev_y = py[0];
+                open = 1;
+                break;
+        }
+    }
+
+    if (open)
+        sim_add_edge(dev_x, dev_y, dev_start_x, dev_start_y);
+}
+
+static void sim_path(const uint8_t * data, uint32_t bytes)
+{
+    sim_surface_t target, source, * image = NULL;
+    uint32_t control = sim.states[0x0A34];
+    uint32_t origin = sim.states[0x0A39];
+    uint32_t tile = sim.states[0x0A3A];
+    int32_t even_odd = (control & 0x10) != 0;
+    int32_t samples, x0, y0, x1, y1, x, y, s;
+    uint32_t i;
+    float weight, min_y, max_y, rgba[4];
+
+    sim.stats.paths++;
+    if (!sim_get_target(&target))
+        return;
+    if ((sim.states[0x0A00] & 0x3000) != 0) {
+        if (!sim_get_source(&source))
+            return;
+        image = &source;
+    }
+
+    sim_build_edges(data, bytes, (control >> 20) & 0x3);
+    if (sim.edge_count == 0)
+        return;
+
+    /* Sample grid per pixel from the path quality. */
+    switch (control & 0x3) {
+        case 0x3:
+        case 0x2:
+            samples = 4;
+            break;
+        case 0x1:
+            samples = 2;
+            break;
+        default:
+            samples = 1;
+            break;
+    }
+    weight = 1.0f / (samples * samples);
+
+    /* Restrict to the current tessellation tile, the clip and the path extent. */
+    x0 = origin & 0xFFFF;
+    y0 = origin >> 16;
+    x1 = x0 + (int32_t)(tile & 0xFFFF);
+    y1 = y0 + (int32_t)(tile >> 16);
+    if (x1 > target.width) x1 = target.width;
+    if (y1 > target.height) y1 = target.height;
+
+    min_y = max_y = sim.edges[0].y0;
+    for (i = 0; i < sim.edge_count; i++) {
+        min_y = fminf(min_y, fminf(sim.edges[i].y0, sim.edges[i].y1));
+        max_y = fmaxf(max_y, fmaxf(sim.edges[i].y0, sim.edges[i].y1));
+    }
+    if (y0 < (int32_t)floorf(min_y)) y0 = (int32_t)floorf(min_y);
+    if (y1 > (int32_t)ceilf(max_y)) y1 = (int32_t)ceilf(max_y);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    if (sim.coverage_width < x1) {
+        float * coverage = (float *)realloc(sim.coverage, x1 * sizeof(float));
+        if (coverage == NULL)
+            return;
+        sim.coverage = coverage;
+        sim.coverage_width = x1;
+    }
+
+    for (y = y0; y < y1; y++) {
+        memset(sim.coverage + x0, 0, (x1 - x0) * sizeof(float));
+
+        for (s = 0; s < samples; s++) {
+            float sy = y + (s + 0.5f) / samples;
+            uint32_t count = 0, j;
+            int32_t winding = 0;
+
+            /* Collect and sort the crossings of this sample row. */
+            for (i = 0; i < sim.edge_count; i++) {
+                const sim_edge_t * e = &sim.edges[i];
+                sim_crossing_t c;
+
+                if ((e->y0 <= sy && sy < e->y1) || (e->y1 <= sy && sy < e->y0)) {
+                    c.x = e->x0 + (sy - e->y0) * (e->x1 - e->x0) / (e->y1 - e->y0);
+                    c.dir = (e->y1 > e->y0) ? 1 : -1;
+                    for (j = count; j > 0 && sim.crossings[j - 1].x > c.x; j--)
+                        sim.crossings[j] = sim.crossings[j - 1];
+                    sim.crossings[j] = c;
+                    count++;
+                }
+            }
+
+            /* Accumulate sample coverage of the inside spans. */
+            for (i = 0; i + 1 < count; i++) {
+                int32_t k0, k1, k;
+
+                winding += sim.crossings[i].dir;
+                if (even_odd ? ((winding & 1) == 0) : (winding == 0))
+                    continue;
+
+                k0 = (int32_t)ceilf(sim.crossings[i].x * samples - 0.5f);
+                k1 = (int32_t)ceilf(sim.crossings[i + 1].x * samples - 0.5f);
+                if (k0 < x0 * samples) k0 = x0 * samples;
+                if (k1 > x1 * samples) k1 = x1 * samples;
+                for (k = k0; k < k1; k++)
+                    sim.coverage[k / samples] += weight;
+            }
+        }
+
+        for (x = x0; x < x1; x++) {
+            if (sim.coverage[x] > 0.0f && sim_paint(image, x, y, rgba))
+                sim_blend(&target, x, y, rgba, fminf(sim.coverage[x], 1.0f));
+        }
+    }
+}
+
+/*************** Command processor ************************************************/
+
+static void sim_data(const uint8_t * data, uint32_t bytes)
+{
+    if (sim.states[0x0A34] != 0) {
+        /* Tessellation enabled: the data is path data. */
+        sim_path(data, bytes);
+    } else if ((sim.states[0x0A00] & 0x1) && bytes >= 8) {
+        sim_rectangle((const uint16_t *)data);
+    }
+}
+
+static void sim_execute(uint32_t address, uint32_t bytes)
+{
+    struct {
+        const uint32_t * cmd;
+        const uint32_t * end;
+    } stack[SIM_CALL_DEPTH];
+    const uint32_t * cmd = (const uint32_t *)sim_map(address, bytes);
+    const uint32_t * end = cmd + bytes / 4;
+    int32_t depth = 0;
+
+    while (cmd != NULL && cmd + 2 <= end) {
+        uint32_t op = cmd[0];
+        uint32_t count, i;
+
+        sim.stats.commands++;
+        switch (op >> 28) {
+            case SIM_OP_END:
+                sim.intr_status |= 1u << (op & 0x1F);
+                return;
+
+            case SIM_OP_STALL:
+                sim.stats.stalls++;
+                /* fall through */
+            case SIM_OP_SEMAPHORE:
+            case SIM_OP_NOP:
+                /* Execution is in order, nothing to wait for. */
+                cmd += 2;
+                break;
+
+            case SIM_OP_STATE:
+                count = (op >> 16) & 0xFFF;
+                if (cmd + 1 + count > end) {
+                    sim.stats.errors++;
+                    return;
+                }
+                for (i = 0; i < count; i++)
+                    sim.states[((op & 0xFFFF) + i) & (SIM_STATE_COUNT - 1)] = cmd[1 + i];
+                sim.stats.states += count;
+                cmd += (count + 2) & ~1;
+                break;
+
+            case SIM_OP_DATA:
+                count = op & 0x0FFFFFFF;
+                if (cmd + 2 + count * 2 > end) {
+                    sim.stats.errors++;
+                    return;
+                }
+                sim_data((const uint8_t *)(cmd + 2), count * 8);
+                cmd += 2 + count * 2;
+                break;
+
+            case SIM_OP_CALL:
+                if (depth == SIM_CALL_DEPTH) {
+                    sim.stats.errors++;
+                    return;
+                }
+                stack[depth].cmd = cmd + 2;
+                stack[depth].end = end;
+                depth++;
+                count = op & 0x0FFFFFFF;
+                cmd = (const uint32_t *)sim_map(cmd[1], count * 8);
+                end = cmd + count * 2;
+                break;
+
+            case SIM_OP_RETURN:
+                if (depth == 0)
+                    return;
+                depth--;
+                cmd = stack[depth].cmd;
+                end = stack[depth].end;
+                break;
+
+            default:
+                sim.stats.errors++;
+                return;
+        }
+    }
+}
+
+/*************** Register file ****************************************************/
+
+void vg_lite_sim_reset(void)
+{
+    memset(sim.regs, 0, sizeof(sim.regs));
+    memset(sim.states, 0, sizeof(sim.states));
+    sim.intr_status = 0;
+}
+
+void vg_lite_sim_map_memory(uint32_t physical, void * logical, uint32_t size)
+{
+    sim.physical = physical;
+    sim.logical  = (uint8_t *)logical;
+    sim.size     = size;
+}
+
+uint32_t vg_lite_sim_peek(uint32_t address)
+{
+    uint32_t value;
+
+    switch (address) {
+        case VG_LITE_HW_IDLE:
+            /* Command buffers execute synchronously, the GPU is always idle. */
+            return VG_LITE_HW_IDLE_STATE;
+
+        case VG_LITE_INTR_STATUS:
+            /* Read to clear. */
+            value = sim.intr_status;
+            sim.intr_status = 0;
+            return value;
+
+        case VG_LITE_HW_CHIP_ID:
+            return SIM_CHIP_ID;
+
+        case 0x24:
+            return SIM_CHIP_REV;
+
+        case 0x30:
+            return SIM_CHIP_CID;
+
+        default:
+            return sim.regs[(address >> 2) & (SIM_REG_COUNT - 1)];
+    }
+}
+
+void vg_lite_sim_poke(uint32_t address, uint32_t data)
+{
+    sim.regs[(address >> 2) & (SIM_REG_COUNT - 1)] = data;
+
+    switch (address) {
+        case VG_LITE_HW_CLOCK_CONTROL:
+            if (data & SIM_SOFT_RESET) {
+                memset(sim.states, 0, sizeof(sim.states));
+                sim.intr_status = 0;
+            }
+            break;
+
+        case VG_LITE_HW_CMDBUF_SIZE:
+            sim.stats.submits++;
+            sim_execute(sim.regs[VG_LITE_HW_CMDBUF_ADDRESS >> 2], data * 8);
+            break;
+
+        default:
+            break;
+    }
+}
+
+int32_t vg_lite_sim_irq_pending(void)
+{
+    return (sim.intr_status & sim.regs[VG_LITE_INTR_ENABLE >> 2]) != 0;
+}
+
+void vg_lite_sim_get_stats(vg_lite_sim_stats_t * stats, int32_t reset)
+{
+    if (stats != NULL)
+        *stats = sim.stats;
+    if (reset)
+        memset(&sim.stats, 0, sizeof(sim.stats));
+}
+
+#endif /* VG_LITE_SIM */
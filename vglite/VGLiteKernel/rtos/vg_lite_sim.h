@@ -0,0 +1,103 @@
+/****************************************************************************
+*
+*    The MIT License (MIT)
+*
+*    Copyright (c) 2014 - 2020 Vivante Corporation
+*
+*    Permission is hereby granted, free of charge, to any person obtaining a
+*    copy of this software and associated documentation files (the "Software"),
+*    to deal in the Software without restriction, including without limitation
+*    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*    and/or sell copies of the Software, and to permit persons to whom the
+*    Software is furnished to do so, subject to the following conditions:
+*
+*    The above copyright notice and this permission notice shall be included in
+*    all copies or substantial portions of the Software.
+*
+*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+*    DEALINGS IN THE SOFTWARE.
+*
+*****************************************************************************/
+
+#ifndef _vg_lite_sim_h_
+#define _vg_lite_sim_h_
+
+#include "vg_lite_platform.h"
+
+#if VG_LITE_SIM
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+@brief Counters maintained by the GPU simulator.
+*/
+typedef struct vg_lite_sim_stats {
+    uint32_t submits;       /* Command buffers kicked off through VG_LITE_HW_CMDBUF_SIZE. */
+    uint32_t commands;      /* Command words decoded, including called buffers. */
+    uint32_t states;        /* State registers written. */
+    uint32_t stalls;        /* Pipeline stalls, each following a semaphore. */
+    uint32_t rectangles;    /* Rectangle primitives (clear, blit). */
+    uint32_t paths;         /* Path primitives, one per tessellation tile. */
+    uint32_t pixels;        /* Pixels written into render targets. */
+    uint32_t errors;        /* Malformed commands or unmapped GPU addresses. */
+} vg_lite_sim_stats_t;
+
+/*!
+@brief Reset the simulated register file and the state table.
+*/
+void vg_lite_sim_reset(void);
+
+/*!
+@brief Make a range of GPU addresses visible to the simulator.
+
+@discussion
+The simulator translates every GPU address found in the command stream (command buffers, uploaded paths,
+render targets and images) through this window. Addresses outside of it are only accepted on 32-bit hosts
+where GPU and CPU addresses are identical.
+*/
+void vg_lite_sim_map_memory(uint32_t physical, void * logical, uint32_t size);
+
+/*!
+@brief Read a simulated GPU register.
+*/
+uint32_t vg_lite_sim_peek(uint32_t address);
+
+/*!
+@brief Write a simulated GPU register.
+
+@discussion
+Writing VG_LITE_HW_CMDBUF_SIZE executes the command buffer programmed in VG_LITE_HW_CMDBUF_ADDRESS to completion
+before returning.
+*/
+void vg_lite_sim_poke(uint32_t address, uint32_t data);
+
+/*!
+@brief Check whether an enabled interrupt is waiting to be delivered.
+*/
+int32_t vg_lite_sim_irq_pending(void);
+
+/*!
+@brief Query the simulator counters.
+
+@param stats
+Receives the counters accumulated since the last reset.
+
+@param reset
+Non-zero to clear the counters after reading them.
+*/
+void vg_lite_sim_get_stats(vg_lite_sim_stats_t * stats, int32_t reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VG_LITE_SIM */
+
+#endif /* _vg_lite_sim_h_ */
@@ -571,6 +571,7 @@ static vg_lite_error_t do_initialize(vg_lite_kernel_initialize_t * data)
 static vg_lite_error_t terminate_vglite(vg_lite_kernel_terminate_t * data)
 {
     vg_lite_kernel_context_t *context = NULL;
+    int32_t i;
 #if defined(__linux__) && !EMULATOR
     vg_lite_kernel_context_t mycontext = {0};
     if (copy_from_user(&mycontext, data->context, sizeof(vg_lite_kernel_context_t)) != 0) {
@@ -582,16 +583,12 @@ static vg_lite_error_t terminate_vglite(vg_lite_kernel_terminate_t * data)
 #endif
 
     /* Free any allocated memory for the context. */
-    if (context->command_buffer[0]) {
-        /* Free the command buffer. */
-        vg_lite_hal_free_contiguous(context->command_buffer[0]);
-        context->command_buffer[0] = NULL;
-    }
-
-    if (context->command_buffer[1]) {
-        /* Free the command buffer. */
-        vg_lite_hal_free_contiguous(context->command_buffer[1]);
-        context->command_buffer[1] = NULL;
+    for (i = 0; i < CMDBUF_COUNT; i++) {
+        if (context->command_buffer[i]) {
+            /* Free the command buffer. */
+            vg_lite_hal_free_contiguous(context->command_buffer[i]);
+            context->command_buffer[i] = NULL;
+        }
     }
 
     if (context->tessellation_buffer) {
@@ -634,28 +631,20 @@ static vg_lite_error_t terminate_vglite(vg_lite_kernel_terminate_t * data)
 #endif
 
     /* Free any allocated memory for the context. */
-    if (context->command_buffer[0]) {
-        /* Free the command buffer. */
-        vg_lite_hal_free_contiguous(context->command_buffer[0]);
-        context->command_buffer[0] = NULL;
-    }
-
-    if (context->command_buffer[1]) {
-        /* Free the command buffer. */
-        vg_lite_hal_free_contiguous(context->command_buffer[1]);
-        context->command_buffer[1] = NULL;
-    }
-
-    if (context->context_buffer[0]) {
-        /* Free the context buffer. */
-        vg_lite_hal_free_contiguous(context->context_buffer[0]);
-        context->context_buffer[0] = NULL;
+    for (i = 0; i < CMDBUF_COUNT; i++) {
+        if (context->command_buffer[i]) {
+            /* Free the command buffer. */
+            vg_lite_hal_free_contiguous(context->command_buffer[i]);
+            context->command_buffer[i] = NULL;
+        }
     }
 
-    if (context->context_buffer[1]) {
-        /* Free the context buffer. */
-        vg_lite_hal_free_contiguous(context->context_buffer[1]);
-        context->context_buffer[1] = NULL;
+    for (i = 0; i < CMDBUF_COUNT; i++) {
+        if (context->context_buffer[i]) {
+            /* Free the context buffer. */
+            vg_lite_hal_free_contiguous(context->context_buffer[i]);
+            context->context_buffer[i] = NULL;
+        }
     }
 
     if((error = (vg_lite_error_t)VG_LITE_OS_LOCK()) == VG_LITE_SUCCESS){
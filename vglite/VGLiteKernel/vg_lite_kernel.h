@@ -41,7 +41,10 @@
 
 #define VG_LITE_INFINITE       0xFFFFFFFF
 #define VG_LITE_MAX_WAIT_TIME  0x130000
-#define CMDBUF_COUNT        2
+/* Number of command buffers in the submission ring of each context. */
+#ifndef CMDBUF_COUNT
+#define CMDBUF_COUNT        3
+#endif
 
 #define VG_LITE_ALIGN(number, alignment)    \
         (((number) + ((alignment) - 1)) & ~((alignment) - 1))
@@ -424,6 +427,11 @@ vg_lite_kernel_info_t;
 typedef struct vg_lite_kernel_mem
 {
     uint32_t bytes;
+
+    /* Fragmentation of the contiguous heap. */
+    uint32_t largest_free;
+    uint32_t free_blocks;
+    uint32_t used_blocks;
 }
 vg_lite_kernel_mem_t;
 
@@ -97,6 +97,7 @@ int read_32b(bufferred_reader_t *f, uint32_t* pword);
 int read_16b_blob(bufferred_reader_t *f, uint16_t** ary, uint32_t* ary_len);
 int read_8b_blob(bufferred_reader_t *f, uint8_t** ary, uint32_t* ary_len);
 int free_rle_font_memory(struct mf_font_s** font);
+void text_atlas_forget(const struct mf_font_s *font);
 vg_lite_error_t vg_lite_free_font_memory(vg_lite_font_t font);
 vg_lite_error_t vg_lite_load_font_data(vg_lite_font_t font, int font_height);
 
@@ -225,6 +226,7 @@ vg_lite_error_t vg_lite_free_font_memory(vg_lite_font_t font)
       break;
     case eFontTypeRaster:
       if ( s_device_fonts[font]._raster_font != NULL ) {
+          text_atlas_forget(s_device_fonts[font]._raster_font);
           free_rle_font_memory(&s_device_fonts[font]._raster_font);
           s_device_fonts[font]._raster_font = NULL;
       }
@@ -46,28 +46,62 @@
 #define READ_BIN_FIELD_UINT32(x) READ_BIN_FIELD(x)
 #define READ_BIN_FIELD_FLOAT(x) READ_BIN_FIELD(x)
 #define READ_BIN_FIELD_DUMMY_POINTER(x) offset += 4;
-#define GLYPH_CACHE_SIZE 16
+#ifndef GLYPH_CACHE_SIZE
+#define GLYPH_CACHE_SIZE 64     /* Glyph paths kept uploaded to GPU memory */
+#endif
+#ifndef GLYPH_CACHE_BUCKETS
+#define GLYPH_CACHE_BUCKETS 64  /* Hash buckets of the glyph cache, must be a power of 2 */
+#endif
+#ifndef VFT_DIRECT_GLYPHS
+#define VFT_DIRECT_GLYPHS 128   /* Code points below this are looked up without a search */
+#endif
 #define ENABLE_TEXT_WRAP 0
 #define HALT_ALLOCATOR_ERROR 1
 
 /** Data structures */
 typedef struct glyph_cache_desc {
-    vg_lite_path_t *h_path;
+    vg_lite_path_t path;
+    font_face_desc_t *font_face;    /* NULL when the entry is unused */
     glyph_desc_t *g;
-    uint32_t use_count;
+    vg_lite_fence_t fence;          /* Last draw of the path */
+    int fenced;
+    struct glyph_cache_desc *next;  /* Next entry in the same hash bucket */
+    struct glyph_cache_desc *newer; /* LRU list */
+    struct glyph_cache_desc *older;
 }glyph_cache_desc_t;
 
+typedef struct vft_kern_slot {
+    uint32_t pair;                  /* Left unicode << 16 | right unicode */
+    int32_t kern;
+}vft_kern_slot_t;
+
+/* Lookup tables built when a font face is loaded */
+typedef struct vft_index {
+    font_face_desc_t *font_face;
+    uint16_t *order;                /* Glyph indices sorted by unicode, NULL when the table is sorted */
+    uint16_t direct[VFT_DIRECT_GLYPHS]; /* Glyph index + 1 of small code points, 0 when missing */
+    vft_kern_slot_t *kern;          /* Open addressing hash of all kerning pairs */
+    uint32_t kern_mask;
+    struct vft_index *next;
+}vft_index_t;
+
 /** Internal or external API prototypes */
 
 /** Globals */
 static int g_glyph_cache_init_done = 0;
 static glyph_cache_desc_t g_glyph_cache[GLYPH_CACHE_SIZE];
+static glyph_cache_desc_t *g_glyph_hash[GLYPH_CACHE_BUCKETS];
+static glyph_cache_desc_t *g_glyph_newest;
+static glyph_cache_desc_t *g_glyph_oldest;
+static vg_lite_glyph_cache_stats_t g_glyph_cache_stats;
+static vft_index_t *g_font_index = NULL;
 int g_total_bytes = 0;
 
 /** Externs if any */
 
 /* Internal API, not published to user */
 font_face_desc_t *_vg_lite_get_vector_font(vg_lite_font_t font_idx);
+int vg_lite_is_font_valid(vg_lite_font_t font);
 void matrix_multiply(vg_lite_matrix_t * matrix, vg_lite_matrix_t *mult);
 
 void *_mem_allocate(int size)
@@ -104,69 +138,125 @@ void _mem_free(void *buf)
 /** GLYPH CACHING Code */
 void glyph_cache_init(void)
 {
+    int i;
+
     if ( g_glyph_cache_init_done == 0 ) {
         memset(g_glyph_cache,0,sizeof(g_glyph_cache));
+        memset(g_glyph_hash,0,sizeof(g_glyph_hash));
+        memset(&g_glyph_cache_stats,0,sizeof(g_glyph_cache_stats));
+
+        /* All entries start unused at the old end of the LRU list */
+        for (i=0; i<GLYPH_CACHE_SIZE; i++) {
+            g_glyph_cache[i].newer = (i > 0) ? &g_glyph_cache[i-1] : NULL;
+            g_glyph_cache[i].older = (i < GLYPH_CACHE_SIZE-1) ? &g_glyph_cache[i+1] : NULL;
+        }
+        g_glyph_newest = &g_glyph_cache[0];
+        g_glyph_oldest = &g_glyph_cache[GLYPH_CACHE_SIZE-1];
         g_glyph_cache_init_done = 1;
     }
 }
 
-void glyph_cache_free(void)
+static glyph_cache_desc_t **glyph_cache_bucket(font_face_desc_t *font_face, uint16_t unicode)
+{
+    uint32_t h = ((uint32_t)(uintptr_t)font_face ^ unicode) * 2654435761u;
+
+    return &g_glyph_hash[(h ^ (h >> 16)) & (GLYPH_CACHE_BUCKETS - 1)];
+}
+
+static void glyph_cache_unlink(glyph_cache_desc_t *e)
+{
+    if (e->newer != NULL)
+        e->newer->older = e->older;
+    else
+        g_glyph_newest = e->older;
+    if (e->older != NULL)
+        e->older->newer = e->newer;
+    else
+        g_glyph_oldest = e->newer;
+}
+
+/* Move entry to the new end of the LRU list */
+static void glyph_cache_touch(glyph_cache_desc_t *e)
+{
+    if (e == g_glyph_newest)
+        return;
+
+    glyph_cache_unlink(e);
+    e->newer = NULL;
+    e->older = g_glyph_newest;
+    g_glyph_newest->newer = e;
+    g_glyph_newest = e;
+}
+
+/* Free the path of an entry once the GPU is done with it, entry is reused first */
+static void glyph_cache_release(glyph_cache_desc_t *e)
+{
+    glyph_cache_desc_t **p;
+
+    for (p = glyph_cache_bucket(e->font_face, e->g->unicode); *p != e; p = &(*p)->next)
+        ;
+    *p = e->next;
+
+    if (e->fenced)
+        vg_lite_fence_wait(&e->fence, VG_LITE_FENCE_INFINITE);
+    vg_lite_clear_path(&e->path);
+    e->font_face = NULL;
+    e->g = NULL;
+    e->fenced = 0;
+    e->next = NULL;
+    g_glyph_cache_stats.entries--;
+
+    if (e != g_glyph_oldest) {
+        glyph_cache_unlink(e);
+        e->older = NULL;
+        e->newer = g_glyph_oldest;
+        g_glyph_oldest->older = e;
+        g_glyph_oldest = e;
+    }
+}
+
+/* Release cached glyphs of a font face, or of all font faces when NULL */
+void glyph_cache_free(font_face_desc_t *font_face)
 {
     int i;
-    for (i=0; i<GLYPH_CACHE_SIZE; i++) {
-        if ( g_glyph_cache[i].h_path != NULL ) {
-            /* For non-mapped path this resetting is sufficient */
-            vg_lite_clear_path(g_glyph_cache[i].h_path);
 
-            /* Release path handle */
-            VFT_FREE(g_glyph_cache[i].h_path);
+    if ( g_glyph_cache_init_done == 0 )
+        return;
 
-            /* Reset pointer */
-            g_glyph_cache[i].h_path = NULL;
+    for (i=0; i<GLYPH_CACHE_SIZE; i++) {
+        if ( g_glyph_cache[i].font_face != NULL &&
+            (font_face == NULL || g_glyph_cache[i].font_face == font_face) ) {
+            glyph_cache_release(&g_glyph_cache[i]);
         }
     }
-
-    /* Next time font init will be required */
-    g_glyph_cache_init_done = 0;
 }
 
-vg_lite_path_t *vft_cache_lookup(glyph_desc_t *g)
+static glyph_cache_desc_t *vft_cache_lookup(font_face_desc_t *font_face, glyph_desc_t *g)
 {
-    int i;
-    int unused_idx = 0;
+    glyph_cache_desc_t **bucket;
+    glyph_cache_desc_t *e;
 
-    /* Not present caching code does not handle multiple font-face */
     glyph_cache_init();
 
     /* Check if path object for given glyph exists */
-    for (i=0; i<GLYPH_CACHE_SIZE; i++) {
-        if ( g_glyph_cache[i].g != NULL && g->unicode == 
-            g_glyph_cache[i].g->unicode )
-        {
-            g_glyph_cache[i].use_count++;
-            return g_glyph_cache[i].h_path;
+    bucket = glyph_cache_bucket(font_face, g->unicode);
+    for (e = *bucket; e != NULL; e = e->next) {
+        if (e->font_face == font_face && e->g->unicode == g->unicode) {
+            g_glyph_cache_stats.hits++;
+            glyph_cache_touch(e);
+            return e;
         }
     }
+    g_glyph_cache_stats.misses++;
 
-    /* Find least used descriptor */
-    unused_idx = 0;
-    for (i=1; i<GLYPH_CACHE_SIZE; i++) {
-      if ( g_glyph_cache[i].use_count < 
-          g_glyph_cache[unused_idx].use_count ) {
-            unused_idx = i;
-      }
-    }
-    /* Re-cycle descriptor */
-    if ( g_glyph_cache[unused_idx].h_path != NULL ) {
-        /* For non-mapped path this resetting is sufficient */
-        vg_lite_clear_path(g_glyph_cache[unused_idx].h_path);
-    } else {
-        /* Allocate new path object */
-        g_glyph_cache[unused_idx].h_path = 
-            (vg_lite_path_t *)VFT_ALLOC(sizeof(vg_lite_path_t));
-    }
-    /* Allocate new path */
-    vg_lite_init_path(g_glyph_cache[unused_idx].h_path,
+    /* Re-cycle least recently used descriptor */
+    e = g_glyph_oldest;
+    if (e->font_face != NULL) {
+        g_glyph_cache_stats.evictions++;
+        glyph_cache_release(e);
+    }
+
+    vg_lite_init_path(&e->path,
                       VG_LITE_FP32, VG_LITE_HIGH,
                       g->path.num_draw_cmds*4,
                       g->path.draw_cmds,
@@ -174,9 +264,74 @@ vg_lite_path_t *vft_cache_lookup(glyph_desc_t *g)
                       g->path.bounds[1],
                       g->path.bounds[2],
                       g->path.bounds[3]);
-    g_glyph_cache[unused_idx].g = g;
-    g_glyph_cache[unused_idx].use_count = 1;
-    return g_glyph_cache[unused_idx].h_path;
+    /* Without GPU memory the path data gets copied by every draw instead */
+    vg_lite_upload_path(&e->path);
+
+    e->font_face = font_face;
+    e->g = g;
+    e->next = *bucket;
+    *bucket = e;
+    g_glyph_cache_stats.entries++;
+    glyph_cache_touch(e);
+    return e;
+}
+
+vg_lite_error_t vg_lite_get_glyph_cache_stats(vg_lite_glyph_cache_stats_t *stats)
+{
+    if (stats == NULL)
+        return VG_LITE_INVALID_ARGUMENT;
+
+    glyph_cache_init();
+    *stats = g_glyph_cache_stats;
+    stats->capacity = GLYPH_CACHE_SIZE;
+    return VG_LITE_SUCCESS;
+}
+
+/* Draw a glyph through the glyph cache */
+static vg_lite_error_t vft_draw_cached_glyph(vg_lite_buffer_t *rt, font_face_desc_t *font_face,
+                                             glyph_desc_t *g, vg_lite_matrix_t *mat,
+                                             vg_lite_blend_t blend, vg_lite_color_t color)
+{
+    glyph_cache_desc_t *cached;
+    vg_lite_error_t error;
+
+    cached = vft_cache_lookup(font_face, g);
+    error = vg_lite_draw(rt, &cached->path, VG_LITE_FILL_NON_ZERO, mat, blend, color);
+    if ( error != VG_LITE_SUCCESS ) {
+        return error;
+    }
+
+    /* Not available while recording a command list */
+    if ( vg_lite_fence_insert(&cached->fence) == VG_LITE_SUCCESS ) {
+        cached->fenced = 1;
+    }
+    return VG_LITE_SUCCESS;
+}
+
+/* Width of text in pixels used for center and right alignment */
+static int vft_text_width(font_face_desc_t *font_face, char *text, float font_scale)
+{
+    glyph_desc_t* g2;
+    int dx = 0;
+
+    while (*text != '\0') {
+        g2 = vft_find_glyph(font_face, (uint16_t)*text);
+        dx += (g2->horiz_adv_x * font_scale);
+        text++;
+    }
+    return dx;
+}
+
+/* Transformation of the first glyph of text drawn at x,y */
+static void vft_text_matrix(vg_lite_matrix_t *mat, vg_lite_matrix_t *matrix,
+                            int x, int y, float font_scale)
+{
+    vg_lite_identity(mat);
+    matrix_multiply(mat, matrix);
+    vg_lite_translate(x,y, mat);
+    vg_lite_scale(font_scale,font_scale, mat); // 0.35 = height/units_per_em
+    vg_lite_scale(-1.0,1.0, mat);
+    vg_lite_scale(-1.0,-1.0, mat);
 }
 
 /** Render text using vector fonts */
@@ -201,33 +356,14 @@ int vg_lite_vtf_draw_text(vg_lite_buffer_t *rt, int x, int y,
 
     vg_lite_matrix_t mat;
 
-    vg_lite_fill_t    fill_rule = VG_LITE_FILL_NON_ZERO;
     vg_lite_color_t   color = attributes->text_color;
 
     /* Compute size of tex in pixels 
      * For center alignment adjust x position
-     * Present parser has bug in encoding alignment value,
-     * Once it is fixed following code will align text in center
      */
     if ( attributes->alignment == eTextAlignCenter ||
          attributes->alignment == eTextAlignRight ) {
-        char *t2 = text;
-        int dx = 0;
-        uint16_t ug2; /* Unicode glyph */
-        int kx;
-
-        /* Case of center alignement */
-        while (*t2 != '\0') {
-            ug2 = *t2;
-            kx = 0;
-            g2 = vft_find_glyph(font_face, ug2);
-            if (g1 != NULL && g2 != NULL) {
-                kx = vft_glyph_distance(g1, g2);
-            }
-
-            dx += ((g2->horiz_adv_x + kx )* font_scale);
-            t2++;
-        }
+        int dx = vft_text_width(font_face, text, font_scale);
 
         if ( attributes->alignment == eTextAlignCenter) {
             x -= (dx/2);
@@ -242,12 +378,7 @@ int vg_lite_vtf_draw_text(vg_lite_buffer_t *rt, int x, int y,
         int kx;
         
         if (text_wrap == 0) {
-            vg_lite_identity(&mat);
-            matrix_multiply(&mat, matrix);
-            vg_lite_translate(x,y, &mat);
-            vg_lite_scale(font_scale,font_scale, &mat); // 0.35 = height/units_per_em
-            vg_lite_scale(-1.0,1.0, &mat);
-            vg_lite_scale(-1.0,-1.0, &mat);
+            vft_text_matrix(&mat, matrix, x, y, font_scale);
             text_wrap = 1;
         }
 
@@ -256,7 +387,7 @@ int vg_lite_vtf_draw_text(vg_lite_buffer_t *rt, int x, int y,
         ug2 = *text;
         g2 = vft_find_glyph(font_face, ug2);
         if (g1 != NULL && g2 != NULL) {
-            kx = vft_glyph_distance(g1, g2);
+            kx = vft_glyph_distance(font_face, g1, g2);
         }
 
 #if (ENABLE_TEXT_WRAP==1)
@@ -275,11 +406,7 @@ int vg_lite_vtf_draw_text(vg_lite_buffer_t *rt, int x, int y,
         g1 = g2;
         text++;
              
-        error = vg_lite_draw(rt, vft_cache_lookup(g2),
-                             fill_rule,
-                             &mat,
-                             blend,
-                             color);
+        error = vft_draw_cached_glyph(rt, font_face, g2, &mat, blend, color);
         if ( error != VG_LITE_SUCCESS ) {
           break;
         }
@@ -293,6 +420,137 @@ int vg_lite_vtf_draw_text(vg_lite_buffer_t *rt, int x, int y,
     return 0;
 }
 
+/** Text layout */
+typedef struct vft_layout_glyph {
+    glyph_desc_t *g;
+    int32_t advance;    /* Font units to the next glyph, including kerning */
+}vft_layout_glyph_t;
+
+vg_lite_error_t vg_lite_text_layout(vg_lite_text_layout_t *layout,
+                                    char *text,
+                                    vg_lite_font_t font,
+                                    vg_lite_font_attributes_t *attributes)
+{
+    font_face_desc_t *font_face;
+    vft_layout_glyph_t *glyphs;
+    glyph_desc_t *g1 = NULL;
+    glyph_desc_t *g2;
+    uint32_t length, i;
+    float font_scale;
+    int kx;
+
+    if (layout == NULL || text == NULL || attributes == NULL ||
+        vg_lite_is_font_valid(font) != 0) {
+        return VG_LITE_INVALID_ARGUMENT;
+    }
+    if (vg_lite_is_vector_font(font) != 1) {
+        return VG_LITE_NOT_SUPPORT;
+    }
+    if (vg_lite_load_font_data(font, attributes->font_height) != VG_LITE_SUCCESS) {
+        return VG_LITE_INVALID_ARGUMENT;
+    }
+    font_face = _vg_lite_get_vector_font(font);
+
+    /* Nothing to do if the label did not change */
+    if (layout->text != NULL && layout->font_face == font_face &&
+        layout->font == font && layout->font_height == attributes->font_height &&
+        layout->alignment == attributes->alignment && strcmp(layout->text, text) == 0) {
+        return VG_LITE_SUCCESS;
+    }
+
+    length = strlen(text);
+    if (layout->text == NULL || length + 1 > layout->capacity) {
+        vg_lite_text_layout_free(layout);
+        layout->glyphs = VFT_ALLOC((length + 1) * (sizeof(vft_layout_glyph_t) + 1));
+        if (layout->glyphs == NULL) {
+            return VG_LITE_OUT_OF_MEMORY;
+        }
+        layout->capacity = length + 1;
+        layout->text = (char *)((vft_layout_glyph_t *)layout->glyphs + layout->capacity);
+    }
+    memcpy(layout->text, text, length + 1);
+    layout->font = font;
+    layout->font_face = font_face;
+    layout->font_height = attributes->font_height;
+    layout->alignment = attributes->alignment;
+    layout->length = length;
+    layout->width = 0;
+
+    /* Same placement as vg_lite_vtf_draw_text */
+    font_scale = ((1.0*attributes->font_height)/font_face->units_per_em);
+    glyphs = (vft_layout_glyph_t *)layout->glyphs;
+    for (i = 0; i < length; i++) {
+        kx = 0;
+        g2 = vft_find_glyph(font_face, (uint16_t)text[i]);
+        if (g1 != NULL) {
+            kx = vft_glyph_distance(font_face, g1, g2);
+        }
+        glyphs[i].g = g2;
+        glyphs[i].advance = g2->horiz_adv_x + kx;
+        layout->width += (glyphs[i].advance * font_scale);
+        g1 = g2;
+    }
+
+    layout->align_dx = 0;
+    if ( attributes->alignment == eTextAlignCenter ) {
+        layout->align_dx = -(vft_text_width(font_face, text, font_scale) / 2);
+    } else if ( attributes->alignment == eTextAlignRight ) {
+        layout->align_dx = -vft_text_width(font_face, text, font_scale);
+    }
+
+    return VG_LITE_SUCCESS;
+}
+
+vg_lite_error_t vg_lite_draw_text_layout(vg_lite_buffer_t *target,
+                                         vg_lite_text_layout_t *layout,
+                                         int x,
+                                         int y,
+                                         vg_lite_matrix_t *matrix,
+                                         vg_lite_blend_t blend,
+                                         vg_lite_color_t color)
+{
+    vg_lite_error_t error;
+    font_face_desc_t *font_face;
+    vft_layout_glyph_t *glyphs;
+    vg_lite_matrix_t mat;
+    uint32_t i;
+
+    if (target == NULL || layout == NULL || matrix == NULL || layout->text == NULL) {
+        return VG_LITE_INVALID_ARGUMENT;
+    }
+
+    /* The glyphs point into the font data, which has to be the one laid out */
+    font_face = (font_face_desc_t *)layout->font_face;
+    if (_vg_lite_get_vector_font(layout->font) != font_face) {
+        return VG_LITE_INVALID_ARGUMENT;
+    }
+
+    vft_text_matrix(&mat, matrix, x + layout->align_dx, y,
+                    ((1.0*layout->font_height)/font_face->units_per_em));
+    glyphs = (vft_layout_glyph_t *)layout->glyphs;
+    for (i = 0; i < layout->length; i++) {
+        error = vft_draw_cached_glyph(target, font_face, glyphs[i].g, &mat, blend, color);
+        if ( error != VG_LITE_SUCCESS ) {
+            return error;
+        }
+        vg_lite_translate(glyphs[i].advance, 0, &mat);
+    }
+
+    return VG_LITE_SUCCESS;
+}
+
+void vg_lite_text_layout_free(vg_lite_text_layout_t *layout)
+{
+    if (layout == NULL) {
+        return;
+    }
+
+    if (layout->glyphs != NULL) {
+        VFT_FREE(layout->glyphs);
+    }
+    memset(layout, 0, sizeof(*layout));
+}
+
 void load_font_face(font_face_desc_t* font_face, uint8_t* buf, int font_face_offset)
 {
     font_face_desc_t* g = font_face;
@@ -335,6 +593,126 @@ void load_glyph_table(font_face_desc_t* font_face, uint8_t* buf, int glyph_table
     }
 }
 
+#define VFT_KERN_EMPTY 0xFFFFFFFFu
+
+static uint32_t vft_kern_hash(uint32_t pair)
+{
+    pair *= 2654435761u;
+    return pair ^ (pair >> 16);
+}
+
+static vft_index_t *vft_get_index(font_face_desc_t *font_face)
+{
+    vft_index_t *index;
+
+    for (index = g_font_index; index != NULL; index = index->next) {
+        if (index->font_face == font_face)
+            return index;
+    }
+    return NULL;
+}
+
+static void vft_free_index(font_face_desc_t *font_face)
+{
+    vft_index_t **p, *index;
+
+    for (p = &g_font_index; *p != NULL; p = &(*p)->next) {
+        if ((*p)->font_face == font_face) {
+            index = *p;
+            *p = index->next;
+            if (index->order != NULL)
+                VFT_FREE(index->order);
+            if (index->kern != NULL)
+                VFT_FREE(index->kern);
+            VFT_FREE(index);
+            return;
+        }
+    }
+}
+
+/*
+* Build direct map of small code points, a sort order if the glyph table is
+* not sorted, and a hash of all kerning pairs. Without it lookups are linear.
+*/
+static void vft_build_index(font_face_desc_t *font_face)
+{
+    const uint32_t num_glyphs = font_face->num_glyphs;
+    glyph_desc_t *glyphs = font_face->glyphs;
+    vft_index_t *index;
+    uint32_t i, j, k, num_pairs = 0;
+
+    if (num_glyphs == 0 || num_glyphs > 0xFFFF)
+        return;
+
+    index = (vft_index_t *)VFT_ALLOC(sizeof(vft_index_t));
+    if (index == NULL)
+        return;
+    memset(index, 0, sizeof(vft_index_t));
+    index->font_face = font_face;
+
+    for (i = 0; i < num_glyphs; i++) {
+        if (glyphs[i].unicode < VFT_DIRECT_GLYPHS && index->direct[glyphs[i].unicode] == 0)
+            index->direct[glyphs[i].unicode] = (uint16_t)(i + 1);
+        if (i > 0 && glyphs[i].unicode < glyphs[i-1].unicode && index->order == NULL) {
+            index->order = (uint16_t *)VFT_ALLOC(num_glyphs * sizeof(uint16_t));
+            if (index->order == NULL) {
+                VFT_FREE(index);
+                return;
+            }
+        }
+        num_pairs += glyphs[i].kern_num_entries;
+    }
+
+    if (index->order != NULL) {
+        /* Shell sort by code point then table position, so the first of duplicates is found like before */
+        for (i = 0; i < num_glyphs; i++)
+            index->order[i] = (uint16_t)i;
+        for (k = num_glyphs / 2; k > 0; k /= 2) {
+            for (i = k; i < num_glyphs; i++) {
+                uint16_t v = index->order[i];
+                uint32_t key = ((uint32_t)glyphs[v].unicode << 16) | v;
+
+                for (j = i; j >= k; j -= k) {
+                    uint16_t w = index->order[j-k];
+                    if ((((uint32_t)glyphs[w].unicode << 16) | w) <= key)
+                        break;
+                    index->order[j] = w;
+                }
+                index->order[j] = v;
+            }
+        }
+    }
+
+    if (num_pairs > 0) {
+        for (k = 2; k < num_pairs * 2; k <<= 1)
+            ;
+        index->kern = (vft_kern_slot_t *)VFT_ALLOC(k * sizeof(vft_kern_slot_t));
+        if (index->kern != NULL) {
+            memset(index->kern, 0xFF, k * sizeof(vft_kern_slot_t));
+            index->kern_mask = k - 1;
+            for (i = 0; i < num_glyphs; i++) {
+                kern_desc_t *kern_table = glyphs[i].kern_table;
+
+                for (j = 0; j < glyphs[i].kern_num_entries; j++) {
+                    uint32_t pair = ((uint32_t)glyphs[i].unicode << 16) | kern_table[j].unicode;
+                    uint32_t h = vft_kern_hash(pair) & index->kern_mask;
+
+                    /* First entry of a pair wins, as in the kern table scan */
+                    while (index->kern[h].pair != VFT_KERN_EMPTY && index->kern[h].pair != pair)
+                        h = (h + 1) & index->kern_mask;
+                    if (index->kern[h].pair == VFT_KERN_EMPTY) {
+                        index->kern[h].pair = pair;
+                        index->kern[h].kern = (signed short)kern_table[j].kern;
+                    }
+                }
+            }
+        }
+    }
+
+    index->next = g_font_index;
+    g_font_index = index;
+}
+
 /* Load vector font ROM table from file */
 font_face_desc_t* vft_load_from_buffer(char* buf_base, int file_size)
 {
@@ -406,6 +784,9 @@ font_face_desc_t* vft_load_from_buffer(char* buf_base, int file_size)
     VFT_DBG_KERN_TABLE(font_face, kern_table_offset);
     VFT_DBG_PATH_TABLE(font_face, path_data_offset);
 
+    vft_free_index(font_face);
+    vft_build_index(font_face);
+
     return font_face;
 }
 
@@ -414,12 +795,35 @@ glyph_desc_t* vft_find_glyph(font_face_desc_t* font_face, uint16_t ug2)
 {
     const int num_glyphs = font_face->num_glyphs;
     glyph_desc_t* glyphs = font_face->glyphs;
+    vft_index_t *index = vft_get_index(font_face);
+    int lo, hi, mid, i;
+
+    if (index != NULL) {
+        if (ug2 < VFT_DIRECT_GLYPHS) {
+            i = index->direct[ug2];
+            return (glyph_desc_t*)&glyphs[i > 0 ? i - 1 : 0];
+        }
 
-    /* 
-    * Present approach is slow linear search, this is ok in 1st prototype
-    * Since glyph table is already sorted, we can have binary search 
-    */
-    for (int i = 0; i < num_glyphs; i++) {
+        /* Binary search for the first glyph with the code point */
+        lo = 0;
+        hi = num_glyphs;
+        while (lo < hi) {
+            mid = (lo + hi) / 2;
+            i = index->order != NULL ? index->order[mid] : mid;
+            if (glyphs[i].unicode < ug2)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo < num_glyphs) {
+            i = index->order != NULL ? index->order[lo] : lo;
+            if (glyphs[i].unicode == ug2)
+                return (glyph_desc_t*)&glyphs[i];
+        }
+        return (glyph_desc_t*)&glyphs[0];
+    }
+
+    for (i = 0; i < num_glyphs; i++) {
         if (glyphs[i].unicode == ug2) {
             return (glyph_desc_t*)&glyphs[i];
         }
@@ -428,11 +832,28 @@ glyph_desc_t* vft_find_glyph(font_face_desc_t* font_face, uint16_t ug2)
 }
 
 /* Find distance between 2 glyph symbols */
-int vft_glyph_distance(glyph_desc_t* g1, glyph_desc_t* g2)
+int vft_glyph_distance(font_face_desc_t* font_face, glyph_desc_t* g1, glyph_desc_t* g2)
 {
     signed short kx = 0;
     uint16_t ug2 = g2->unicode;
     kern_desc_t* kern_table = &g1->kern_table[0];
+    vft_index_t *index = vft_get_index(font_face);
+
+    if (index != NULL) {
+        uint32_t pair = ((uint32_t)g1->unicode << 16) | ug2;
+        uint32_t h;
+
+        if (index->kern == NULL)
+            return 0;
+
+        for (h = vft_kern_hash(pair) & index->kern_mask;
+             index->kern[h].pair != VFT_KERN_EMPTY;
+             h = (h + 1) & index->kern_mask) {
+            if (index->kern[h].pair == pair)
+                return index->kern[h].kern;
+        }
+        return 0;
+    }
 
     for (int i = 0; i < g1->kern_num_entries; i++) {
         if (kern_table[i].unicode == ug2) {
@@ -457,6 +878,7 @@ path_desc_t* vft_get_glyph_path(glyph_desc_t* g2)
 /* Unload font face descriptor and all glyphs */
 void vft_unload(font_face_desc_t* font_face)
 {
-    glyph_cache_free();
+    glyph_cache_free(font_face);
+    vft_free_index(font_face);
     //VFT_FREE(font_face);
 }
@@ -74,7 +74,10 @@ typedef struct font_face_info {
     glyph_desc_t* glyphs; /* NOTE: this will be used while loading table, DONT REMOVE */
 }font_face_desc_t;
 
-//NOTE: No glyph caching at this time
+/*
+* Glyph paths are cached per font face in GPU memory, GLYPH_CACHE_SIZE
+* entries with least recently used replacement
+*/
 
 /* Load vector font ROM table from file */
 font_face_desc_t* vft_load(char* vcft_file_path);
@@ -83,7 +86,7 @@ font_face_desc_t* vft_load(char* vcft_file_path);
 glyph_desc_t* vft_find_glyph(font_face_desc_t* font_face, uint16_t ug2);
 
 /* Find distance between 2 glyph symbols */
-int vft_glyph_distance(glyph_desc_t* g1, glyph_desc_t* g2);
+int vft_glyph_distance(font_face_desc_t* font_face, glyph_desc_t* g1, glyph_desc_t* g2);
 
 /* 
 * Get internal vector path of given glyph
@@ -97,7 +100,7 @@ void vft_draw_glyph(int x, int y, glyph_desc_t* g2);
 /* Compute horizotal pixels coverted by this path */
 int vft_compute_dx(glyph_desc_t* g2);
 
-/* Unload font face descriptor and all glyphs */
+/* Unload font face descriptor and all glyphs, NULL drops cached glyphs of all fonts */
 void vft_unload(font_face_desc_t*);
 
 /* Draw string with vector font s*/
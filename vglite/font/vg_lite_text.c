@@ -37,8 +37,33 @@
 #include "vft_draw.h"
 
 /** Macros */
+#ifndef VG_TEXT_ATLAS
+#define VG_TEXT_ATLAS 1                 /* Draw raster text from a glyph atlas in GPU memory */
+#endif
+#ifndef VG_TEXT_ATLAS_WIDTH
+#define VG_TEXT_ATLAS_WIDTH     256
+#endif
+#ifndef VG_TEXT_ATLAS_HEIGHT
+#define VG_TEXT_ATLAS_HEIGHT    256
+#endif
+#ifndef VG_TEXT_ATLAS_GLYPHS
+#define VG_TEXT_ATLAS_GLYPHS    256     /* Hash slots, must be a power of 2 */
+#endif
+#define VG_TEXT_ATLAS_SHELVES   32
+#ifndef VG_TEXT_BUFFER_A8
+#define VG_TEXT_BUFFER_A8       1       /* A8 text buffer drawn with text_color, 0 for ARGB8888 blended with bg_color */
+#endif
 
 /** Data structures */
+/* Pixels that glyph runs are written to */
+typedef struct {
+    uint8_t *memory;
+    int32_t stride;
+    int16_t width;
+    int16_t height;
+    uint8_t bytes_per_pixel;
+} text_span_t;
+
 typedef struct {
     /* Font related parameters */
     vg_lite_font_attributes_t *attributes;
@@ -47,8 +72,43 @@ typedef struct {
     uint16_t height;
     uint16_t y;
     const struct mf_font_s *rcd_font;
+    mf_character_callback_t character;
+    text_span_t span;
+
+    /* Glyph atlas drawing */
+    vg_lite_buffer_t *target;
+    vg_lite_matrix_t matrix;
+    vg_lite_blend_t blend;
+    vg_lite_color_t color;
+    vg_lite_error_t error;
 } text_context_t;
 
+#if VG_TEXT_ATLAS
+typedef struct {
+    const struct mf_font_s *font;       /* NULL when the slot is unused */
+    mf_char character;
+    uint16_t x, y;                      /* Position in the atlas */
+    uint8_t width, height;              /* 0 for whitespace */
+    uint8_t left, top;                  /* Position in the character box */
+} atlas_glyph_t;
+
+typedef struct {
+    uint16_t y;
+    uint16_t height;
+    uint16_t x;                         /* Used width */
+} atlas_shelf_t;
+
+typedef struct {
+    vg_lite_buffer_t buffer;            /* A8 coverage of the glyphs */
+    atlas_glyph_t glyphs[VG_TEXT_ATLAS_GLYPHS];
+    uint32_t glyph_count;
+    atlas_shelf_t shelves[VG_TEXT_ATLAS_SHELVES];
+    uint32_t shelf_count;
+    uint16_t next_y;                    /* Top of the free space below the shelves */
+    uint32_t pins;                      /* Command lists that blit from the atlas, it is not emptied while any is alive */
+} text_atlas_t;
+#endif /* VG_TEXT_ATLAS */
+
 /** Internal or external API prototypes */
 struct mf_font_s *_vg_lite_get_raster_font(vg_lite_font_t font_idx);
 int vg_lite_is_font_valid(vg_lite_font_t font);
@@ -57,6 +117,10 @@ int vg_lite_is_font_valid(vg_lite_font_t font);
 vg_lite_font_attributes_t g_font_attribs;
 vg_lite_font_t g_last_font = VG_LITE_INVALID_FONT;
 int g_last_font_attrib_idx;
+static vg_lite_arena_t *g_text_arena = NULL;
+#if VG_TEXT_ATLAS
+static text_atlas_t g_text_atlas;
+#endif
 
 /** Externs if any */
 
@@ -93,36 +157,324 @@ int init_256pallet_color_table(unsigned int bg_color, unsigned int fg_color)
   return 0;
 }
 
-/* Callback to write to a memory buffer. */
-static void pixel_callback(int16_t x, int16_t y, uint8_t count, uint8_t alpha,
-                           void *state)
+/* Callback to write a run of pixels, clipped to the span. */
+static void span_callback(int16_t x, int16_t y, uint8_t count, uint8_t alpha,
+                          void *state)
 {
-    text_context_t *s = (text_context_t*)state;
-    uint32_t pos;
+    text_span_t *span = (text_span_t*)state;
+    uint8_t *bytes;
+    uint32_t *pixels;
     uint32_t value;
-    uint32_t *raw_pixel_buffer = (uint32_t *)s->buffer.memory;
-    int stride = s->buffer.stride;
 
-    if (y < 0 || y >= s->height) return;
-    if (x < 0 || x + count >= s->width) return;
+    /* Runs are almost always inside the span, so clipping is done only for the others. */
+    if ((uint32_t)y >= (uint32_t)span->height || (uint32_t)x + count > (uint32_t)span->width) {
+        if (y < 0 || y >= span->height) return;
+        if (x < 0) {
+            if (count <= -x) return;
+            count += x;
+            x = 0;
+        }
+        if (x + count > span->width) {
+            if (x >= span->width) return;
+            count = span->width - x;
+        }
+    }
+
+    /* Runs are a few pixels, too short for memset or a loop to pay off: the last store of a run
+       overlaps the previous one, and runs of 1 to 3 pixels are three stores. */
+    if (span->bytes_per_pixel == 1) {
+        bytes = span->memory + y * span->stride + x;
+        if (count >= 4) {
+            value = alpha * 0x01010101u;
+            for (; count > 4; count -= 4, bytes += 4)
+                memcpy(bytes, &value, 4);
+            memcpy(bytes + count - 4, &value, 4);
+        } else if (count > 0) {
+            bytes[0] = alpha;
+            bytes[count >> 1] = alpha;
+            bytes[count - 1] = alpha;
+        }
+        return;
+    }
 
-    while (count--)
-    {
-        pos = (uint32_t)stride * y + x;
-        value = g_index_table[alpha];
-        
-        raw_pixel_buffer[pos] = value;
+    /* All pixels of a run have the same color */
+    pixels = (uint32_t *)(span->memory + y * span->stride) + x;
+    value = g_index_table[alpha];
+    if (count >= 4) {
+        for (; count > 4; count -= 4, pixels += 4) {
+            pixels[0] = value;
+            pixels[1] = value;
+            pixels[2] = value;
+            pixels[3] = value;
+        }
+        pixels += count - 4;
+        pixels[0] = value;
+        pixels[1] = value;
+        pixels[2] = value;
+        pixels[3] = value;
+    } else if (count > 0) {
+        pixels[0] = value;
+        pixels[count >> 1] = value;
+        pixels[count - 1] = value;
+    }
+}
 
-        x++;
+#if VG_TEXT_ATLAS
+/* Drop all glyphs once the GPU is done with the commands that use them. Recorded command lists
+   keep using the glyphs they were recorded with, so an atlas that any list blits from is kept. */
+static vg_lite_error_t text_atlas_reset(void)
+{
+    vg_lite_error_t error;
+    vg_lite_fence_t fence;
+
+    if (g_text_atlas.pins > 0)
+        return VG_LITE_OUT_OF_RESOURCES;
+    if (g_text_atlas.glyph_count > 0) {
+        error = vg_lite_fence_insert(&fence);
+        if (error == VG_LITE_SUCCESS)
+            error = vg_lite_fence_wait(&fence, VG_LITE_FENCE_INFINITE);
+        if (error != VG_LITE_SUCCESS)
+            return error;
     }
+    memset(g_text_atlas.glyphs, 0, sizeof(g_text_atlas.glyphs));
+    g_text_atlas.glyph_count = 0;
+    g_text_atlas.shelf_count = 0;
+    g_text_atlas.next_y = 0;
+    return VG_LITE_SUCCESS;
 }
 
+/* Find room for a width x height slot on the best fitting shelf. */
+static int text_atlas_place(int width, int height, uint16_t *x, uint16_t *y)
+{
+    atlas_shelf_t *shelf, *best = NULL;
+    uint32_t i;
+
+    for (i = 0; i < g_text_atlas.shelf_count; i++) {
+        shelf = &g_text_atlas.shelves[i];
+        if (shelf->height >= height && shelf->x + width <= VG_TEXT_ATLAS_WIDTH &&
+            (best == NULL || shelf->height < best->height)) {
+            best = shelf;
+        }
+    }
+
+    /* Open a new shelf rather than waste more than a quarter of an old one. */
+    if ((best == NULL || best->height > height + height / 4) &&
+        g_text_atlas.shelf_count < VG_TEXT_ATLAS_SHELVES &&
+        g_text_atlas.next_y + height <= VG_TEXT_ATLAS_HEIGHT) {
+        best = &g_text_atlas.shelves[g_text_atlas.shelf_count++];
+        best->y = g_text_atlas.next_y;
+        best->height = height;
+        best->x = 0;
+        g_text_atlas.next_y += height;
+    }
+    if (best == NULL) {
+        return 0;
+    }
+
+    *x = best->x;
+    *y = best->y;
+    best->x += width;
+    return 1;
+}
+
+/* Bounding box of all covered pixels, mf_character_whitespace skips faint ones. */
+static void atlas_bounds_callback(int16_t x, int16_t y, uint8_t count, uint8_t alpha,
+                                  void *state)
+{
+    int16_t *box = (int16_t*)state;
+
+    if (alpha == 0 || count == 0) return;
+    if (box[0] > x) box[0] = x;
+    if (box[1] > y) box[1] = y;
+    if (box[2] < x + count) box[2] = x + count;
+    if (box[3] < y + 1) box[3] = y + 1;
+}
+
+/* Find a glyph in the atlas, rendering it on the first use. */
+static atlas_glyph_t *text_atlas_lookup(const struct mf_font_s *font, mf_char character)
+{
+    atlas_glyph_t *g;
+    text_span_t slot;
+    int16_t box[4];
+    uint16_t x = 0, y = 0;
+    uint32_t h, i;
+
+    h = ((uint32_t)(uintptr_t)font ^ character) * 2654435761u;
+    h = (h ^ (h >> 16)) & (VG_TEXT_ATLAS_GLYPHS - 1);
+    for (g = &g_text_atlas.glyphs[h]; g->font != NULL;
+         h = (h + 1) & (VG_TEXT_ATLAS_GLYPHS - 1), g = &g_text_atlas.glyphs[h]) {
+        if (g->font == font && g->character == character)
+            return g;
+    }
+
+    if (g_text_atlas.glyph_count >= VG_TEXT_ATLAS_GLYPHS * 3 / 4) {
+        if (text_atlas_reset() != VG_LITE_SUCCESS)
+            return NULL;
+        return text_atlas_lookup(font, character);
+    }
+
+    /* Glyph box clipped to the character box, one pixel gap so the glyphs do not bleed into each other. */
+    box[0] = font->width;
+    box[1] = font->height;
+    box[2] = 0;
+    box[3] = 0;
+    mf_render_character(font, 0, 0, character, atlas_bounds_callback, box);
+    if (box[0] < 0) box[0] = 0;
+    if (box[1] < 0) box[1] = 0;
+    if (box[2] > font->width) box[2] = font->width;
+    if (box[3] > font->height) box[3] = font->height;
+    if (box[0] < box[2] && box[1] < box[3] &&
+        !text_atlas_place(box[2] - box[0] + 1, box[3] - box[1] + 1, &x, &y)) {
+        if (g_text_atlas.glyph_count == 0 || text_atlas_reset() != VG_LITE_SUCCESS)
+            return NULL;
+        return text_atlas_lookup(font, character);
+    }
+
+    g->font = font;
+    g->character = character;
+    g->x = x;
+    g->y = y;
+    g->width = 0;
+    g->height = 0;
+    g->left = 0;
+    g->top = 0;
+    g_text_atlas.glyph_count++;
+    if (box[0] >= box[2] || box[1] >= box[3])
+        return g;
+
+    g->left = box[0];
+    g->top = box[1];
+    g->width = box[2] - box[0];
+    g->height = box[3] - box[1];
+    slot.memory = (uint8_t *)g_text_atlas.buffer.memory + y * g_text_atlas.buffer.stride + x;
+    slot.stride = g_text_atlas.buffer.stride;
+    slot.width = g->width;
+    slot.height = g->height;
+    slot.bytes_per_pixel = 1;
+    for (i = 0; i < g->height; i++)
+        memset(slot.memory + i * slot.stride, 0, g->width);
+    mf_render_character(font, -g->left, -g->top, character, span_callback, &slot);
+
+    return g;
+}
+#endif /* VG_TEXT_ATLAS */
+
 /* Callback to render characters. */
 static uint8_t character_callback(int16_t x, int16_t y, mf_char character,
                                   void *state)
 {
     text_context_t *s = (text_context_t*)state;
-    return mf_render_character(s->rcd_font, x, y, character, pixel_callback, state);
+    return mf_render_character(s->rcd_font, x, y, character, span_callback, &s->span);
+}
+
+#if VG_TEXT_ATLAS
+/* Callback to draw characters from the glyph atlas. */
+static uint8_t atlas_character_callback(int16_t x, int16_t y, mf_char character,
+                                        void *state)
+{
+    text_context_t *s = (text_context_t*)state;
+    atlas_glyph_t *g;
+    vg_lite_matrix_t m;
+    uint32_t rect[4];
+
+    if (s->error == VG_LITE_SUCCESS) {
+        g = text_atlas_lookup(s->rcd_font, character);
+        if (g == NULL) {
+            s->error = VG_LITE_OUT_OF_RESOURCES;
+        } else if (g->width > 0) {
+            m = s->matrix;
+            vg_lite_translate(x + g->left, y + g->top, &m);
+            rect[0] = g->x;
+            rect[1] = g->y;
+            rect[2] = g->width;
+            rect[3] = g->height;
+            s->error = vg_lite_blit_rect(s->target, &g_text_atlas.buffer, rect, &m,
+                                         s->blend, s->color, VG_LITE_FILTER_POINT);
+        }
+    }
+    return mf_character_width(s->rcd_font, character);
+}
+
+/* Callback to make sure that the glyphs are in the atlas, without drawing them. */
+static uint8_t atlas_lookup_callback(int16_t x, int16_t y, mf_char character,
+                                     void *state)
+{
+    text_context_t *s = (text_context_t*)state;
+
+    if (s->error == VG_LITE_SUCCESS && text_atlas_lookup(s->rcd_font, character) == NULL)
+        s->error = VG_LITE_OUT_OF_RESOURCES;
+    return mf_character_width(s->rcd_font, character);
+}
+
+/* A command list that blits from the atlas is freed. */
+static void text_atlas_release(vg_lite_command_list_t *list)
+{
+    (void)list;
+    if (g_text_atlas.pins > 0)
+        g_text_atlas.pins--;
+}
+
+/* Allocate the atlas on first use. Fonts with glyphs larger than the atlas can not use it. */
+static vg_lite_error_t text_atlas_prepare(const struct mf_font_s *font)
+{
+    vg_lite_error_t error;
+
+    if (font->width + 1 > VG_TEXT_ATLAS_WIDTH || font->height + 1 > VG_TEXT_ATLAS_HEIGHT)
+        return VG_LITE_NOT_SUPPORT;
+
+    if (g_text_atlas.buffer.handle == NULL) {
+        memset(&g_text_atlas, 0, sizeof(g_text_atlas));
+        g_text_atlas.buffer.width = VG_TEXT_ATLAS_WIDTH;
+        g_text_atlas.buffer.height = VG_TEXT_ATLAS_HEIGHT;
+        g_text_atlas.buffer.format = VG_LITE_A8;
+        error = vg_lite_allocate(&g_text_atlas.buffer);
+        if (error != VG_LITE_SUCCESS) {
+            memset(&g_text_atlas.buffer, 0, sizeof(g_text_atlas.buffer));
+            return error;
+        }
+        g_text_atlas.buffer.image_mode = VG_LITE_MULTIPLY_IMAGE_MODE;
+    }
+    return VG_LITE_SUCCESS;
+}
+#endif /* VG_TEXT_ATLAS */
+
+/* Forget atlas glyphs of a raster font that is freed. If the atlas can not be emptied, the glyphs
+   keep their space but no font matches them anymore. */
+void text_atlas_forget(const struct mf_font_s *font)
+{
+#if VG_TEXT_ATLAS
+    uint32_t i;
+
+    for (i = 0; i < VG_TEXT_ATLAS_GLYPHS; i++) {
+        if (g_text_atlas.glyphs[i].font == font) {
+            if (text_atlas_reset() == VG_LITE_SUCCESS)
+                return;
+            break;
+        }
+    }
+    for (; i < VG_TEXT_ATLAS_GLYPHS; i++) {
+        if (g_text_atlas.glyphs[i].font == font)
+            g_text_atlas.glyphs[i].font = (const struct mf_font_s *)&g_text_atlas;
+    }
+#endif /* VG_TEXT_ATLAS */
+}
+
+vg_lite_error_t vg_lite_text_free_atlas(void)
+{
+#if VG_TEXT_ATLAS
+    vg_lite_error_t error;
+
+    if (g_text_atlas.buffer.handle != NULL) {
+        /* Recorded command lists that blit from the atlas must be freed first. */
+        error = text_atlas_reset();
+        if (error != VG_LITE_SUCCESS)
+            return error;
+        error = vg_lite_free(&g_text_atlas.buffer);
+        memset(&g_text_atlas.buffer, 0, sizeof(g_text_atlas.buffer));
+        return error;
+    }
+#endif /* VG_TEXT_ATLAS */
+    return VG_LITE_SUCCESS;
 }
 
 /* Callback to render lines. */
@@ -134,13 +486,13 @@ static bool line_callback(const char *line, uint16_t count, void *state)
     {
         mf_render_justified(s->rcd_font, s->attributes->anchor, s->y,
                             s->width - s->attributes->margin * 2,
-                            line, count, character_callback, state);
+                            line, count, s->character, state);
     }
     else
     {
         mf_render_aligned(s->rcd_font, s->attributes->anchor, s->y,
                           (enum mf_align_t)s->attributes->alignment, line, count,
-                          character_callback, state);
+                          s->character, state);
     }
     s->y += s->rcd_font->line_height;
     return true;
@@ -166,10 +518,19 @@ vg_lite_error_t alloc_font_buffer(vg_lite_buffer_t *buffer, int width , int heig
     /* Allocate memory from VGLITE space */
     buffer->width  = width;
     buffer->height = height;
+#if VG_TEXT_BUFFER_A8
+    buffer->format = VG_LITE_A8;
+    buffer->image_mode = VG_LITE_MULTIPLY_IMAGE_MODE;
+#else
     buffer->format = VG_LITE_ARGB8888;
+#endif
     buffer->stride = 0;
-    error = vg_lite_allocate(buffer);
-    buffer->stride = width;
+    error = VG_LITE_OUT_OF_MEMORY;
+    if (g_text_arena != NULL)
+        error = vg_lite_arena_allocate_buffer(g_text_arena, buffer);
+    /* Without an arena, or when it is full, the buffer gets its own memory and is freed after the blit. */
+    if (error == VG_LITE_OUT_OF_MEMORY)
+        error = vg_lite_allocate(buffer);
     buffer->tiled = VG_LITE_LINEAR;
 
     return error;
@@ -184,6 +545,12 @@ static vg_lite_error_t free_font_buffer(vg_lite_buffer_t *buffer)
     return error;
 }
 
+vg_lite_error_t vg_lite_text_set_arena(vg_lite_arena_t *arena)
+{
+    g_text_arena = arena;
+    return VG_LITE_SUCCESS;
+}
+
 void matrix_multiply(vg_lite_matrix_t * matrix, vg_lite_matrix_t * mult)
 {
     vg_lite_matrix_t temp;
@@ -218,9 +585,11 @@ vg_lite_error_t vg_lite_draw_text(vg_lite_buffer_t *target,
     text_context_t ctx_text;
     vg_lite_matrix_t m_text;
     int text_img_size = 0;
-    font_face_desc_t* font_face = NULL;
     int text_width_in_pixels = 0;
     int tmpX;
+#if VG_TEXT_ATLAS
+    vg_lite_command_list_t *list;
+#endif
 
     memset(&ctx_text, 0, sizeof(ctx_text));
     ctx_text.attributes = attributes;
@@ -245,8 +614,6 @@ vg_lite_error_t vg_lite_draw_text(vg_lite_buffer_t *target,
 
     // Dynamic decision
     if ( attributes->is_vector_font == 0 ) {
-        init_256pallet_color_table(attributes->bg_color, attributes->text_color);
-
         /* Application specifies actual font by reading proper rcd file */
         ctx_text.rcd_font = _vg_lite_get_raster_font(font);
 
@@ -288,49 +655,99 @@ vg_lite_error_t vg_lite_draw_text(vg_lite_buffer_t *target,
             ctx_text.width += 15;
             ctx_text.width &= (~15);
         }
+        ctx_text.y = 2;
+
+        vg_lite_identity(&m_text);
+        matrix_multiply(&m_text, matrix);
+        vg_lite_translate(x, y, &m_text);
+        vg_lite_scale(1.0, 1.0, &m_text);
+
+#if VG_TEXT_ATLAS
+        /* Draw each glyph from the atlas, only glyphs not drawn before get decoded. If the atlas is full
+           and a command list keeps it from being emptied, the text buffer below is used instead. */
+        if (text_atlas_prepare(ctx_text.rcd_font) == VG_LITE_SUCCESS) {
+            list = vg_lite_get_recording_list();
+            if (list != NULL && list->release == NULL) {
+                list->release = text_atlas_release;
+                g_text_atlas.pins++;
+            }
+            ctx_text.target = target;
+            ctx_text.matrix = m_text;
+            ctx_text.blend = blend;
+            ctx_text.color = attributes->text_color | 0xFF000000;
+            ctx_text.error = VG_LITE_SUCCESS;
+
+            /* A pinned atlas can not be emptied, so check that the whole string fits before drawing any of it. */
+            if (g_text_atlas.pins > 0) {
+                ctx_text.character = atlas_lookup_callback;
+                mf_wordwrap(ctx_text.rcd_font, attributes->width - 2 * attributes->margin,
+                            text, line_callback, &ctx_text);
+                ctx_text.y = 2;
+            }
+            if (ctx_text.error == VG_LITE_SUCCESS) {
+                ctx_text.character = atlas_character_callback;
+                mf_wordwrap(ctx_text.rcd_font, attributes->width - 2 * attributes->margin,
+                            text, line_callback, &ctx_text);
+                error = ctx_text.error;
+                if ( error != VG_LITE_SUCCESS) {
+                    printf("WARNING: vg_lite_blit_rect failed(%d).\r\n",error);
+                }
+                attributes->last_dx = text_width_in_pixels;
+                attributes->last_x = x;
+                attributes->last_y = y;
+                return error;
+            }
+
+            /* The text buffer would be freed before the list is replayed. */
+            if (list != NULL)
+                return ctx_text.error;
+        }
+#endif /* VG_TEXT_ATLAS */
 
+#if !VG_TEXT_BUFFER_A8
+        init_256pallet_color_table(attributes->bg_color, attributes->text_color);
+#endif
+        ctx_text.character = character_callback;
         ctx_text.height = height;
         error = alloc_font_buffer(&ctx_text.buffer, ctx_text.width, ctx_text.height);
         if ( error != VG_LITE_SUCCESS) {
             printf("WARNING: alloc_font_buffer failed(%d).\r\n",error);
         }
-        ctx_text.y = 2;
 
         /* Initialize vg_lite buffer with transperant color */
         /* Due to alignment requirement of vg_lite, font buffer can be larger */
-        if ( ctx_text.buffer.format == VG_LITE_ARGB8888 )
-          text_img_size = ctx_text.buffer.width * ctx_text.buffer.height * 4;
-        else
-          text_img_size = ctx_text.buffer.width * ctx_text.buffer.height;
+        text_img_size = ctx_text.buffer.stride * ctx_text.buffer.height;
         memset(ctx_text.buffer.memory, 0,
                text_img_size);
+        ctx_text.span.memory = (uint8_t *)ctx_text.buffer.memory;
+        ctx_text.span.stride = ctx_text.buffer.stride;
+        ctx_text.span.width = ctx_text.width;
+        ctx_text.span.height = ctx_text.height;
+        ctx_text.span.bytes_per_pixel = (ctx_text.buffer.format == VG_LITE_A8) ? 1 : 4;
 
         /* Render font text into vg_lite_buffer  */
         mf_wordwrap(ctx_text.rcd_font, attributes->width - 2 * attributes->margin,
                     text, line_callback, &ctx_text);
         
         /* Draw font bitmap on render target */
-        vg_lite_identity(&m_text);
-        matrix_multiply(&m_text, matrix);
-        vg_lite_translate(x, y, &m_text);
-        vg_lite_scale(1.0, 1.0, &m_text);
-        if ( ctx_text.buffer.format == VG_LITE_ARGB8888 )
-          ctx_text.buffer.stride = ctx_text.width*4;
-
         error = vg_lite_blit(target, &ctx_text.buffer, &m_text, blend,
-                    0, VG_LITE_FILTER_POINT);
+                    (ctx_text.buffer.format == VG_LITE_A8) ? (attributes->text_color | 0xFF000000) : 0,
+                    VG_LITE_FILTER_POINT);
         if ( error != VG_LITE_SUCCESS) {
             printf("WARNING: vg_lite_blit failed(%d).\r\n",error);
         }
 
-        error = vg_lite_finish();
-        if ( error != VG_LITE_SUCCESS) {
-            printf("WARNING: vg_lite_finish failed(%d).\r\n",error);
-        }
-
-        error = free_font_buffer(&ctx_text.buffer);
-        if ( error != VG_LITE_SUCCESS) {
-            printf("WARNING: vg_lite_finish failed(%d).\r\n",error);
+        /* Arena buffers live until the frame is done, no need to wait. */
+        if (ctx_text.buffer.handle != NULL) {
+            error = vg_lite_finish();
+            if ( error != VG_LITE_SUCCESS) {
+                printf("WARNING: vg_lite_finish failed(%d).\r\n",error);
+            }
+
+            error = free_font_buffer(&ctx_text.buffer);
+            if ( error != VG_LITE_SUCCESS) {
+                printf("WARNING: vg_lite_finish failed(%d).\r\n",error);
+            }
         }
         attributes->last_dx = text_width_in_pixels;
     } else {
@@ -344,13 +761,6 @@ vg_lite_error_t vg_lite_draw_text(vg_lite_buffer_t *target,
          /* Note: vg_lite_vtf_draw_text updates attributes->last_dx internally
             This assignment is just to keep code similar to rcd code */
         attributes->last_dx = attributes->last_dx;
-        
-        error = vg_lite_finish();
-        if ( error != VG_LITE_SUCCESS) {
-            printf("WARNING: vg_lite_finish failed(%d).\r\n",error);
-        }
-
-        vft_unload(font_face);
     }
     attributes->last_x = x;
     attributes->last_y = y;
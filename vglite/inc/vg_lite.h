@@ -476,6 +476,46 @@ extern "C" {
     }
     vg_lite_sub_path_t;
 
+    /* Block of stroke conversion storage. Points and sub paths are carved out of these blocks
+       instead of being allocated one by one. Only one block of the initial size is kept between updates. */
+    typedef struct vg_lite_stroke_block *    vg_lite_stroke_block_ptr;
+    typedef struct vg_lite_stroke_block
+    {
+        /* Pointer to next block. */
+        vg_lite_stroke_block_ptr         next;
+
+        /* Usable bytes following this header. */
+        uint32_t                         capacity;
+
+        /* Bytes handed out since the last reset. */
+        uint32_t                         used;
+    }
+    vg_lite_stroke_block_t;
+
+    /* Inputs a cached stroke was generated from. */
+    typedef struct vg_lite_stroke_key
+    {
+        /* Path data, by address and length. */
+        void *                           path;
+        int32_t                          path_length;
+        vg_lite_format_t                 format;
+
+        /* Stroke parameters. */
+        vg_lite_cap_style_t              cap_style;
+        vg_lite_join_style_t             join_style;
+        vg_lite_float_t                  line_width;
+        vg_lite_float_t                  miter_limit;
+        vg_lite_float_t *                dash_pattern;
+        uint32_t                         dash_pattern_count;
+        vg_lite_float_t                  dash_phase;
+        vg_lite_float_t                  flatten_scale;
+        vg_lite_float_t                  quantize_error;
+
+        /* FNV-1a hash of the path data and the dash pattern, which may be edited in place. */
+        uint32_t                         hash;
+    }
+    vg_lite_stroke_key_t;
+
     typedef struct vg_lite_stroke_conversion
     {
         /* Stroke parameters */
@@ -525,6 +565,29 @@ extern "C" {
         vg_lite_float_t                    swing_center_length;
         uint32_t                           swing_count;
 
+        /* Storage for the point and sub path lists above. */
+        vg_lite_stroke_block_ptr           block_list;
+        vg_lite_stroke_block_ptr           current_block;
+
+        /* Largest scale of the draw transform, 0 flattens curves with the tolerance in path coordinates. */
+        vg_lite_float_t                    flatten_scale;
+
+        /* Largest coordinate error in target pixels allowed for integer stroke path data, 0 keeps VG_LITE_FP32. */
+        vg_lite_float_t                    quantize_error;
+        /* Coordinate format of the stroke path data. */
+        vg_lite_format_t                   stroke_path_format;
+
+        /* Stroke cache: key of the path and stroke parameters that produced the stroke path data. */
+        vg_lite_stroke_key_t               stroke_key;
+        uint8_t                            stroke_cached;
+        uint32_t                           stroke_cache_hits;
+        uint32_t                           stroke_cache_misses;
+
+        /* Stroke path data uploaded to GPU memory once it stays unchanged. */
+        void *                             uploaded_handle;
+        uint32_t                           uploaded_address;
+        uint32_t                           uploaded_bytes;
+
         vg_lite_float_t                    stroke_path_length;
         uint32_t                           stroke_path_size;
         /* The stroke line is fat line. */
@@ -608,7 +671,7 @@ extern "C" {
         vg_lite_hw_memory_t uploaded;       /*! Path data that has been upload into GPU addressable memory. */
         int32_t path_length;                /*! Number of bytes in the path data. */
         void *path;                         /*! Pointer to the physical description of the path. */
-        int8_t path_changed;               /* Indicate whether path data is synced with command buffer (uploaded) or not. */
+        int8_t path_changed;               /* Indicate whether path data is synced with command buffer (uploaded) or not. Set it after modifying the data in place. */
         int8_t pdata_internal;             /*! Indicate whether path data memory is allocated by driver. */
         vg_lite_stroke_conversion_t *stroke_conversion; /*! Refer to the definition by <code>vg_lite_stroke_conversion_t</code>.*/
         vg_lite_draw_path_type_t path_type;            /*! Refer to the definition by <code>vg_lite_draw_path_type_t</code>. */
@@ -646,6 +709,41 @@ extern "C" {
         uint32_t tessellation_origin[2];
     } vg_lite_tsbuffer_info_t;
 
+    /*!
+     @abstract Patchable words of one recorded command.
+
+     @discussion
+     Each vg_lite_clear, vg_lite_blit, vg_lite_blit_rect, vg_lite_draw, vg_lite_draw_pattern, vg_lite_draw_gradient,
+     vg_lite_draw_linear_gradient or vg_lite_draw_radial_gradient call recorded into a command list adds one entry, which locates
+     the words that can be patched with {@link vg_lite_command_list_set_color}, {@link vg_lite_command_list_set_stroke_color} and
+     {@link vg_lite_command_list_set_matrix}.
+     */
+    typedef struct vg_lite_command_list_entry {
+        uint32_t color_offset;          /*! Byte offset of the color state data word in the list, 0 if the command has no color. */
+        uint32_t matrix_offset;         /*! Byte offset of the first matrix state command in the list, 0 if the command has no matrix. */
+        uint32_t stroke_color_offset;   /*! Byte offset of the stroke color state data word, 0 if the command has no stroke. */
+        uint32_t luminance;             /*! 1 if the color is converted to luminance (clear of an L8 target). */
+    } vg_lite_command_list_entry_t;
+
+    /*!
+     @abstract A retained, pre-encoded command list.
+
+     @discussion
+     A command list holds the GPU commands of a sequence of drawing calls in GPU addressable memory. It is recorded once between
+     {@link vg_lite_begin_command_list} and {@link vg_lite_end_command_list}, and replayed with {@link vg_lite_call_command_list} by a
+     single "call" command, without encoding the states again.
+     */
+    typedef struct vg_lite_command_list {
+        vg_lite_hw_memory_t buffer;                 /*! GPU memory holding the recorded commands. */
+        uint32_t length;                            /*! Number of recorded bytes, including the final "return" command. */
+        uint32_t tessellation;                      /*! 1 if the tessellation buffer states are recorded in the list. */
+        vg_lite_command_list_entry_t *entries;      /*! Patch table, one entry per recorded command. */
+        uint32_t entry_count;                       /*! Number of valid entries. */
+        uint32_t entry_capacity;                    /*! Number of allocated entries. */
+        void (*release)(struct vg_lite_command_list *list); /*! Called by vg_lite_free_command_list, set by the module whose
+                                                                resources the list uses, e.g. the glyph atlas of raster text. */
+    } vg_lite_command_list_t;
+
     /* Linear Gradient definitions. */
 #define VLC_MAX_GRAD            16              /*! The max number of gradient stops. */
 #define VLC_GRADBUFFER_WIDTH    256             /*! The internal buffer width.*/
@@ -1050,6 +1148,201 @@ extern "C" {
      */
     vg_lite_error_t vg_lite_flush(void);
 
+#define VG_LITE_FENCE_INFINITE  0xFFFFFFFF  /*! Timeout for {@link vg_lite_fence_wait} that never expires. */
+
+    /*!
+     @abstract A fence marking a point in the command stream.
+
+     @discussion
+     A fence is signaled when all commands issued before {@link vg_lite_fence_insert} have been executed by the GPU.
+     */
+    typedef struct vg_lite_fence {
+        uint32_t serial;        /*! Submission serial number of the fenced command buffer, 0 if nothing is pending. */
+        uint32_t command_id;    /*! Index of the fenced command buffer. */
+    } vg_lite_fence_t;
+
+    /*!
+     @abstract Insert a fence after the commands issued so far.
+
+     @discussion
+     The fence does not submit anything by itself. It is signaled once the command buffer holding the commands issued so far
+     has been submitted, by vg_lite_flush, vg_lite_finish or {@link vg_lite_fence_wait}, and executed.
+
+     @param fence
+     Pointer to the <code>vg_lite_fence_t</code> structure to initialize.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_fence_insert(vg_lite_fence_t *fence);
+
+    /*!
+     @abstract Check whether a fence is signaled, without waiting.
+
+     @param fence
+     Pointer to a <code>vg_lite_fence_t</code> structure initialized by {@link vg_lite_fence_insert}.
+
+     @result
+     1 if all fenced commands have been executed, 0 otherwise.
+     */
+    uint32_t vg_lite_fence_is_signaled(vg_lite_fence_t *fence);
+
+    /*!
+     @abstract Wait until a fence is signaled.
+
+     @discussion
+     The fenced commands are submitted first if they are still in the current command buffer. Commands issued after the fence
+     do not have to complete.
+
+     @param fence
+     Pointer to a <code>vg_lite_fence_t</code> structure initialized by {@link vg_lite_fence_insert}.
+
+     @param timeout
+     Maximum time to wait in milliseconds. 0 only polls the fence, VG_LITE_FENCE_INFINITE waits forever.
+
+     @result
+     VG_LITE_SUCCESS when signaled, VG_LITE_TIMEOUT if the fence is not signaled within the timeout.
+     */
+    vg_lite_error_t vg_lite_fence_wait(vg_lite_fence_t *fence, uint32_t timeout);
+
+    /*!
+     @abstract Get how long the GPU took to execute the command buffer of a fence.
+
+     @discussion
+     The time runs from starting the command buffer to its completion interrupt, in units of the platform's
+     vg_lite_os_timestamp counter. It stays available until the command buffer is reused, CMDBUF_COUNT
+     submissions later.
+
+     @param fence
+     Pointer to a <code>vg_lite_fence_t</code> structure initialized by {@link vg_lite_fence_insert}.
+
+     @param time
+     Receives the execution time.
+
+     @result
+     VG_LITE_TIMEOUT if the fence is not signaled yet, VG_LITE_INVALID_ARGUMENT if the command buffer has been reused.
+     */
+    vg_lite_error_t vg_lite_fence_get_gpu_time(vg_lite_fence_t *fence, uint32_t *time);
+
+#define VG_LITE_ARENA_FRAMES    2   /*! Number of frames a {@link vg_lite_arena_t} can have in flight. */
+
+    /*!
+     @abstract A linear allocator for GPU memory that lives for one frame.
+
+     @discussion
+     The arena is one contiguous allocation split into VG_LITE_ARENA_FRAMES segments. Allocations are bumped from the segment
+     of the current frame and are never freed one by one. {@link vg_lite_arena_reset} ends the frame with a fence and moves
+     to the next segment, which is reused only after the fence of the frame that last used it has signaled.
+     */
+    typedef struct vg_lite_arena {
+        vg_lite_hw_memory_t memory;     /*! The whole arena. */
+        uint32_t frame_bytes;           /*! Size of one segment. */
+        uint32_t frame;                 /*! Segment of the current frame. */
+        uint32_t offset;                /*! Bytes used in the current segment. */
+        uint32_t peak;                  /*! Largest number of bytes a frame has used. */
+        void *paths;                    /*! Paths uploaded in the current frame. */
+        vg_lite_fence_t fences[VG_LITE_ARENA_FRAMES];   /*! End of the last frame that used each segment. */
+    } vg_lite_arena_t;
+
+    /*!
+     @abstract Allocate the GPU memory of an arena.
+
+     @param arena
+     Pointer to the <code>vg_lite_arena_t</code> structure to initialize.
+
+     @param frame_bytes
+     Bytes available to a single frame.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_arena_create(vg_lite_arena_t *arena, uint32_t frame_bytes);
+
+    /*!
+     @abstract Wait for all frames of an arena and free its GPU memory.
+
+     @param arena
+     Pointer to a <code>vg_lite_arena_t</code> structure initialized by {@link vg_lite_arena_create}.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_arena_destroy(vg_lite_arena_t *arena);
+
+    /*!
+     @abstract Allocate GPU memory for the current frame.
+
+     @discussion
+     The memory is 64 byte aligned and stays valid until the GPU has finished the frame.
+
+     @param arena
+     Pointer to a <code>vg_lite_arena_t</code> structure initialized by {@link vg_lite_arena_create}.
+
+     @param bytes
+     Number of bytes to allocate.
+
+     @param memory
+     Receives the logical address of the memory.
+
+     @param address
+     Receives the GPU address of the memory.
+
+     @result
+     VG_LITE_OUT_OF_MEMORY if the segment of the current frame is full.
+     */
+    vg_lite_error_t vg_lite_arena_alloc(vg_lite_arena_t *arena, uint32_t bytes, void **memory, uint32_t *address);
+
+    /*!
+     @abstract Allocate a buffer for the current frame.
+
+     @discussion
+     Works like vg_lite_allocate, but the buffer memory comes from the arena. The buffer must not be passed to vg_lite_free.
+     Planar YUV formats are not supported.
+
+     @param arena
+     Pointer to a <code>vg_lite_arena_t</code> structure initialized by {@link vg_lite_arena_create}.
+
+     @param buffer
+     Pointer to the buffer, with width, height and format set.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_arena_allocate_buffer(vg_lite_arena_t *arena, vg_lite_buffer_t *buffer);
+
+    /*!
+     @abstract Upload a path into the current frame of an arena.
+
+     @discussion
+     Works like vg_lite_upload_path for paths that are drawn once. {@link vg_lite_arena_reset} clears the upload of the
+     path, so the path structure must stay valid until then.
+
+     @param arena
+     Pointer to a <code>vg_lite_arena_t</code> structure initialized by {@link vg_lite_arena_create}.
+
+     @param path
+     Pointer to the path to upload.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_arena_upload_path(vg_lite_arena_t *arena, vg_lite_path_t *path);
+
+    /*!
+     @abstract End the frame of an arena.
+
+     @discussion
+     Fences the commands issued so far and switches to the next segment, waiting for the frame that used it before.
+     Paths uploaded into the frame are marked as not uploaded again.
+
+     @param arena
+     Pointer to a <code>vg_lite_arena_t</code> structure initialized by {@link vg_lite_arena_create}.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_arena_reset(vg_lite_arena_t *arena);
+
     /*!
      @abstract Draw a path to a target buffer.
 
@@ -1087,6 +1380,68 @@ extern "C" {
                                  vg_lite_blend_t   blend,
                                  vg_lite_color_t   color);
 
+    /*!
+     @abstract One path of a batched draw.
+     */
+    typedef struct vg_lite_draw_item {
+        vg_lite_path_t   *path;         /*! Path to draw, filled and/or stroked as its path_type says. */
+        vg_lite_matrix_t *matrix;       /*! Transformation matrix of the path, must not be NULL. */
+        vg_lite_fill_t    fill_rule;    /*! Fill rule of the path. */
+        vg_lite_color_t   color;        /*! Fill color, the stroke uses the stroke color of the path. */
+    } vg_lite_draw_item_t;
+
+    /*!
+     @abstract Draw many paths to a target buffer at once.
+
+     @discussion
+     Draws the same as calling vg_lite_draw for every item in order, but for targets larger than the tessellation
+     buffer the paths are binned into tessellation tiles first. Every tile is set up once and tessellates only the
+     paths whose bounds touch it, in draw order, and path states that did not change since the previous path are
+     not sent again. This makes scenes with many small paths, such as icons, much cheaper than one vg_lite_draw
+     per path. While a command list is recorded, the items are drawn one by one.
+
+     @param target
+     Pointer to a <code>vg_lite_buffer_t</code> structure that describes the target of the draw.
+
+     @param items
+     Array of <code>count</code> paths with their matrix, fill rule and color.
+
+     @param count
+     Number of items.
+
+     @param blend
+     The blending mode applied to all paths.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>. VG_LITE_OUT_OF_RESOURCES if the tile bins
+     can not be allocated.
+     */
+    vg_lite_error_t vg_lite_draw_paths(vg_lite_buffer_t    *target,
+                                       vg_lite_draw_item_t *items,
+                                       uint32_t             count,
+                                       vg_lite_blend_t      blend);
+
+    /*!
+     @abstract Get the area a path covers when drawn.
+
+     @discussion
+     The bounding box of the path is transformed the same way as in {@link vg_lite_draw}. The result is rounded outwards,
+     so it can be used as damage region for partial redraws.
+
+     @param path
+     Pointer to the path.
+
+     @param matrix
+     Transformation matrix that will be used to draw the path, or NULL for identity.
+
+     @param bounds
+     Receives the covered area in target coordinates.
+
+     @result
+     VG_LITE_INVALID_ARGUMENT if the matrix projects the path behind the viewer.
+     */
+    vg_lite_error_t vg_lite_get_path_bounds(vg_lite_path_t *path, vg_lite_matrix_t *matrix, vg_lite_rectangle_t *bounds);
+
     /*!
      @abstract Set stroke path's attributes.
 
@@ -1153,6 +1508,11 @@ extern "C" {
      This function use the given path and stroke attributes given by function vg_lite_set_stroke 
      to update stroke path's parameters and generate stroke path data.
 
+     The stroke path data is cached. If neither the path data nor the stroke attributes changed since the last
+     update, the previous stroke path data is kept and uploaded to GPU memory, so later draws reference it instead
+     of copying it into the command buffer. stroke_cache_hits and stroke_cache_misses in the stroke conversion
+     count how often the cache was used.
+
      @param path
      Pointer to a <code>vg_lite_path_t</code> structure that describes the path.
 
@@ -1161,6 +1521,47 @@ extern "C" {
      */
     vg_lite_error_t vg_lite_update_stroke(vg_lite_path_t *path);
 
+    /*!
+     @abstract Set the transform a stroke path will be drawn with.
+
+     @discussion
+     Curves are flattened into line segments when the stroke path is generated. By default the flattening tolerance
+     is measured in path coordinates, so a path that is drawn scaled up shows visible facets and a path that is drawn
+     scaled down gets more segments than it needs. With a matrix set, vg_lite_update_stroke keeps the flattening error
+     below the tolerance in target pixels, using the largest scale of the matrix.
+
+     @param path
+     Pointer to a <code>vg_lite_path_t</code> structure whose stroke was set with vg_lite_set_stroke.
+
+     @param matrix
+     The matrix the path will be drawn with, or NULL to flatten in path coordinates again.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_set_stroke_transform(vg_lite_path_t *path, vg_lite_matrix_t *matrix);
+
+    /*!
+     @abstract Allow the stroke path to be stored with integer coordinates.
+
+     @discussion
+     vg_lite_update_stroke generates VG_LITE_FP32 stroke path data by default. With a precision set, the generated
+     coordinates are rounded to VG_LITE_S16, or VG_LITE_S32 if the stroke does not fit into 16 bits, as long as
+     rounding moves no point by more than max_error target pixels. Rounding moves a point by up to half a path unit,
+     scaled by the transform set with vg_lite_set_stroke_transform. S16 data halves the size of the stroke path
+     that is copied into the command buffer or uploaded to GPU memory.
+
+     @param path
+     Pointer to a <code>vg_lite_path_t</code> structure whose stroke was set with vg_lite_set_stroke.
+
+     @param max_error
+     The largest coordinate error in target pixels, or 0 to always generate VG_LITE_FP32 stroke path data.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_set_stroke_precision(vg_lite_path_t *path, vg_lite_float_t max_error);
+
     /*!
      @abstract Set path type.
 
@@ -1376,6 +1777,28 @@ extern "C" {
                              void           *data,
                              uint32_t        seg_count);
 
+    /*!
+     @abstract Rewrite a path into a smaller equivalent form.
+
+     @discussion
+     The path data is rewritten in place: consecutive LINE commands that continue in the same direction are merged,
+     segments that do not leave the current point and MOVE commands directly followed by another MOVE are dropped,
+     and relative commands become absolute. If all coordinates are integers, the path is converted to VG_LITE_S8 or
+     VG_LITE_S16 when that is smaller than its format, using relative commands where only their coordinates fit.
+     The bounding box is recomputed from the drawn segments, including the extremes of curves.
+     Since zero-length segments are removed, a sub path that is a single point no longer gets caps when stroked.
+     Paths with arc commands are not supported.
+
+     @param path
+     The path object. path_length, format and bounding_box are updated and path_changed is set. The upload of a path
+     uploaded with vg_lite_upload_path is freed, call it again to draw the optimized path from GPU memory.
+
+     @result
+     VG_LITE_NOT_SUPPORT if the path contains arc commands, otherwise the status as defined by
+     <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_optimize_path(vg_lite_path_t *path);
+
     /*!
      @abstract Upload a path to GPU memory.
 
@@ -1397,6 +1820,134 @@ extern "C" {
      */
     vg_lite_error_t vg_lite_upload_path(vg_lite_path_t *path);
 
+    /*!
+     @abstract Start recording a command list.
+
+     @discussion
+     All following vg_lite_clear, vg_lite_blit, vg_lite_blit_rect and vg_lite_draw calls of the current task are encoded into the
+     list instead of the command buffer, until {@link vg_lite_end_command_list} is called. Nothing is submitted to the GPU while
+     recording, so vg_lite_finish and vg_lite_flush are rejected. Paths drawn into a list are always embedded into it, even if they
+     were uploaded.
+
+     If the list runs out of space, the recorded call returns VG_LITE_OUT_OF_RESOURCES. The list must then be ended, freed and
+     recorded again with a larger size.
+
+     @param list
+     Pointer to the <code>vg_lite_command_list_t</code> structure to record into.
+
+     @param size
+     Number of bytes of GPU memory to allocate for the list.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_begin_command_list(vg_lite_command_list_t *list, uint32_t size);
+
+    /*!
+     @abstract Stop recording a command list.
+
+     @param list
+     Pointer to the <code>vg_lite_command_list_t</code> structure passed to {@link vg_lite_begin_command_list}.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_end_command_list(vg_lite_command_list_t *list);
+
+    /*!
+     @abstract Get the command list that the current task is recording.
+
+     @result
+     The list passed to {@link vg_lite_begin_command_list}, or NULL if no list is being recorded.
+     */
+    vg_lite_command_list_t *vg_lite_get_recording_list(void);
+
+    /*!
+     @abstract Replay a recorded command list.
+
+     @discussion
+     A "call" command to the list is pushed into the current command buffer. The list stays in use by the GPU until that command
+     buffer completes, so it must not be patched or freed before then.
+
+     @param list
+     Pointer to a recorded <code>vg_lite_command_list_t</code> structure.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_call_command_list(vg_lite_command_list_t *list);
+
+    /*!
+     @abstract Patch the color of a recorded command.
+
+     @discussion
+     This is the clear or fill color, the blit color, or the pattern color of vg_lite_draw_pattern and vg_lite_draw_gradient.
+     vg_lite_draw_linear_gradient and vg_lite_draw_radial_gradient have no color, patching them fails.
+
+     @param list
+     Pointer to a recorded <code>vg_lite_command_list_t</code> structure.
+
+     @param index
+     Index of the command in recording order.
+
+     @param color
+     The new color, in the same form as passed to the recorded call.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_command_list_set_color(vg_lite_command_list_t *list, uint32_t index, vg_lite_color_t color);
+
+    /*!
+     @abstract Patch the stroke color of a recorded draw of a stroke or fill and stroke path.
+
+     @param list
+     Pointer to a recorded <code>vg_lite_command_list_t</code> structure.
+
+     @param index
+     Index of the command in recording order.
+
+     @param color
+     The new stroke color.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>. VG_LITE_INVALID_ARGUMENT if the command draws no stroke.
+     */
+    vg_lite_error_t vg_lite_command_list_set_stroke_color(vg_lite_command_list_t *list, uint32_t index, vg_lite_color_t color);
+
+    /*!
+     @abstract Patch the path matrix of a recorded draw command.
+
+     @discussion
+     Only the path transformation is patched, the pattern or gradient of a pattern or gradient draw keeps its matrix. The
+     tessellation area of the command is the one computed at recording time, so the transformed path must stay inside it unless
+     the tessellation buffer covers the whole target.
+
+     @param list
+     Pointer to a recorded <code>vg_lite_command_list_t</code> structure.
+
+     @param index
+     Index of the command in recording order.
+
+     @param matrix
+     The new transformation matrix.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_command_list_set_matrix(vg_lite_command_list_t *list, uint32_t index, vg_lite_matrix_t *matrix);
+
+    /*!
+     @abstract Free the resources of a command list.
+
+     @param list
+     Pointer to the <code>vg_lite_command_list_t</code> structure to free.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_free_command_list(vg_lite_command_list_t *list);
+
     /*!
      @abstract Set the current CLUT (Color Look Up Table) for index image to use.
 
@@ -1910,6 +2461,28 @@ extern "C" {
      */
     void vg_lite_rotate(vg_lite_float_t degrees, vg_lite_matrix_t *matrix);
 
+    /*!
+     @abstract Transform an array of points.
+
+     @discussion
+     Transforms count points, stored as x/y pairs, by a matrix in one call. Points that end up behind the
+     projection plane of a perspective matrix are set to 0.
+
+     @param matrix
+     Pointer to a <code>vg_lite_matrix_t</code> structure with the transformation.
+
+     @param points
+     Array of 2 * count floats holding the source points.
+
+     @param result
+     Array of 2 * count floats receiving the transformed points. It can be the same array as points.
+
+     @param count
+     Number of points.
+     */
+    void vg_lite_transform_points(vg_lite_matrix_t *matrix, const vg_lite_float_t *points,
+                                  vg_lite_float_t *result, uint32_t count);
+
     /*!
      @abstract Set the command buffer size.
 
@@ -1960,6 +2533,85 @@ extern "C" {
       return VG_LITE_NO_CONTEXT if not initialized.*/
     vg_lite_error_t vg_lite_mem_avail(uint32_t *size);
 
+    /*!
+     @abstract Fragmentation statistics of the contiguous video memory.
+     */
+    typedef struct vg_lite_mem_stats {
+        uint32_t bytes_free;    /*! Bytes available for allocations, same as {@link vg_lite_mem_avail}. */
+        uint32_t largest_free;  /*! Largest single allocation that can succeed. */
+        uint32_t free_blocks;   /*! Number of free blocks the free memory is split into. */
+        uint32_t used_blocks;   /*! Number of allocations currently alive. */
+    } vg_lite_mem_stats_t;
+
+    /*!
+      @abstract query the fragmentation of the contiguous video memory.
+
+      @discussion
+      A <code>largest_free</code> much smaller than <code>bytes_free</code> means the free memory is fragmented.
+
+      @param stats
+      This is a pointer to the statistics to fill in.
+
+      @result
+      Returns the status as defined by <code>vg_lite_error_t</code>. return VG_LITE_NO_CONTEXT if not initialized.*/
+    vg_lite_error_t vg_lite_mem_stats(vg_lite_mem_stats_t *stats);
+
+    /*!
+     @abstract Statistics of the driver path cache.
+
+     @discussion
+     vg_lite_draw uploads the fill path of a draw to GPU memory once the same path has been drawn VG_PATH_CACHE_HOT
+     times without changing, so later draws call it instead of copying it into the command buffer for every
+     tessellation tile. The least recently drawn paths are dropped when VG_PATH_CACHE_SIZE bytes or the GPU memory
+     are used up. A path counts as changed when its data pointer or path_length differ from the last draw, or when
+     its path_changed flag is set, which vg_lite_init_path and vg_lite_path_append do. The data is not compared, so an
+     application that modifies path data in place has to set path_changed, or the cached copy is drawn.
+     Paths uploaded with vg_lite_upload_path and draws recorded into a command list do not use the cache.
+     */
+    typedef struct vg_lite_path_cache_stats {
+        uint32_t hits;          /*! Draws that called a path already in the cache. */
+        uint32_t misses;        /*! Draws that copied the path or uploaded it first. */
+        uint32_t uploads;       /*! Paths uploaded to the cache. */
+        uint32_t evictions;     /*! Uploaded paths dropped to make room for others. */
+        uint32_t bytes;         /*! GPU memory held by the cache. */
+    } vg_lite_path_cache_stats_t;
+
+    /*!
+      @abstract Query the statistics of the driver path cache.
+
+      @param stats
+      This is a pointer to the statistics to fill in.
+
+      @result
+      Returns the status as defined by <code>vg_lite_error_t</code>. return VG_LITE_NO_CONTEXT if not initialized.*/
+    vg_lite_error_t vg_lite_get_path_cache_stats(vg_lite_path_cache_stats_t *stats);
+
+    /*!
+     @abstract Statistics of the state writes the driver did not put into the command buffer.
+
+     @discussion
+     The driver keeps the last value of the blend, color, tessellation control, tessellation scale and bias and
+     matrix registers. Writing the value a register already holds is dropped, and writes to consecutive registers
+     are merged into one state command. The values are forgotten when a command buffer is submitted and after
+     vg_lite_call_command_list. Draws recorded into a command list always write every state.
+     Building the driver with VG_STATE_SHADOW set to 0 turns this off.
+     */
+    typedef struct vg_lite_state_stats {
+        uint32_t elided;        /*! State writes dropped because the register held the value already. */
+        uint32_t coalesced;     /*! State writes merged into the previous state command. */
+        uint32_t words_saved;   /*! Command buffer words these saved. */
+    } vg_lite_state_stats_t;
+
+    /*!
+      @abstract Query the statistics of dropped and merged state writes.
+
+      @param stats
+      This is a pointer to the statistics to fill in.
+
+      @result
+      Returns the status as defined by <code>vg_lite_error_t</code>. return VG_LITE_NO_CONTEXT if not initialized.*/
+    vg_lite_error_t vg_lite_get_state_stats(vg_lite_state_stats_t *stats);
+
     /*!
       @abstract Enable premultiply.
 
@@ -1985,6 +2637,25 @@ extern "C" {
      */
     vg_lite_error_t vg_lite_set_dither(int enable);
 
+    /*!
+     @abstract Turn the elision of tessellation stalls on or off for the current context.
+
+     @discussion
+     Every tessellation is preceded by a full pipeline stall, since all tessellations share one tessellation buffer,
+     and every draw ends with a flush and a stall. With elision, on by default, the stall that ends a draw is the
+     full one, so the next draw tessellates without stalling again unless something else tessellated in between.
+     Commands recorded into a command list do the same within the list. Building the driver with VG_STALL_ELISION
+     set to 0 removes it.
+
+     @param enable
+     0 stalls before every tessellation, 1 skips the stalls that follow a full one.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>. VG_LITE_NOT_SUPPORT if the driver is built
+     without VG_STALL_ELISION.
+     */
+    vg_lite_error_t vg_lite_set_stall_elision(int enable);
+
     /*!
       @abstract use to set the colorkey.
 
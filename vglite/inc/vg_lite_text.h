@@ -170,7 +170,8 @@ extern "C" {
         int height; /*! Internal variable computed based on active font */
 
         unsigned int text_color; /*! Foreground text color */
-        unsigned int bg_color;   /*! Background text color */
+        unsigned int bg_color;   /*! Background text color, raster text blends with it only when built
+                                     with VG_TEXT_ATLAS and VG_TEXT_BUFFER_A8 set to 0 */
         
         int tspan_has_dx_dy; /*! 0 means tspan element has x,y values
                               1 means tspan element has dx, dy values
@@ -194,6 +195,30 @@ extern "C" {
         int last_dx;     /*! Horizontal width of text in pixels, for last text */
     } vg_lite_font_attributes_t;
 
+    /*!
+     @abstract Precomputed placement of a vector font string
+
+     @discussion
+     Filled in by <code>vg_lite_text_layout</code> and drawn by
+     <code>vg_lite_draw_text_layout</code>. Zero initialize it before the
+     first use and release it with <code>vg_lite_text_layout_free</code>.
+     Application code should only read the fields.
+     */
+    typedef struct vg_lite_text_layout {
+        vg_lite_font_t font; /*! Font of the laid out text */
+        int font_height;     /*! Font height in pixels */
+        int alignment;       /*! Alignment the text was laid out with */
+        int align_dx;        /*! Horizontal offset from x of the first glyph in pixels */
+        int width;           /*! Horizontal width of text in pixels, like last_dx */
+        uint32_t length;     /*! Number of glyphs */
+
+        /* Internal parameters */
+        uint32_t capacity;   /*! Glyphs that fit without allocating again */
+        char *text;          /*! Copy of the laid out text */
+        void *font_face;     /*! Font data the glyphs point into */
+        void *glyphs;        /*! Glyphs and their advances */
+    } vg_lite_text_layout_t;
+
   /* API Function prototypes ****************************************************/
 
     /*!
@@ -316,6 +341,157 @@ extern "C" {
                       vg_lite_blend_t blend,
                       vg_lite_font_attributes_t *attributes);
 
+    /*!
+     @abstract Lay out text for repeated drawing with a vector font.
+
+     @discussion
+     Looks up the glyphs, kerning and alignment offset of the text once, so
+     <code>vg_lite_draw_text_layout</code> only has to draw the glyphs.
+     Calling it again with the same text, font, font_height and alignment
+     returns without doing anything, so it can be called every frame.
+
+     @param layout
+     Pointer to the layout to fill in.
+
+     @param text
+     ASCII text to lay out.
+
+     @param font
+     Font handle of a vector font.
+
+     @param attributes
+     font_height and alignment are used.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+        VG_LITE_SUCCESS when text is laid out
+        VG_LITE_INVALID_ARGUMENT if input parameters have any issue
+        VG_LITE_NOT_SUPPORT if font is a raster font
+        VG_LITE_OUT_OF_MEMORY if the glyph table can not be allocated
+     */
+    vg_lite_error_t vg_lite_text_layout(
+                      vg_lite_text_layout_t *layout,
+                      char *text,
+                      vg_lite_font_t font,
+                      vg_lite_font_attributes_t *attributes);
+
+    /*!
+     @abstract Draw text laid out by <code>vg_lite_text_layout</code>.
+
+     @discussion
+     Draws the same pixels as <code>vg_lite_draw_text</code> for a vector
+     font with the attributes used for the layout.
+
+     @param target
+     Pointer to render target
+
+     @param layout
+     Layout filled in by <code>vg_lite_text_layout</code>.
+
+     @param x
+     x position in pixels in X-axis for text rendering
+
+     @param y
+     y position in pixels in Y-axis for text rendering
+
+     @param matrix
+     Translation matrix that is used while rendering text.
+
+     @param blend
+     Specifies how text gets blened in text area.
+
+     @param color
+     Text color.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+        VG_LITE_INVALID_ARGUMENT if the font was unloaded since the layout
+     */
+    vg_lite_error_t vg_lite_draw_text_layout(
+                      vg_lite_buffer_t *target,
+                      vg_lite_text_layout_t *layout,
+                      int x,
+                      int y,
+                      vg_lite_matrix_t *matrix,
+                      vg_lite_blend_t blend,
+                      vg_lite_color_t color);
+
+    /*!
+     @abstract Release the memory of a text layout.
+
+     @param layout
+     Layout filled in by <code>vg_lite_text_layout</code>. It is zero
+     initialized again.
+     */
+    void vg_lite_text_layout_free(vg_lite_text_layout_t *layout);
+
+    /*!
+     @abstract Use a frame arena for the intermediate buffers of raster text.
+
+     @discussion
+     By default <code>vg_lite_draw_text</code> allocates a buffer for every
+     raster text, and waits for the GPU to finish before freeing it. With an
+     arena the buffer comes from the current frame of the arena and the draw
+     returns without waiting.
+
+     @param arena
+     Pointer to an arena initialized by <code>vg_lite_arena_create</code>,
+     or NULL to go back to allocating every buffer.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_text_set_arena(vg_lite_arena_t *arena);
+
+    /*!
+     @abstract Statistics of the vector font glyph cache.
+
+     @discussion
+     Vector text keeps the paths of the glyphs it draws uploaded to GPU
+     memory, keyed by font and character. When all GLYPH_CACHE_SIZE entries
+     are in use the least recently drawn glyph is dropped, after the GPU
+     has finished drawing it. Unregistering a font drops its glyphs.
+     */
+    typedef struct vg_lite_glyph_cache_stats {
+        uint32_t hits;      /*! Glyph draws that found the path in the cache. */
+        uint32_t misses;    /*! Glyph draws that had to create the path. */
+        uint32_t evictions; /*! Glyphs dropped to make room for others. */
+        uint32_t entries;   /*! Glyphs currently cached. */
+        uint32_t capacity;  /*! GLYPH_CACHE_SIZE. */
+    } vg_lite_glyph_cache_stats_t;
+
+    /*!
+     @abstract Query the statistics of the vector font glyph cache.
+
+     @param stats
+     Pointer to the statistics to fill in.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_get_glyph_cache_stats(vg_lite_glyph_cache_stats_t *stats);
+
+    /*!
+     @abstract Free the glyph atlas of raster text.
+
+     @discussion
+     Raster text is drawn from an A8 glyph atlas of VG_TEXT_ATLAS_WIDTH x
+     VG_TEXT_ATLAS_HEIGHT pixels in GPU memory. A glyph is decoded into the
+     atlas the first time it is drawn. When the atlas is full it is emptied
+     after the GPU has finished the commands that use it. The glyphs are
+     drawn with text_color over the target, bg_color is not used.
+     While a command list that raster text was recorded into is alive, the
+     atlas is not emptied: text that does not fit anymore is drawn through a
+     text buffer, as without the atlas. Text recorded into a list while the
+     atlas is full fails with VG_LITE_OUT_OF_RESOURCES. The atlas can not be
+     freed before those command lists, nor while a list is being recorded.
+     The atlas is allocated again by the next raster text.
+
+     @result
+     Returns the status as defined by <code>vg_lite_error_t</code>.
+     */
+    vg_lite_error_t vg_lite_text_free_atlas(void);
+
     /*!
      @abstract This API searches registered font for given name with 
      requested rendering capabilities.
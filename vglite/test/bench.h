@@ -0,0 +1,81 @@
+/****************************************************************************
+*
+*    The MIT License (MIT)
+*
+*    Copyright (c) 2014 - 2020 Vivante Corporation
+*
+*    Permission is hereby granted, free of charge, to any person obtaining a
+*    copy of this software and associated documentation files (the "Software"),
+*    to deal in the Software without restriction, including without limitation
+*    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*    and/or sell copies of the Software, and to permit persons to whom the
+*    Software is furnished to do so, subject to the following conditions:
+*
+*    The above copyright notice and this permission notice shall be included in
+*    all copies or substantial portions of the Software.
+*
+*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+*    DEALINGS IN THE SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * Helpers shared by the host benchmarks (bench_*.c, "make bench").
+ *
+ * The benchmarks time driver code on the host CPU. Absolute numbers depend on
+ * the machine, so compare runs against each other, not against the target.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "vg_lite.h"
+#include "vg_lite_sim.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define BENCH_HEAP_SIZE     (8 << 20)
+
+/* Seconds on a monotonic clock. */
+static inline double bench_now(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* CPU cycles (the x86 time stamp counter), 0 where the host has no cycle counter. */
+static inline uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/* Start the driver on the simulator with a heap of BENCH_HEAP_SIZE bytes. */
+static inline int bench_init(void)
+{
+    static uint8_t heap[BENCH_HEAP_SIZE] __attribute__((aligned(64)));
+
+    vg_lite_init_mem(0, 0, heap, sizeof(heap));
+    if (vg_lite_init(64, 64) != VG_LITE_SUCCESS ||
+        vg_lite_set_command_buffer_size(64 << 10) != VG_LITE_SUCCESS) {
+        printf("FAIL init\n");
+        return -1;
+    }
+    return 0;
+}
+
+#endif /* _BENCH_H_ */
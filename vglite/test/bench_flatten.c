@@ -0,0 +1,95 @@
+/****************************************************************************
+*
+*    The MIT License (MIT)
+*
+*    Copyright (c) 2014 - 2020 Vivante Corporation
+*
+*    Permission is hereby granted, free of charge, to any person obtaining a
+*    copy of this software and associated documentation files (the "Software"),
+*    to deal in the Software without restriction, including without limitation
+*    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*    and/or sell copies of the Software, and to permit persons to whom the
+*    Software is furnished to do so, subject to the following conditions:
+*
+*    The above copyright notice and this permission notice shall be included in
+*    all copies or substantial portions of the Software.
+*
+*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+*    DEALINGS IN THE SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * Stroke generation cost against the draw scale (vg_lite_set_stroke_transform).
+ *
+ * Eight cubics and a quadratic are stroked as if drawn at several scales.
+ * Curves are flattened to the tolerance in target pixels, so the point count
+ * and the update time follow the scale; scale 0 is the path space default.
+ */
+
+#include <string.h>
+#include "bench.h"
+
+#define UPDATES     200
+
+static uint8_t *put_op(float **data, uint8_t op)
+{
+    uint8_t *p = (uint8_t *)*data;
+
+    *p = op;
+    (*data)++;
+    return p;
+}
+
+int main(void)
+{
+    static const float scales[] = { 0, 0.1f, 0.25f, 1, 4, 10 };
+    static float data[80];
+    float *d = data;
+    vg_lite_path_t path;
+    vg_lite_matrix_t matrix;
+    double start, elapsed;
+    uint32_t i, k;
+
+    put_op(&d, VLC_OP_MOVE); *d++ = 10; *d++ = 10;
+    for (i = 0; i < 8; i++) {
+        put_op(&d, VLC_OP_CUBIC);
+        *d++ = 10 + i * 30.0f; *d++ = 200;
+        *d++ = 30 + i * 30.0f; *d++ = -100;
+        *d++ = 40 + i * 30.0f; *d++ = 10 + (i & 1) * 50.0f;
+    }
+    put_op(&d, VLC_OP_QUAD); *d++ = 300; *d++ = 300; *d++ = 20; *d++ = 250;
+    put_op(&d, VLC_OP_END);
+
+    for (k = 0; k < sizeof(scales) / sizeof(scales[0]); k++) {
+        memset(&path, 0, sizeof(path));
+        vg_lite_init_path(&path, VG_LITE_FP32, VG_LITE_HIGH, (uint8_t *)d - (uint8_t *)data, data, 0, 0, 400, 400);
+        path.path_type = VG_LITE_DRAW_STROKE_PATH;
+        vg_lite_set_stroke(&path, VG_LITE_CAP_BUTT, VG_LITE_JOIN_MITER, 2, 4, NULL, 0, 0, 0xFF0000FF);
+        vg_lite_identity(&matrix);
+        vg_lite_scale(scales[k], scales[k], &matrix);
+        vg_lite_set_stroke_transform(&path, scales[k] != 0 ? &matrix : NULL);
+
+        start = bench_now();
+        for (i = 0; i < UPDATES; i++) {
+            /* Regenerate every time instead of hitting the stroke cache. */
+            path.stroke_conversion->stroke_cached = 0;
+            if (vg_lite_update_stroke(&path) != VG_LITE_SUCCESS) {
+                printf("FAIL update\n");
+                return 1;
+            }
+        }
+        elapsed = bench_now() - start;
+
+        printf("scale %5.2f: %4u points, %6d bytes, %6.1f us per update\n", scales[k],
+               path.stroke_conversion->point_count, path.stroke_path_size, elapsed / UPDATES * 1e6);
+        vg_lite_clear_path(&path);
+    }
+
+    return 0;
+}
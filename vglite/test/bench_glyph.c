@@ -0,0 +1,225 @@
+/****************************************************************************
+*
+*    The MIT License (MIT)
+*
+*    Copyright (c) 2014 - 2020 Vivante Corporation
+*
+*    Permission is hereby granted, free of charge, to any person obtaining a
+*    copy of this software and associated documentation files (the "Software"),
+*    to deal in the Software without restriction, including without limitation
+*    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*    and/or sell copies of the Software, and to permit persons to whom the
+*    Software is furnished to do so, subject to the following conditions:
+*
+*    The above copyright notice and this permission notice shall be included in
+*    all copies or substantial portions of the Software.
+*
+*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+*    DEALINGS IN THE SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * Vector font glyph and kerning lookups (vft_find_glyph, vft_glyph_distance).
+ *
+ * A face with 95 ASCII and 20000 CJK glyphs, 8 kerning pairs each, is built
+ * in memory. Random text, 3/4 CJK, is looked up through the index built by
+ * vft_load_from_buffer and through the linear scans it replaces, once with
+ * the glyph table sorted by unicode and once shuffled.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "vg_lite_text.h"
+#include "vft_draw.h"
+
+#define CJK_GLYPHS  20000
+#define GLYPHS      (95 + CJK_GLYPHS)
+#define KERNS       8
+#define CHARS       (1 << 20)
+#define LINEAR      (1 << 12)
+
+/* Keeps the timed lookups from being optimized away. */
+static volatile long sink;
+
+/* Font registry of rle_font_read.c, unused here: faces are loaded directly. */
+font_face_desc_t *_vg_lite_get_vector_font(vg_lite_font_t font)
+{
+    (void)font;
+    return NULL;
+}
+
+struct mf_font_s *_vg_lite_get_raster_font(vg_lite_font_t font)
+{
+    (void)font;
+    return NULL;
+}
+
+int vg_lite_is_font_valid(vg_lite_font_t font)
+{
+    (void)font;
+    return VG_LITE_INVALID_ARGUMENT;
+}
+
+int vg_lite_is_vector_font(vg_lite_font_t font)
+{
+    (void)font;
+    return 0;
+}
+
+vg_lite_error_t vg_lite_load_font_data(vg_lite_font_t font, int font_height)
+{
+    (void)font;
+    (void)font_height;
+    return VG_LITE_INVALID_ARGUMENT;
+}
+
+static glyph_desc_t *linear_find(font_face_desc_t *face, uint16_t unicode)
+{
+    uint32_t i;
+
+    for (i = 0; i < face->num_glyphs; i++) {
+        if (face->glyphs[i].unicode == unicode)
+            return &face->glyphs[i];
+    }
+    return &face->glyphs[0];
+}
+
+static int linear_distance(glyph_desc_t *g1, glyph_desc_t *g2)
+{
+    uint32_t i;
+
+    for (i = 0; i < g1->kern_num_entries; i++) {
+        if (g1->kern_table[i].unicode == g2->unicode)
+            return (int16_t)g1->kern_table[i].kern;
+    }
+    return 0;
+}
+
+/* Font file image in buf, the glyph table in unicode order unless shuffled. */
+static font_face_desc_t *build_face(char *buf, int size, int shuffled)
+{
+    int glyphs_size = GLYPHS * sizeof(glyph_desc_t);
+    int kerns_size = GLYPHS * KERNS * sizeof(kern_desc_t);
+    char *p = buf;
+    font_face_desc_t *face;
+    glyph_desc_t *g;
+    kern_desc_t *k;
+    int i, j, kern_offset;
+
+    memset(buf, 0, size);
+    *(uint32_t *)p = (eFontFaceDesc << 24) | sizeof(font_face_desc_t);
+    p += 4;
+    face = (font_face_desc_t *)p;
+    p += sizeof(font_face_desc_t);
+    face->units_per_em = 1000;
+    face->num_glyphs = GLYPHS;
+    *(uint32_t *)p = (eGlyphTableDesc << 24) | glyphs_size;
+    p += 4;
+    g = (glyph_desc_t *)p;
+    p += glyphs_size;
+    *(uint32_t *)p = (eKernTableDesc << 24) | kerns_size;
+    p += 4;
+    k = (kern_desc_t *)p;
+    kern_offset = p - buf;
+
+    for (i = 0; i < GLYPHS; i++) {
+        g[i].unicode = i < 95 ? 32 + i : 0x4E00 + (shuffled ? (i * 7919) % CJK_GLYPHS : i - 95);
+        g[i].horiz_adv_x = 500;
+        g[i].kern_num_entries = KERNS;
+        g[i].kern_table_offset = kern_offset + i * KERNS * sizeof(kern_desc_t);
+    }
+    for (i = 0; i < GLYPHS; i++) {
+        for (j = 0; j < KERNS; j++) {
+            k[i * KERNS + j].unicode = g[(i * 7 + j * 13) % GLYPHS].unicode;
+            k[i * KERNS + j].kern = (uint16_t)-(j + 1);
+        }
+    }
+
+    return vft_load_from_buffer(buf, size);
+}
+
+/* Glyph pairs, every other one kerned. */
+static void lookup_pairs(font_face_desc_t *face, const uint16_t *text, int count, int indexed, long *sum)
+{
+    glyph_desc_t *g1, *g2;
+    int i;
+
+    for (i = 1; i < count; i++) {
+        g1 = indexed ? vft_find_glyph(face, text[i - 1]) : linear_find(face, text[i - 1]);
+        g2 = indexed ? vft_find_glyph(face, (i & 1) ? g1->kern_table[i % KERNS].unicode : text[i])
+                     : linear_find(face, (i & 1) ? g1->kern_table[i % KERNS].unicode : text[i]);
+        *sum += indexed ? vft_glyph_distance(face, g1, g2) : linear_distance(g1, g2);
+    }
+}
+
+int main(void)
+{
+    int size = 4 + sizeof(font_face_desc_t) + 4 + GLYPHS * sizeof(glyph_desc_t) + 4 +
+               GLYPHS * KERNS * sizeof(kern_desc_t);
+    char *buf = malloc(size);
+    uint16_t *text = malloc(CHARS * sizeof(uint16_t));
+    font_face_desc_t *face;
+    double start, find_time, pair_time;
+    long sum, check;
+    int shuffled, indexed, count, i;
+
+    if (buf == NULL || text == NULL)
+        return 1;
+
+    for (shuffled = 0; shuffled < 2; shuffled++) {
+        face = build_face(buf, size, shuffled);
+        if (face == NULL) {
+            printf("FAIL load\n");
+            return 1;
+        }
+        srand(1);
+        for (i = 0; i < CHARS; i++)
+            text[i] = (rand() % 4) ? 0x4E00 + rand() % CJK_GLYPHS : 32 + rand() % 95;
+
+        /* The index must find the same glyphs and kerning as the scans. */
+        for (i = 0; i < LINEAR; i++) {
+            if (vft_find_glyph(face, text[i]) != linear_find(face, text[i])) {
+                printf("FAIL lookup of %04x\n", text[i]);
+                return 1;
+            }
+        }
+        check = sum = 0;
+        lookup_pairs(face, text, LINEAR, 0, &check);
+        lookup_pairs(face, text, LINEAR, 1, &sum);
+        if (sum != check) {
+            printf("FAIL kerning %ld, expected %ld\n", sum, check);
+            return 1;
+        }
+
+        /* The linear scans are too slow for the whole text. */
+        for (indexed = 0; indexed < 2; indexed++) {
+            count = indexed ? CHARS : LINEAR;
+            sum = 0;
+            start = bench_now();
+            for (i = 0; i < count; i++)
+                sum += (indexed ? vft_find_glyph(face, text[i]) : linear_find(face, text[i]))->unicode;
+            find_time = bench_now() - start;
+            start = bench_now();
+            lookup_pairs(face, text, count, indexed, &sum);
+            pair_time = bench_now() - start;
+
+            sink = sum;
+
+            printf("%-8s %-7s: %6.2f M lookups/s, %6.2f M kerned pairs/s\n",
+                   shuffled ? "shuffled" : "sorted", indexed ? "indexed" : "linear",
+                   count / find_time * 1e-6, (count - 1) / pair_time * 1e-6);
+        }
+        vft_unload(face);
+    }
+
+    free(text);
+    free(buf);
+    return 0;
+}
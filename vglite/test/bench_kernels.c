@@ -0,0 +1,212 @@
+/****************************************************************************
+*
+*    The MIT License (MIT)
+*
+*    Copyright (c) 2014 - 2020 Vivante Corporation
+*
+*    Permission is hereby granted, free of charge, to any person obtaining a
+*    copy of this software and associated documentation files (the "Software"),
+*    to deal in the Software without restriction, including without limitation
+*    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*    and/or sell copies of the Software, and to permit persons to whom the
+*    Software is furnished to do so, subject to the following conditions:
+*
+*    The above copyright notice and this permission notice shall be included in
+*    all copies or substantial portions of the Software.
+*
+*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+*    DEALINGS IN THE SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * Cost per point of the batched kernels: quad_bezier_eval_n and
+ * cubic_bezier_eval_n of the flattener, and vg_lite_transform_points.
+ *
+ * Each kernel runs in batches of FLATTEN_BATCH points, as the flattener calls
+ * it, and in one batch of POINTS. The reference evaluates the same points one
+ * at a time, with de Casteljau for the curves and the full projective divide
+ * for the matrix. The kernels are checked against the reference first.
+ *
+ * The driver file is included to reach its static kernels.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "bench.h"
+#include "../VGLite/vg_lite_flat.c"
+
+#define POINTS      4096
+#define ROUNDS      1000
+#define BEST_OF     15
+
+typedef void (*kernel_t)(int first, int count);
+
+static vg_lite_float_t t[POINTS];
+static vg_lite_float_t in[2 * POINTS];
+static vg_lite_float_t out[2 * POINTS];
+static vg_lite_float_t ref[2 * POINTS];
+
+static const quad_bezier_t quad = { 10, 10, 80, -40, 150, 60 };
+static const cubic_bezier_t cubic = { 10, 10, 40, 90, 120, -30, 160, 50 };
+static vg_lite_matrix_t matrix;
+
+static void quad_ref(int first, int count)
+{
+    vg_lite_float_t ax, ay, bx, by, u;
+    int i;
+
+    for (i = first; i < first + count; i++) {
+        u = t[i];
+        ax = quad.X0 + (quad.X1 - quad.X0) * u;
+        ay = quad.Y0 + (quad.Y1 - quad.Y0) * u;
+        bx = quad.X1 + (quad.X2 - quad.X1) * u;
+        by = quad.Y1 + (quad.Y2 - quad.Y1) * u;
+        out[2 * i] = ax + (bx - ax) * u;
+        out[2 * i + 1] = ay + (by - ay) * u;
+    }
+}
+
+static void cubic_ref(int first, int count)
+{
+    quad_bezier_t q;
+    vg_lite_float_t u;
+    int i;
+
+    for (i = first; i < first + count; i++) {
+        u = t[i];
+        q.X0 = cubic.X0 + (cubic.X1 - cubic.X0) * u;
+        q.Y0 = cubic.Y0 + (cubic.Y1 - cubic.Y0) * u;
+        q.X1 = cubic.X1 + (cubic.X2 - cubic.X1) * u;
+        q.Y1 = cubic.Y1 + (cubic.Y2 - cubic.Y1) * u;
+        q.X2 = cubic.X2 + (cubic.X3 - cubic.X2) * u;
+        q.Y2 = cubic.Y2 + (cubic.Y3 - cubic.Y2) * u;
+        q.X0 += (q.X1 - q.X0) * u;
+        q.Y0 += (q.Y1 - q.Y0) * u;
+        q.X1 += (q.X2 - q.X1) * u;
+        q.Y1 += (q.Y2 - q.Y1) * u;
+        out[2 * i] = q.X0 + (q.X1 - q.X0) * u;
+        out[2 * i + 1] = q.Y0 + (q.Y1 - q.Y0) * u;
+    }
+}
+
+static void transform_ref(int first, int count)
+{
+    vg_lite_float_t x, y, w;
+    int i;
+
+    for (i = first; i < first + count; i++) {
+        x = in[2 * i];
+        y = in[2 * i + 1];
+        w = x * matrix.m[2][0] + y * matrix.m[2][1] + matrix.m[2][2];
+        out[2 * i] = (x * matrix.m[0][0] + y * matrix.m[0][1] + matrix.m[0][2]) / w;
+        out[2 * i + 1] = (x * matrix.m[1][0] + y * matrix.m[1][1] + matrix.m[1][2]) / w;
+    }
+}
+
+static void quad_kernel(int first, int count)
+{
+    quad_bezier_eval_n(&quad, t + first, out + 2 * first, count);
+}
+
+static void cubic_kernel(int first, int count)
+{
+    cubic_bezier_eval_n(&cubic, t + first, out + 2 * first, count);
+}
+
+static void transform_kernel(int first, int count)
+{
+    vg_lite_transform_points(&matrix, in + 2 * first, out + 2 * first, count);
+}
+
+/* Largest difference between the kernel and the reference. */
+static double check(kernel_t kernel, kernel_t reference)
+{
+    double diff = 0;
+    int i;
+
+    reference(0, POINTS);
+    memcpy(ref, out, sizeof(ref));
+    kernel(0, POINTS);
+    for (i = 0; i < 2 * POINTS; i++) {
+        if (fabs(out[i] - ref[i]) > diff)
+            diff = fabs(out[i] - ref[i]);
+    }
+    return diff;
+}
+
+/* Best time of BEST_OF runs of ROUNDS passes over all points, per point. */
+static void run(kernel_t kernel, int batch, double *ns, double *cycles)
+{
+    double start, elapsed;
+    uint64_t c0, c1;
+    int b, r, first;
+
+    *ns = *cycles = 1e30;
+    for (b = 0; b < BEST_OF; b++) {
+        start = bench_now();
+        c0 = bench_cycles();
+        for (r = 0; r < ROUNDS; r++) {
+            for (first = 0; first < POINTS; first += batch)
+                kernel(first, batch);
+        }
+        c1 = bench_cycles();
+        elapsed = bench_now() - start;
+        if (elapsed * 1e9 / ((double)ROUNDS * POINTS) < *ns)
+            *ns = elapsed * 1e9 / ((double)ROUNDS * POINTS);
+        if ((double)(c1 - c0) / ((double)ROUNDS * POINTS) < *cycles)
+            *cycles = (double)(c1 - c0) / ((double)ROUNDS * POINTS);
+    }
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        kernel_t kernel;
+        kernel_t reference;
+        double tolerance;
+    } kernels[] = {
+        { "quad_bezier_eval_n",         quad_kernel,      quad_ref,      1e-3 },
+        { "cubic_bezier_eval_n",        cubic_kernel,     cubic_ref,     1e-3 },
+        { "vg_lite_transform_points",   transform_kernel, transform_ref, 1e-3 },
+    };
+    static const int batches[] = { FLATTEN_BATCH, POINTS };
+    double ns, cycles, ref_ns, ref_cycles, diff;
+    uint32_t k, b;
+    int failed = 0;
+
+    for (k = 0; k < POINTS; k++) {
+        t[k] = (vg_lite_float_t)k / (POINTS - 1);
+        in[2 * k] = (vg_lite_float_t)(k % 64) * 3.5f - 100;
+        in[2 * k + 1] = (vg_lite_float_t)(k / 64) * 2.25f - 50;
+    }
+    vg_lite_identity(&matrix);
+    vg_lite_translate(120, 80, &matrix);
+    vg_lite_rotate(20, &matrix);
+    vg_lite_scale(1.5f, 0.75f, &matrix);
+
+    printf("%-26s %6s %12s %12s %12s %12s\n", "kernel", "batch", "ns/point", "cycles/pt", "ref ns/pt", "ref cyc/pt");
+    for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        diff = check(kernels[k].kernel, kernels[k].reference);
+        if (diff > kernels[k].tolerance) {
+            printf("FAIL %s differs from the reference by %g\n", kernels[k].name, diff);
+            failed = 1;
+            continue;
+        }
+        for (b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+            run(kernels[k].kernel, batches[b], &ns, &cycles);
+            run(kernels[k].reference, batches[b], &ref_ns, &ref_cycles);
+            printf("%-26s %6d %12.2f %12.2f %12.2f %12.2f\n", kernels[k].name, batches[b],
+                   ns, cycles, ref_ns, ref_cycles);
+        }
+    }
+    if (bench_cycles() == 0)
+        printf("No cycle counter on this host, the cycle columns are 0.\n");
+    return failed;
+}
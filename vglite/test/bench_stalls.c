@@ -0,0 +1,126 @@
+/****************************************************************************
+*
+*    The MIT License (MIT)
+*
+*    Copyright (c) 2014 - 2020 Vivante Corporation
+*
+*    Permission is hereby granted, free of charge, to any person obtaining a
+*    copy of this software and associated documentation files (the "Software"),
+*    to deal in the Software without restriction, including without limitation
+*    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*    and/or sell copies of the Software, and to permit persons to whom the
+*    Software is furnished to do so, subject to the following conditions:
+*
+*    The above copyright notice and this permission notice shall be included in
+*    all copies or substantial portions of the Software.
+*
+*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+*    DEALINGS IN THE SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * Pipeline stalls per frame on the simulator, for vg_lite_draw and vg_lite_draw_paths.
+ *
+ * Small icons are drawn on a 256x256 target with 64x64 tessellation tiles:
+ * a disjoint grid, the same grid in one color, and random positions. Each
+ * scene is drawn with stall elision off and on (vg_lite_set_stall_elision).
+ */
+
+#include <string.h>
+#include "bench.h"
+
+#define ICONS       144
+#define FRAMES      4
+
+static int8_t icon_data[] = {
+    VLC_OP_MOVE, -5, -10, VLC_OP_LINE, 5, -10, VLC_OP_LINE, 10, -5, VLC_OP_LINE, 0, 0,
+    VLC_OP_LINE, 10, 5, VLC_OP_LINE, 5, 10, VLC_OP_LINE, -5, 10, VLC_OP_LINE, -10, 5,
+    VLC_OP_LINE, -10, -5, VLC_OP_END,
+};
+
+int main(void)
+{
+    static const char *scenes[] = { "grid", "one color", "random" };
+    static vg_lite_matrix_t matrices[ICONS];
+    static vg_lite_draw_item_t items[ICONS];
+    vg_lite_buffer_t target;
+    vg_lite_path_t icon;
+    vg_lite_sim_stats_t stats;
+    vg_lite_error_t error = VG_LITE_SUCCESS;
+    uint32_t seed, scene, batched, elision, frame, i;
+    uint32_t stalls[2], tessellations[2], commands[2];
+
+    if (bench_init() != 0)
+        return 1;
+    memset(&target, 0, sizeof(target));
+    target.width = 256;
+    target.height = 256;
+    target.format = VG_LITE_BGRA8888;
+    memset(&icon, 0, sizeof(icon));
+    if (vg_lite_allocate(&target) != VG_LITE_SUCCESS ||
+        vg_lite_init_path(&icon, VG_LITE_S8, VG_LITE_HIGH, sizeof(icon_data), icon_data, -10, -10, 10, 10) != VG_LITE_SUCCESS) {
+        printf("FAIL setup\n");
+        return 1;
+    }
+
+    for (scene = 0; scene < 3; scene++) {
+        seed = 7;
+        for (i = 0; i < ICONS; i++) {
+            vg_lite_identity(&matrices[i]);
+            if (scene < 2) {
+                vg_lite_translate(12 + (i % 12) * 21.0f, 12 + (i / 12) * 21.0f, &matrices[i]);
+            }
+            else {
+                seed = seed * 1103515245 + 12345;
+                vg_lite_translate((seed >> 8) % 256, (seed >> 18) % 256, &matrices[i]);
+            }
+            vg_lite_scale(0.9f, 0.9f, &matrices[i]);
+            items[i].path = &icon;
+            items[i].matrix = &matrices[i];
+            items[i].fill_rule = VG_LITE_FILL_EVEN_ODD;
+            items[i].color = scene == 1 ? 0xFF3060C0 : 0xFF000000 | (i * 0x10101 * 37);
+        }
+
+        for (batched = 0; batched < 2; batched++) {
+            for (elision = 0; elision < 2; elision++) {
+                error |= vg_lite_set_stall_elision(elision);
+                vg_lite_finish();
+                vg_lite_sim_get_stats(&stats, 1);
+                for (frame = 0; frame < FRAMES; frame++) {
+                    error |= vg_lite_clear(&target, NULL, 0xFF202020);
+                    if (batched) {
+                        error |= vg_lite_draw_paths(&target, items, ICONS, VG_LITE_BLEND_SRC_OVER);
+                    }
+                    else {
+                        for (i = 0; i < ICONS; i++)
+                            error |= vg_lite_draw(&target, &icon, items[i].fill_rule, items[i].matrix,
+                                                  VG_LITE_BLEND_SRC_OVER, items[i].color);
+                    }
+                    error |= vg_lite_finish();
+                }
+                vg_lite_sim_get_stats(&stats, 1);
+                stalls[elision] = stats.stalls / FRAMES;
+                tessellations[elision] = stats.paths / FRAMES;
+                commands[elision] = stats.commands / FRAMES;
+            }
+            if (error != VG_LITE_SUCCESS) {
+                printf("FAIL draw %d\n", error);
+                return 1;
+            }
+            printf("%-9s %-18s: %4u -> %4u stalls, %4u -> %4u tessellations, %5u -> %5u commands per frame\n",
+                   scenes[scene], batched ? "vg_lite_draw_paths" : "vg_lite_draw", stalls[0], stalls[1],
+                   tessellations[0], tessellations[1], commands[0], commands[1]);
+        }
+    }
+
+    vg_lite_clear_path(&icon);
+    vg_lite_free(&target);
+    vg_lite_close();
+    return 0;
+}
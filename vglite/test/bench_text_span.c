@@ -0,0 +1,173 @@
+/****************************************************************************
+*
+*    The MIT License (MIT)
+*
+*    Copyright (c) 2014 - 2020 Vivante Corporation
+*
+*    Permission is hereby granted, free of charge, to any person obtaining a
+*    copy of this software and associated documentation files (the "Software"),
+*    to deal in the Software without restriction, including without limitation
+*    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*    and/or sell copies of the Software, and to permit persons to whom the
+*    Software is furnished to do so, subject to the following conditions:
+*
+*    The above copyright notice and this permission notice shall be included in
+*    all copies or substantial portions of the Software.
+*
+*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+*    DEALINGS IN THE SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * Raster text glyph runs written into the text buffer (span_callback).
+ *
+ * A synthetic raster font hands over the runs of each glyph row the way the
+ * mcufont decoder does: a faint pixel, an opaque run and another faint pixel.
+ * Small glyphs have runs of 2-7 pixels, large ones of 16-23. Every glyph is
+ * written into a 640x24 buffer, A8 and ARGB8888, and for reference with the
+ * per-pixel store the span writer replaced.
+ *
+ * The driver file is included to reach its static callbacks.
+ */
+
+#include <stdlib.h>
+#include "bench.h"
+#include "../font/vg_lite_text.c"
+
+#define BUFFER_WIDTH    640
+#define BUFFER_HEIGHT   24
+#define GLYPHS          20000
+#define BEST_OF         100
+
+static uint8_t bench_character_width(const struct mf_font_s *font, mf_char character)
+{
+    (void)character;
+    return font->width - 2;
+}
+
+static uint8_t bench_render_character(const struct mf_font_s *font, int16_t x0, int16_t y0, mf_char character,
+                                      mf_pixel_callback_t callback, void *state)
+{
+    int large = font->width > 16;
+    int r;
+
+    for (r = 3; r < font->height - 2; r++) {
+        callback(x0 + 1 + (character + r) % 3, y0 + r, 1, 0x40, state);
+        callback(x0 + 2 + (character + r) % 3, y0 + r,
+                 large ? 16 + (character * r) % 8 : 2 + (character * r) % 6, 0xFF, state);
+        callback(x0 + (large ? 28 : 10) + (character + r) % 3, y0 + r, 1, 0x80, state);
+    }
+    return font->width - 2;
+}
+
+static struct mf_font_s bench_font = {
+    "bench", "bench", 16, 20, 8, 14, 0, 16, 20, 0, '?', bench_character_width, bench_render_character
+};
+
+/* The store of each pixel of a run that span_callback replaced. */
+static void pixel_store_callback(int16_t x, int16_t y, uint8_t count, uint8_t alpha, void *state)
+{
+    text_span_t *span = (text_span_t*)state;
+
+    if (y < 0 || y >= span->height) return;
+    if (x < 0 || x + count >= span->width) return;
+
+    while (count--) {
+        ((uint32_t *)(span->memory + y * span->stride))[x] = g_index_table[alpha];
+        x++;
+    }
+}
+
+static uint8_t pixel_store_character(int16_t x, int16_t y, mf_char character, void *state)
+{
+    text_context_t *s = (text_context_t*)state;
+    return mf_render_character(s->rcd_font, x, y, character, pixel_store_callback, &s->span);
+}
+
+/* Font registry of rle_font_read.c, the benchmark font is the only one. */
+font_face_desc_t *_vg_lite_get_vector_font(vg_lite_font_t font)
+{
+    (void)font;
+    return NULL;
+}
+
+struct mf_font_s *_vg_lite_get_raster_font(vg_lite_font_t font)
+{
+    (void)font;
+    return &bench_font;
+}
+
+int vg_lite_is_font_valid(vg_lite_font_t font)
+{
+    (void)font;
+    return VG_LITE_SUCCESS;
+}
+
+int vg_lite_is_vector_font(vg_lite_font_t font)
+{
+    (void)font;
+    return 0;
+}
+
+vg_lite_error_t vg_lite_load_font_data(vg_lite_font_t font, int font_height)
+{
+    (void)font;
+    (void)font_height;
+    return VG_LITE_SUCCESS;
+}
+
+/* Rate in M glyphs/s of writing GLYPHS glyphs along the buffer. */
+static double run(text_context_t *ctx, mf_character_callback_t character)
+{
+    double start;
+    int i;
+
+    start = bench_now();
+    for (i = 0; i < GLYPHS; i++)
+        character((i * 14) % (BUFFER_WIDTH - bench_font.width), 1, 'A' + i % 26, ctx);
+    return GLYPHS / (bench_now() - start) * 1e-6;
+}
+
+int main(void)
+{
+    static const char *names[] = { "per pixel", "ARGB8888", "A8" };
+    static uint32_t pixels[BUFFER_WIDTH * BUFFER_HEIGHT];
+    text_context_t ctx;
+    double rate, best[3];
+    int large, k, mode;
+
+    init_256pallet_color_table(0xFF203040, 0xFF30E0FF);
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.rcd_font = &bench_font;
+    ctx.span.memory = (uint8_t *)pixels;
+    ctx.span.width = BUFFER_WIDTH;
+    ctx.span.height = BUFFER_HEIGHT;
+
+    for (large = 0; large < 2; large++) {
+        bench_font.width = large ? 34 : 16;
+        bench_font.height = large ? 22 : 20;
+
+        /* Short rounds alternate the writers so they see the same machine load, the best round counts. */
+        memset(best, 0, sizeof(best));
+        for (k = 0; k < BEST_OF; k++) {
+            for (mode = 0; mode < 3; mode++) {
+                ctx.span.bytes_per_pixel = mode == 2 ? 1 : 4;
+                ctx.span.stride = BUFFER_WIDTH * ctx.span.bytes_per_pixel;
+                rate = run(&ctx, mode == 0 ? pixel_store_character : character_callback);
+                if (rate > best[mode])
+                    best[mode] = rate;
+            }
+        }
+
+        printf("%s glyphs:", large ? "large" : "small");
+        for (mode = 0; mode < 3; mode++)
+            printf(" %s %5.2f%s", names[mode], best[mode], mode < 2 ? "," : " M glyphs/s\n");
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+/* Host stand-in for the FreeRTOS kernel header, see vg_lite_os_host.c. */
+#ifndef _host_freertos_h_
+#define _host_freertos_h_
+
+#include <stdlib.h>
+
+#define pvPortMalloc    malloc
+#define vPortFree       free
+
+#endif /* _host_freertos_h_ */
@@ -0,0 +1 @@
+/* Host stand-in, the host OS layer does not use FreeRTOS objects. */
@@ -0,0 +1,227 @@
+/****************************************************************************
+*
+*    The MIT License (MIT)
+*
+*    Copyright (c) 2014 - 2020 Vivante Corporation
+*
+*    Permission is hereby granted, free of charge, to any person obtaining a
+*    copy of this software and associated documentation files (the "Software"),
+*    to deal in the Software without restriction, including without limitation
+*    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*    and/or sell copies of the Software, and to permit persons to whom the
+*    Software is furnished to do so, subject to the following conditions:
+*
+*    The above copyright notice and this permission notice shall be included in
+*    all copies or substantial portions of the Software.
+*
+*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+*    DEALINGS IN THE SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * Host replacement for rtos/vg_lite_os.c, used with VG_LITE_SIM=1.
+ *
+ * There is no scheduler: submitted command buffers wait in a FIFO, like the
+ * FreeRTOS command queue, and are handed to the simulator when a caller
+ * waits for one of them. That keeps several buffers in flight, so the ring
+ * and fence logic see the same ordering as on the target.
+ */
+
+#include <stdlib.h>
+#include "vg_lite_os.h"
+#include "vg_lite_hw.h"
+#include "vg_lite_hal.h"
+
+#define HOST_QUEUE_LENGTH   16
+
+typedef struct host_queue {
+    uint32_t                    cmd_physical;
+    uint32_t                    cmd_size;
+    vg_lite_os_async_event_t    *event;
+}
+host_queue_t;
+
+static void *               tls;
+static volatile uint32_t    int_flags;
+static volatile int32_t     int_pending;
+static host_queue_t         queue[HOST_QUEUE_LENGTH];
+static int32_t              queue_head, queue_tail;
+
+/* Largest number of command buffers queued at once, for the ring tests. */
+int32_t vg_lite_os_host_max_queued;
+
+static void host_run_one(void)
+{
+    host_queue_t *q = &queue[queue_head];
+    uint32_t even_got = 0;
+
+    q->event->start_time = vg_lite_os_timestamp();
+    vg_lite_hal_poke(VG_LITE_HW_CMDBUF_ADDRESS, q->cmd_physical);
+    vg_lite_hal_poke(VG_LITE_HW_CMDBUF_SIZE, (q->cmd_size + 7) / 8);
+    if (vg_lite_hal_wait_interrupt(0, (uint32_t)~0, &even_got))
+        q->event->signal = VG_LITE_HW_FINISHED;
+    else
+        q->event->signal = VG_LITE_IDLE;
+    q->event->end_time = vg_lite_os_timestamp();
+    queue_head = (queue_head + 1) % HOST_QUEUE_LENGTH;
+}
+
+uint32_t vg_lite_os_timestamp(void)
+{
+    return 0;
+}
+
+int32_t vg_lite_os_set_tls(void* tls_value)
+{
+    tls = tls_value;
+    return VG_LITE_SUCCESS;
+}
+
+void * vg_lite_os_get_tls( )
+{
+    return tls;
+}
+
+void vg_lite_os_reset_tls()
+{
+    tls = NULL;
+}
+
+void * vg_lite_os_malloc(uint32_t size)
+{
+    return malloc(size);
+}
+
+void vg_lite_os_free(void * memory)
+{
+    free(memory);
+}
+
+void vg_lite_os_sleep(uint32_t msec)
+{
+    (void)msec;
+}
+
+int32_t vg_lite_os_initialize(void)
+{
+    queue_head = queue_tail = 0;
+    int_pending = 0;
+    int_flags = 0;
+    return VG_LITE_SUCCESS;
+}
+
+void vg_lite_os_deinitialize(void)
+{
+}
+
+int32_t vg_lite_os_lock()
+{
+    return VG_LITE_SUCCESS;
+}
+
+int32_t vg_lite_os_unlock()
+{
+    return VG_LITE_SUCCESS;
+}
+
+int32_t vg_lite_os_submit(uint32_t context, uint32_t physical, uint32_t offset, uint32_t size, vg_lite_os_async_event_t *event)
+{
+    int32_t queued;
+
+    (void)context;
+    /* A full FIFO drains its oldest entry, as the command queue task would. */
+    if ((queue_tail + 1) % HOST_QUEUE_LENGTH == queue_head)
+        host_run_one();
+
+    event->signal = VG_LITE_IN_QUEUE;
+    queue[queue_tail].cmd_physical = physical + offset;
+    queue[queue_tail].cmd_size = size;
+    queue[queue_tail].event = event;
+    queue_tail = (queue_tail + 1) % HOST_QUEUE_LENGTH;
+
+    queued = (queue_tail - queue_head + HOST_QUEUE_LENGTH) % HOST_QUEUE_LENGTH;
+    if (queued > vg_lite_os_host_max_queued)
+        vg_lite_os_host_max_queued = queued;
+
+    return VG_LITE_SUCCESS;
+}
+
+int32_t vg_lite_os_wait(uint32_t timeout, vg_lite_os_async_event_t *event)
+{
+    (void)timeout;
+    while (event->signal == VG_LITE_IN_QUEUE && queue_head != queue_tail)
+        host_run_one();
+
+    if (event->signal == VG_LITE_HW_FINISHED)
+        return VG_LITE_SUCCESS;
+
+    return VG_LITE_TIMEOUT;
+}
+
+void vg_lite_os_IRQHandler(void)
+{
+    vg_lite_os_signal_interrupt();
+}
+
+void vg_lite_os_signal_interrupt(void)
+{
+    uint32_t flags = vg_lite_hal_peek(VG_LITE_INTR_STATUS);
+
+    if (flags) {
+        int_flags |= flags;
+        int_pending = 1;
+    }
+}
+
+int32_t vg_lite_os_wait_interrupt(uint32_t timeout, uint32_t mask, uint32_t * value)
+{
+    (void)timeout;
+    if (!int_pending)
+        return 0;
+
+    int_pending = 0;
+    if (value != NULL)
+        *value = int_flags & mask;
+    int_flags = 0;
+
+    return 1;
+}
+
+int32_t vg_lite_os_init_event(vg_lite_os_async_event_t *event,
+                                      uint32_t semaphore_id,
+                                      int32_t state)
+{
+    event->semaphore_id = semaphore_id;
+    event->signal = state;
+    return VG_LITE_SUCCESS;
+}
+
+int32_t vg_lite_os_delete_event(vg_lite_os_async_event_t *event)
+{
+    (void)event;
+    return VG_LITE_SUCCESS;
+}
+
+int32_t vg_lite_os_wait_event(vg_lite_os_async_event_t *event)
+{
+    (void)event;
+    return VG_LITE_SUCCESS;
+}
+
+int32_t vg_lite_os_signal_event(vg_lite_os_async_event_t *event)
+{
+    (void)event;
+    return VG_LITE_SUCCESS;
+}
+
+int8_t vg_lite_os_query_context_switch(uint32_t context)
+{
+    (void)context;
+    return 0;
+}
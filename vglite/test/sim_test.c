@@ -0,0 +1,1002 @@
+/****************************************************************************
+*
+*    The MIT License (MIT)
+*
+*    Copyright (c) 2014 - 2020 Vivante Corporation
+*
+*    Permission is hereby granted, free of charge, to any person obtaining a
+*    copy of this software and associated documentation files (the "Software"),
+*    to deal in the Software without restriction, including without limitation
+*    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*    and/or sell copies of the Software, and to permit persons to whom the
+*    Software is furnished to do so, subject to the following conditions:
+*
+*    The above copyright notice and this permission notice shall be included in
+*    all copies or substantial portions of the Software.
+*
+*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+*    DEALINGS IN THE SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * Golden image test of the driver on the GPU simulator.
+ *
+ * Every scene renders into its own target, which is compared byte for byte
+ * with golden/<scene>.pam. Scenes that draw the same picture through a
+ * different driver path (uploaded paths, command lists, arenas, batched
+ * draws) share one golden image. Run with -u to rewrite the golden images.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vg_lite.h"
+#include "vg_lite_text.h"
+#include "vg_lite_sim.h"
+#include "vft_draw.h"
+#include "mcufont.h"
+
+#define HEAP_SIZE       (8 << 20)
+#define GOLDEN_DIR      "golden/"
+
+typedef vg_lite_error_t (*scene_func_t)(vg_lite_buffer_t *target);
+
+typedef struct scene {
+    const char      *name;      /* Scene name, also the test case name. */
+    const char      *golden;    /* Golden image it must match. */
+    int32_t         width;
+    int32_t         height;
+    scene_func_t    draw;
+} scene_t;
+
+static int8_t star_data[] = {
+    2, -5, -10, 4, 5, -10, 4, 10, -5, 4, 0, 0, 4, 10, 5, 4, 5, 10, 4, -5, 10, 4, -10, 5, 4, -10, -5, 0,
+};
+
+static vg_lite_path_t star;
+static vg_lite_buffer_t checker;
+static int update_golden;
+
+static void star_matrix(vg_lite_matrix_t *matrix)
+{
+    vg_lite_identity(matrix);
+    vg_lite_translate(32, 32, matrix);
+    vg_lite_rotate(30, matrix);
+    vg_lite_scale(2.5f, 2.5f, matrix);
+}
+
+static void checker_matrix(vg_lite_matrix_t *matrix)
+{
+    vg_lite_identity(matrix);
+    vg_lite_translate(2, 2, matrix);
+}
+
+static vg_lite_error_t draw_star_and_checker(vg_lite_buffer_t *target, vg_lite_path_t *path, vg_lite_buffer_t *image)
+{
+    vg_lite_error_t error;
+    vg_lite_matrix_t matrix;
+
+    error = vg_lite_clear(target, NULL, 0xFF0000FF);
+    star_matrix(&matrix);
+    error |= vg_lite_draw(target, path, VG_LITE_FILL_EVEN_ODD, &matrix, VG_LITE_BLEND_NONE, 0xFFFF0000);
+    checker_matrix(&matrix);
+    error |= vg_lite_blit(target, image, &matrix, VG_LITE_BLEND_SRC_OVER, 0, VG_LITE_FILTER_POINT);
+    return error;
+}
+
+/* Immediate mode draw, clear and blit. */
+static vg_lite_error_t scene_basic(vg_lite_buffer_t *target)
+{
+    return draw_star_and_checker(target, &star, &checker);
+}
+
+/* The same with the path uploaded to GPU memory. */
+static vg_lite_error_t scene_uploaded(vg_lite_buffer_t *target)
+{
+    vg_lite_path_t path = star;
+    vg_lite_error_t error;
+
+    memset(&path.uploaded, 0, sizeof(path.uploaded));
+    error = vg_lite_upload_path(&path);
+    error |= draw_star_and_checker(target, &path, &checker);
+    error |= vg_lite_finish();
+    error |= vg_lite_clear_path(&path);
+    return error;
+}
+
+/* The same with the uploaded path optimized afterwards, which drops the upload. */
+static vg_lite_error_t scene_optimized(vg_lite_buffer_t *target)
+{
+    int8_t data[sizeof(star_data)];
+    vg_lite_path_t path = star;
+    vg_lite_error_t error;
+
+    memcpy(data, star_data, sizeof(data));
+    path.path = data;
+    memset(&path.uploaded, 0, sizeof(path.uploaded));
+    error = vg_lite_upload_path(&path);
+    error |= vg_lite_optimize_path(&path);
+    if (VLM_PATH_GET_UPLOAD_BIT(path) || path.uploaded.handle != NULL)
+        error |= VG_LITE_GENERIC_IO;
+    error |= draw_star_and_checker(target, &path, &checker);
+    error |= vg_lite_finish();
+    error |= vg_lite_clear_path(&path);
+    return error;
+}
+
+/* Recorded with other colors and matrices, patched and replayed three times. */
+static vg_lite_error_t scene_command_list(vg_lite_buffer_t *target)
+{
+    vg_lite_command_list_t list;
+    vg_lite_matrix_t matrix, identity;
+    vg_lite_error_t error;
+    int i;
+
+    error = vg_lite_begin_command_list(&list, 4096);
+    if (error != VG_LITE_SUCCESS)
+        return error;
+
+    vg_lite_identity(&identity);
+    error |= vg_lite_clear(target, NULL, 0xFF00FF00);
+    error |= vg_lite_draw(target, &star, VG_LITE_FILL_EVEN_ODD, &identity, VG_LITE_BLEND_NONE, 0xFF00FF00);
+    checker_matrix(&matrix);
+    error |= vg_lite_blit(target, &checker, &matrix, VG_LITE_BLEND_SRC_OVER, 0, VG_LITE_FILTER_POINT);
+    /* Finishing is not allowed while recording. */
+    if (vg_lite_finish() == VG_LITE_SUCCESS)
+        error |= VG_LITE_GENERIC_IO;
+    error |= vg_lite_end_command_list(&list);
+
+    star_matrix(&matrix);
+    error |= vg_lite_command_list_set_matrix(&list, 1, &matrix);
+    error |= vg_lite_command_list_set_color(&list, 0, 0xFF0000FF);
+    error |= vg_lite_command_list_set_color(&list, 1, 0xFFFF0000);
+    for (i = 0; i < 3; i++)
+        error |= vg_lite_call_command_list(&list);
+    error |= vg_lite_finish();
+    error |= vg_lite_free_command_list(&list);
+    return error;
+}
+
+/* Paths and images placed in a per-frame arena, over several frames. */
+static vg_lite_error_t scene_arena(vg_lite_buffer_t *target)
+{
+    vg_lite_arena_t arena;
+    vg_lite_buffer_t image;
+    vg_lite_path_t path;
+    vg_lite_error_t error;
+    int frame;
+
+    error = vg_lite_arena_create(&arena, 16 << 10);
+    if (error != VG_LITE_SUCCESS)
+        return error;
+
+    for (frame = 0; frame < 5; frame++) {
+        memset(&image, 0, sizeof(image));
+        image.width = checker.width;
+        image.height = checker.height;
+        image.format = checker.format;
+        error |= vg_lite_arena_allocate_buffer(&arena, &image);
+        if (error != VG_LITE_SUCCESS)
+            break;
+        memcpy(image.memory, checker.memory, checker.stride * checker.height);
+
+        path = star;
+        memset(&path.uploaded, 0, sizeof(path.uploaded));
+        error |= vg_lite_arena_upload_path(&arena, &path);
+        error |= draw_star_and_checker(target, &path, &image);
+        error |= vg_lite_flush();
+        error |= vg_lite_arena_reset(&arena);
+        /* The upload went away with the frame. */
+        if (VLM_PATH_GET_UPLOAD_BIT(path) || path.uploaded.memory != NULL)
+            error |= VG_LITE_GENERIC_IO;
+    }
+    if (vg_lite_arena_upload_path(&arena, NULL) == VG_LITE_SUCCESS)
+        error |= VG_LITE_GENERIC_IO;
+    error |= vg_lite_finish();
+    error |= vg_lite_arena_destroy(&arena);
+    return error;
+}
+
+/* Small clears through a ring of small command buffers. */
+static vg_lite_error_t scene_ring(vg_lite_buffer_t *target)
+{
+    vg_lite_rectangle_t rect = { 0, 0, 8, 8 };
+    vg_lite_error_t error;
+    int i;
+
+    error = vg_lite_set_command_buffer_size(1024);
+    for (i = 0; i < 200; i++) {
+        rect.x = i % 56;
+        rect.y = (i / 56) * 8;
+        error |= vg_lite_clear(target, &rect, 0xFF000000 | (i * 0x10307));
+        if (i % 50 == 49)
+            error |= vg_lite_flush();
+    }
+    error |= vg_lite_finish();
+    error |= vg_lite_set_command_buffer_size(64 << 10);
+    return error;
+}
+
+static uint8_t *put_op(float **data, uint8_t op)
+{
+    uint8_t *cmd = (uint8_t *)*data;
+
+    *cmd = op;
+    (*data)++;
+    return cmd;
+}
+
+/* A round capped cubic stroke. */
+static vg_lite_error_t init_stroke_path(vg_lite_path_t *path, vg_lite_color_t color)
+{
+    static float data[16];
+    float *d = data;
+    vg_lite_error_t error;
+
+    put_op(&d, VLC_OP_MOVE); *d++ = 4; *d++ = 4;
+    put_op(&d, VLC_OP_CUBIC); *d++ = 60; *d++ = 0; *d++ = 0; *d++ = 60; *d++ = 60; *d++ = 60;
+    put_op(&d, VLC_OP_END);
+
+    memset(path, 0, sizeof(*path));
+    error = vg_lite_init_path(path, VG_LITE_FP32, VG_LITE_HIGH, (uint8_t *)d - (uint8_t *)data, data, 0, 0, 64, 64);
+    path->path_type = VG_LITE_DRAW_STROKE_PATH;
+    error |= vg_lite_set_stroke(path, VG_LITE_CAP_ROUND, VG_LITE_JOIN_ROUND, 3, 4, NULL, 0, 0, color);
+    error |= vg_lite_update_stroke(path);
+    return error;
+}
+
+/* The stroke drawn twice, the second time from the stroke cache. */
+static vg_lite_error_t scene_stroke(vg_lite_buffer_t *target)
+{
+    static float copy[16];
+    vg_lite_path_t path;
+    vg_lite_matrix_t matrix;
+    vg_lite_error_t error;
+    uint32_t misses;
+    int i;
+
+    error = init_stroke_path(&path, 0xFF00FFFF);
+    vg_lite_identity(&matrix);
+    for (i = 0; i < 2; i++) {
+        error |= vg_lite_update_stroke(&path);
+        error |= vg_lite_clear(target, NULL, 0xFF000000);
+        error |= vg_lite_draw(target, &path, VG_LITE_FILL_NON_ZERO, &matrix, VG_LITE_BLEND_NONE, 0);
+        error |= vg_lite_finish();
+    }
+    if (path.stroke_conversion->stroke_cache_hits != 2)
+        error |= VG_LITE_GENERIC_IO;
+
+    /* The same data at another address is not the cached path. */
+    memcpy(copy, path.path, path.path_length);
+    path.path = copy;
+    misses = path.stroke_conversion->stroke_cache_misses;
+    error |= vg_lite_update_stroke(&path);
+    if (path.stroke_conversion->stroke_cache_misses != misses + 1)
+        error |= VG_LITE_GENERIC_IO;
+    /* The points and sub paths are not kept once the stroke is built. */
+    if (path.stroke_conversion->block_list && path.stroke_conversion->block_list->next)
+        error |= VG_LITE_GENERIC_IO;
+    error |= vg_lite_clear_path(&path);
+    return error;
+}
+
+/* The stroke recorded in another color and patched. */
+static vg_lite_error_t scene_stroke_list(vg_lite_buffer_t *target)
+{
+    vg_lite_command_list_t list;
+    vg_lite_path_t path;
+    vg_lite_matrix_t matrix;
+    vg_lite_error_t error;
+
+    error = init_stroke_path(&path, 0xFF0000FF);
+    error |= vg_lite_begin_command_list(&list, 4096);
+    if (error != VG_LITE_SUCCESS)
+        return error;
+
+    vg_lite_identity(&matrix);
+    error |= vg_lite_clear(target, NULL, 0xFF000000);
+    error |= vg_lite_draw(target, &path, VG_LITE_FILL_NON_ZERO, &matrix, VG_LITE_BLEND_NONE, 0);
+    error |= vg_lite_end_command_list(&list);
+
+    /* A clear has no stroke. */
+    if (vg_lite_command_list_set_stroke_color(&list, 0, 0xFF00FFFF) == VG_LITE_SUCCESS)
+        error |= VG_LITE_GENERIC_IO;
+    error |= vg_lite_command_list_set_stroke_color(&list, 1, 0xFF00FFFF);
+    error |= vg_lite_call_command_list(&list);
+    error |= vg_lite_finish();
+    error |= vg_lite_free_command_list(&list);
+    error |= vg_lite_clear_path(&path);
+    return error;
+}
+
+#define ICON_COUNT  200
+
+static vg_lite_matrix_t icon_matrices[ICON_COUNT];
+static vg_lite_draw_item_t icons[ICON_COUNT];
+
+static void icon_scene(void)
+{
+    uint32_t seed = 7;
+    int i;
+
+    for (i = 0; i < ICON_COUNT; i++) {
+        seed = seed * 1103515245 + 12345;
+        vg_lite_identity(&icon_matrices[i]);
+        vg_lite_translate((float)((seed >> 8) % 256), (float)((seed >> 18) % 256), &icon_matrices[i]);
+        vg_lite_scale(0.8f, 0.8f, &icon_matrices[i]);
+        icons[i].path = &star;
+        icons[i].matrix = &icon_matrices[i];
+        icons[i].fill_rule = VG_LITE_FILL_EVEN_ODD;
+        icons[i].color = 0xFF000000u | (i * 0x10101u * 37);
+    }
+}
+
+/* Overlapping paths larger than the tessellation buffer, one draw at a time. */
+static vg_lite_error_t scene_icons(vg_lite_buffer_t *target)
+{
+    vg_lite_error_t error;
+    int i;
+
+    icon_scene();
+    error = vg_lite_clear(target, NULL, 0xFF202020);
+    for (i = 0; i < ICON_COUNT; i++)
+        error |= vg_lite_draw(target, icons[i].path, icons[i].fill_rule, icons[i].matrix,
+                              VG_LITE_BLEND_SRC_OVER, icons[i].color);
+    return error;
+}
+
+/* The same paths binned by vg_lite_draw_paths. */
+static vg_lite_error_t scene_icons_batched(vg_lite_buffer_t *target)
+{
+    vg_lite_error_t error;
+
+    icon_scene();
+    error = vg_lite_clear(target, NULL, 0xFF202020);
+    error |= vg_lite_draw_paths(target, icons, ICON_COUNT, VG_LITE_BLEND_SRC_OVER);
+    return error;
+}
+
+/*
+ * Fonts for the text scenes. Font 0 and 1 are vector fonts of rectangular
+ * glyphs with kerning, font 2 is a raster font of antialiased bars.
+ */
+#define TEXT_GLYPHS 96
+
+static font_face_desc_t text_faces[2];
+static glyph_desc_t text_glyphs[2][TEXT_GLYPHS];
+static uint32_t text_cmds[TEXT_GLYPHS][16];
+static kern_desc_t text_kern[TEXT_GLYPHS][3];
+
+static void put_float(uint32_t *word, float value)
+{
+    memcpy(word, &value, sizeof(value));
+}
+
+static void text_init_vector_fonts(void)
+{
+    int i, f;
+
+    for (i = 0; i < TEXT_GLYPHS; i++) {
+        uint32_t *c = text_cmds[i];
+        float w = 100.0f + i * 3;
+
+        c[0] = VLC_OP_MOVE; put_float(&c[1], 0); put_float(&c[2], 0);
+        c[3] = VLC_OP_LINE; put_float(&c[4], w); put_float(&c[5], 0);
+        c[6] = VLC_OP_LINE; put_float(&c[7], w); put_float(&c[8], 600);
+        c[9] = VLC_OP_LINE; put_float(&c[10], 0); put_float(&c[11], 600);
+        c[12] = VLC_OP_END;
+        text_kern[i][0].unicode = 'A'; text_kern[i][0].kern = (uint16_t)-120;
+        text_kern[i][1].unicode = 'V'; text_kern[i][1].kern = (uint16_t)-80;
+        text_kern[i][2].unicode = 'o'; text_kern[i][2].kern = 37;
+        for (f = 0; f < 2; f++) {
+            glyph_desc_t *g = &text_glyphs[f][i];
+
+            g->unicode = 32 + i;
+            g->horiz_adv_x = 500 + f * 100 + (i % 7) * 13;
+            g->kern_num_entries = 3;
+            g->kern_table = text_kern[i];
+            g->path.bounds[2] = w;
+            g->path.bounds[3] = 600;
+            g->path.num_draw_cmds = 13;
+            g->path.draw_cmds = (float *)c;
+        }
+    }
+    for (f = 0; f < 2; f++) {
+        text_faces[f].units_per_em = 1000;
+        text_faces[f].num_glyphs = TEXT_GLYPHS;
+        text_faces[f].glyphs = text_glyphs[f];
+    }
+}
+
+static uint8_t raster_width(const struct mf_font_s *font, mf_char character)
+{
+    (void)font;
+    return (character >= 32 && character < 127) ? 6 + (character % 4) : 0;
+}
+
+static uint8_t raster_render(const struct mf_font_s *font, int16_t x0, int16_t y0,
+                             mf_char character, mf_pixel_callback_t callback, void *state)
+{
+    int row;
+
+    if (!raster_width(font, character))
+        return 0;
+    if (character != ' ') {
+        for (row = 2 + (character % 3); row < 12; row++)
+            callback(x0 + 1 + (row & 1), y0 + row, 3 + (character + row) % 4,
+                     (uint8_t)((character * 37 + row * 20) | 1), state);
+    }
+    return raster_width(font, character);
+}
+
+/* Copies of one font, each fills its own atlas slots. */
+static struct mf_font_s raster_fonts[3] = {
+    { "raster", "raster", 10, 14, 6, 9, 0, 11, 14, 0, '?', raster_width, raster_render },
+    { "raster", "raster", 10, 14, 6, 9, 0, 11, 14, 0, '?', raster_width, raster_render },
+    { "raster", "raster", 10, 14, 6, 9, 0, 11, 14, 0, '?', raster_width, raster_render },
+};
+
+/* Font registry of rle_font_read.c, which needs real font files. */
+font_face_desc_t *_vg_lite_get_vector_font(vg_lite_font_t font)
+{
+    return font < 2 ? &text_faces[font] : NULL;
+}
+
+struct mf_font_s *_vg_lite_get_raster_font(vg_lite_font_t font)
+{
+    return (font >= 2 && font < 5) ? &raster_fonts[font - 2] : NULL;
+}
+
+int vg_lite_is_font_valid(vg_lite_font_t font)
+{
+    return font < 5 ? VG_LITE_SUCCESS : VG_LITE_INVALID_ARGUMENT;
+}
+
+int vg_lite_is_vector_font(vg_lite_font_t font)
+{
+    return font < 2;
+}
+
+vg_lite_error_t vg_lite_load_font_data(vg_lite_font_t font, int font_height)
+{
+    (void)font;
+    (void)font_height;
+    return VG_LITE_SUCCESS;
+}
+
+static char *text_labels[] = { "Temperature 23.5 C", "Speed 120 km/h", "AVAWAY To", "Menu Settings" };
+
+static void text_matrix(vg_lite_matrix_t *matrix)
+{
+    vg_lite_identity(matrix);
+    vg_lite_translate(3.25f, 1.5f, matrix);
+}
+
+/* Vector text in all alignments, drawn directly. */
+static vg_lite_error_t scene_text_vector(vg_lite_buffer_t *target)
+{
+    vg_lite_font_attributes_t attributes;
+    vg_lite_matrix_t matrix;
+    vg_lite_error_t error;
+    int i;
+
+    text_matrix(&matrix);
+    error = vg_lite_clear(target, NULL, 0xFF000000);
+    for (i = 0; i < 6; i++) {
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.font_height = 13 + i % 4;
+        attributes.alignment = i % 3;
+        attributes.text_color = 0xFF00FFFF;
+        if (vg_lite_vtf_draw_text(target, 120, 14 + i * 14, VG_LITE_BLEND_SRC_OVER, i & 1, &matrix,
+                                  &attributes, text_labels[i % 4]) != VG_LITE_SUCCESS)
+            error |= VG_LITE_GENERIC_IO;
+    }
+    return error;
+}
+
+/* The same text through layouts, drawn twice from them. */
+static vg_lite_error_t scene_text_layout(vg_lite_buffer_t *target)
+{
+    vg_lite_font_attributes_t attributes;
+    vg_lite_text_layout_t layouts[6];
+    vg_lite_matrix_t matrix;
+    vg_lite_error_t error;
+    int i, pass;
+
+    text_matrix(&matrix);
+    memset(layouts, 0, sizeof(layouts));
+    error = VG_LITE_SUCCESS;
+    for (pass = 0; pass < 2; pass++) {
+        error |= vg_lite_clear(target, NULL, 0xFF000000);
+        for (i = 0; i < 6; i++) {
+            memset(&attributes, 0, sizeof(attributes));
+            attributes.font_height = 13 + i % 4;
+            attributes.alignment = i % 3;
+            error |= vg_lite_text_layout(&layouts[i], text_labels[i % 4], i & 1, &attributes);
+            error |= vg_lite_draw_text_layout(target, &layouts[i], 120, 14 + i * 14, &matrix,
+                                              VG_LITE_BLEND_SRC_OVER, 0xFF00FFFF);
+        }
+    }
+    for (i = 0; i < 6; i++)
+        vg_lite_text_layout_free(&layouts[i]);
+    return error;
+}
+
+/* Raster text, drawn over several frames to reuse the glyph atlas. */
+static vg_lite_error_t scene_text_raster(vg_lite_buffer_t *target)
+{
+    vg_lite_font_attributes_t attributes;
+    vg_lite_matrix_t matrix;
+    vg_lite_error_t error = VG_LITE_SUCCESS;
+    int i, frame;
+
+    vg_lite_identity(&matrix);
+    for (frame = 0; frame < 3; frame++) {
+        error |= vg_lite_clear(target, NULL, 0xFF203040);
+        for (i = 0; i < 4; i++) {
+            memset(&attributes, 0, sizeof(attributes));
+            attributes.font_height = 14;
+            attributes.width = target->width;
+            attributes.text_color = 0xFF30E0FF;
+            attributes.bg_color = 0xFF203040;
+            error |= vg_lite_draw_text(target, text_labels[i], 2, 4, 18 + i * 16, &matrix,
+                                       VG_LITE_BLEND_SRC_OVER, &attributes);
+        }
+        error |= vg_lite_finish();
+    }
+    error |= vg_lite_text_free_atlas();
+    return error;
+}
+
+/* Raster text recorded into a command list, replayed after the atlas would have been emptied. */
+static vg_lite_error_t scene_text_raster_list(vg_lite_buffer_t *target)
+{
+    vg_lite_command_list_t list;
+    vg_lite_font_attributes_t attributes;
+    vg_lite_matrix_t matrix;
+    vg_lite_error_t error;
+    int i;
+
+    error = vg_lite_begin_command_list(&list, 16 << 10);
+    if (error != VG_LITE_SUCCESS)
+        return error;
+
+    vg_lite_identity(&matrix);
+    for (i = 0; i < 4; i++) {
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.font_height = 14;
+        attributes.width = target->width;
+        attributes.text_color = 0xFF30E0FF;
+        attributes.bg_color = 0xFF203040;
+        error |= vg_lite_draw_text(target, text_labels[i], 2, 4, 18 + i * 16, &matrix,
+                                   VG_LITE_BLEND_SRC_OVER, &attributes);
+    }
+    /* The glyphs the list blits can not be freed while recording. */
+    if (vg_lite_text_free_atlas() == VG_LITE_SUCCESS)
+        error |= VG_LITE_GENERIC_IO;
+    error |= vg_lite_end_command_list(&list);
+
+    error |= vg_lite_clear(target, NULL, 0xFF203040);
+    error |= vg_lite_call_command_list(&list);
+    error |= vg_lite_finish();
+    error |= vg_lite_free_command_list(&list);
+    error |= vg_lite_text_free_atlas();
+    return error;
+}
+
+/* Raster text that no longer fits the atlas while a command list keeps it, drawn through a text buffer. */
+static vg_lite_error_t scene_text_raster_pinned(vg_lite_buffer_t *target)
+{
+    static char glyphs[95];
+    vg_lite_command_list_t list;
+    vg_lite_font_attributes_t attributes;
+    vg_lite_matrix_t matrix;
+    vg_lite_error_t error;
+    int i;
+
+    for (i = 0; i < 94; i++)
+        glyphs[i] = (char)('!' + i);
+
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.font_height = 14;
+    attributes.width = target->width;
+    attributes.text_color = 0xFF30E0FF;
+    attributes.bg_color = 0xFF203040;
+    vg_lite_identity(&matrix);
+
+    error = vg_lite_begin_command_list(&list, 16 << 10);
+    if (error != VG_LITE_SUCCESS)
+        return error;
+    error |= vg_lite_draw_text(target, text_labels[0], 2, 4, 18, &matrix, VG_LITE_BLEND_SRC_OVER, &attributes);
+    error |= vg_lite_end_command_list(&list);
+
+    /* Every printable glyph of two more fonts is more than the atlas holds. */
+    error |= vg_lite_clear(target, NULL, 0xFF203040);
+    for (i = 0; i < 2; i++)
+        error |= vg_lite_draw_text(target, glyphs, 3 + i, 4, 34 + i * 16, &matrix, VG_LITE_BLEND_SRC_OVER, &attributes);
+    error |= vg_lite_draw_text(target, text_labels[1], 2, 4, 66, &matrix, VG_LITE_BLEND_SRC_OVER, &attributes);
+    error |= vg_lite_call_command_list(&list);
+    error |= vg_lite_finish();
+
+    /* The list keeps the atlas until it is freed. */
+    if (vg_lite_text_free_atlas() == VG_LITE_SUCCESS)
+        error |= VG_LITE_GENERIC_IO;
+    error |= vg_lite_free_command_list(&list);
+    error |= vg_lite_text_free_atlas();
+    return error;
+}
+
+static const scene_t scenes[] = {
+    { "basic",          "basic",        64,  64,  scene_basic },
+    { "uploaded",       "basic",        64,  64,  scene_uploaded },
+    { "optimized",      "basic",        64,  64,  scene_optimized },
+    { "command_list",   "basic",        64,  64,  scene_command_list },
+    { "arena",          "basic",        64,  64,  scene_arena },
+    { "ring",           "ring",         64,  32,  scene_ring },
+    { "stroke",         "stroke",       64,  64,  scene_stroke },
+    { "stroke_list",    "stroke",       64,  64,  scene_stroke_list },
+    { "icons",          "icons",        256, 256, scene_icons },
+    { "icons_batched",  "icons",        256, 256, scene_icons_batched },
+    { "text_vector",    "text_vector",  256, 96,  scene_text_vector },
+    { "text_layout",    "text_vector",  256, 96,  scene_text_layout },
+    { "text_raster",    "text_raster",  256, 80,  scene_text_raster },
+    { "text_raster_list", "text_raster", 256, 80, scene_text_raster_list },
+    { "text_raster_pinned", "text_raster_pinned", 256, 80, scene_text_raster_pinned },
+};
+
+/* Golden images are PAM files with the target pixels as RGB_ALPHA. */
+static int write_image(const char *file, vg_lite_buffer_t *buffer)
+{
+    FILE *f = fopen(file, "wb");
+    int32_t x, y;
+
+    if (f == NULL)
+        return -1;
+    fprintf(f, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n",
+            (int)buffer->width, (int)buffer->height);
+    for (y = 0; y < buffer->height; y++) {
+        for (x = 0; x < buffer->width; x++) {
+            uint8_t *p = (uint8_t *)buffer->memory + y * buffer->stride + x * 4;
+
+            fputc(p[2], f);
+            fputc(p[1], f);
+            fputc(p[0], f);
+            fputc(p[3], f);
+        }
+    }
+    return fclose(f);
+}
+
+static int compare_image(const char *file, vg_lite_buffer_t *buffer, int32_t *mismatches)
+{
+    char header[128];
+    FILE *f = fopen(file, "rb");
+    int32_t x, y, width, height;
+
+    *mismatches = 0;
+    if (f == NULL)
+        return -1;
+    if (fscanf(f, "P7\nWIDTH %d\nHEIGHT %d\n", &width, &height) != 2 ||
+        width != buffer->width || height != buffer->height) {
+        fclose(f);
+        return -1;
+    }
+    /* Skip the rest of the header. */
+    while (fgets(header, sizeof(header), f) != NULL && strcmp(header, "ENDHDR\n") != 0)
+        ;
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            uint8_t *p = (uint8_t *)buffer->memory + y * buffer->stride + x * 4;
+            uint8_t golden[4];
+
+            if (fread(golden, 1, 4, f) != 4) {
+                fclose(f);
+                return -1;
+            }
+            if (golden[0] != p[2] || golden[1] != p[1] || golden[2] != p[0] || golden[3] != p[3])
+                (*mismatches)++;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static int run_scene(const scene_t *scene)
+{
+    vg_lite_buffer_t target;
+    vg_lite_error_t error;
+    char file[128];
+    int32_t mismatches;
+    int failed = 0;
+
+    memset(&target, 0, sizeof(target));
+    target.width = scene->width;
+    target.height = scene->height;
+    target.format = VG_LITE_BGRA8888;
+    if (vg_lite_allocate(&target) != VG_LITE_SUCCESS) {
+        printf("FAIL %-16s allocate\n", scene->name);
+        return 1;
+    }
+    memset(target.memory, 0, target.stride * target.height);
+
+    error = scene->draw(&target);
+    error |= vg_lite_finish();
+    if (error != VG_LITE_SUCCESS) {
+        printf("FAIL %-16s error %d\n", scene->name, error);
+        failed = 1;
+    }
+
+    if (update_golden && strcmp(scene->name, scene->golden) == 0) {
+        snprintf(file, sizeof(file), GOLDEN_DIR "%s.pam", scene->golden);
+        if (write_image(file, &target) != 0) {
+            printf("FAIL %-16s can not write %s\n", scene->name, file);
+            failed = 1;
+        }
+    }
+    else {
+        snprintf(file, sizeof(file), GOLDEN_DIR "%s.pam", scene->golden);
+        if (compare_image(file, &target, &mismatches) != 0) {
+            printf("FAIL %-16s can not read %s\n", scene->name, file);
+            failed = 1;
+        }
+        else if (mismatches) {
+            snprintf(file, sizeof(file), "%s.out.pam", scene->name);
+            write_image(file, &target);
+            printf("FAIL %-16s %d pixels differ from %s, output in %s\n",
+                   scene->name, (int)mismatches, scene->golden, file);
+            failed = 1;
+        }
+    }
+    if (!failed)
+        printf("ok   %s\n", scene->name);
+
+    vg_lite_free(&target);
+    return failed;
+}
+
+/* Batched point transform against the matrix applied to each point. */
+static int check_transform(void)
+{
+    static const float points[8] = { 0, 0, 10, -4, -7.5f, 3, 100, 50 };
+    float result[8], x, y, w;
+    vg_lite_matrix_t matrix;
+    int failed = 0, pass, i;
+
+    vg_lite_identity(&matrix);
+    vg_lite_translate(12, -3, &matrix);
+    vg_lite_rotate(30, &matrix);
+    vg_lite_scale(2, 0.5f, &matrix);
+    for (pass = 0; pass < 2; pass++) {
+        /* The second pass is a perspective matrix that puts the last point behind the projection plane. */
+        if (pass == 1) {
+            matrix.m[2][0] = -0.004f;
+            matrix.m[2][1] = -0.015f;
+        }
+        vg_lite_transform_points(&matrix, points, result, 4);
+        for (i = 0; i < 4; i++) {
+            x = points[2 * i] * matrix.m[0][0] + points[2 * i + 1] * matrix.m[0][1] + matrix.m[0][2];
+            y = points[2 * i] * matrix.m[1][0] + points[2 * i + 1] * matrix.m[1][1] + matrix.m[1][2];
+            w = points[2 * i] * matrix.m[2][0] + points[2 * i + 1] * matrix.m[2][1] + matrix.m[2][2];
+            if (w <= 0)
+                x = y = w = 0;
+            else
+                x /= w, y /= w;
+            failed |= fabsf(result[2 * i] - x) > 1e-3f || fabsf(result[2 * i + 1] - y) > 1e-3f;
+        }
+        failed |= pass == 1 && (result[6] != 0 || result[7] != 0);
+    }
+
+    /* In place. */
+    memcpy(result, points, sizeof(points));
+    vg_lite_identity(&matrix);
+    vg_lite_translate(1, 2, &matrix);
+    vg_lite_transform_points(&matrix, result, result, 4);
+    for (i = 0; i < 4; i++)
+        failed |= result[2 * i] != points[2 * i] + 1 || result[2 * i + 1] != points[2 * i + 1] + 2;
+
+    printf("%s transform\n", failed ? "FAIL" : "ok  ");
+    return failed;
+}
+
+/* Fences signal in submission order. */
+static int check_fences(void)
+{
+    vg_lite_buffer_t target;
+    vg_lite_rectangle_t rect = { 0, 0, 8, 8 };
+    vg_lite_fence_t first, second;
+    int failed = 0;
+
+    memset(&target, 0, sizeof(target));
+    target.width = 8;
+    target.height = 8;
+    target.format = VG_LITE_BGRA8888;
+    if (vg_lite_allocate(&target) != VG_LITE_SUCCESS)
+        return 1;
+
+    vg_lite_clear(&target, &rect, 0xFF112233);
+    failed |= vg_lite_fence_insert(&first) != VG_LITE_SUCCESS;
+    failed |= vg_lite_fence_is_signaled(&first) != 0;
+    vg_lite_flush();
+    vg_lite_clear(&target, &rect, 0xFF445566);
+    failed |= vg_lite_fence_insert(&second) != VG_LITE_SUCCESS;
+    failed |= second.serial <= first.serial;
+    failed |= vg_lite_fence_wait(&first, VG_LITE_FENCE_INFINITE) != VG_LITE_SUCCESS;
+    failed |= ((uint32_t *)target.memory)[0] != 0xFF332211;
+    failed |= vg_lite_fence_wait(&second, 100) != VG_LITE_SUCCESS;
+    failed |= !vg_lite_fence_is_signaled(&second);
+    failed |= ((uint32_t *)target.memory)[0] != 0xFF665544;
+
+    vg_lite_free(&target);
+    printf("%s fences\n", failed ? "FAIL" : "ok  ");
+    return failed;
+}
+
+/* A fill path drawn again hits the path cache, and a changed one is uploaded again. */
+static int check_path_cache(void)
+{
+    static int8_t data[sizeof(star_data)];
+    static uint8_t big_data[2][20 << 10];
+    vg_lite_path_t big[2];
+    vg_lite_path_cache_stats_t before, after;
+    vg_lite_buffer_t target;
+    vg_lite_path_t path;
+    vg_lite_matrix_t matrix;
+    int i, failed = 0;
+
+    memset(&target, 0, sizeof(target));
+    target.width = 64;
+    target.height = 64;
+    target.format = VG_LITE_BGRA8888;
+    if (vg_lite_allocate(&target) != VG_LITE_SUCCESS)
+        return 1;
+
+    memcpy(data, star_data, sizeof(data));
+    memset(&path, 0, sizeof(path));
+    vg_lite_init_path(&path, VG_LITE_S8, VG_LITE_HIGH, sizeof(data), data, -10, -10, 10, 10);
+    star_matrix(&matrix);
+    vg_lite_get_path_cache_stats(&before);
+    for (i = 0; i < 6; i++) {
+        if (i == 4) {
+            data[2] = -9;
+            path.path_changed = 1;
+        }
+        failed |= vg_lite_draw(&target, &path, VG_LITE_FILL_EVEN_ODD, &matrix, VG_LITE_BLEND_NONE, 0xFFFF0000) != VG_LITE_SUCCESS;
+        failed |= vg_lite_finish() != VG_LITE_SUCCESS;
+    }
+    vg_lite_get_path_cache_stats(&after);
+    failed |= after.uploads - before.uploads != 2;
+    failed |= after.hits - before.hits != 2;
+    failed |= vg_lite_clear_path(&path) != VG_LITE_SUCCESS;
+    vg_lite_get_path_cache_stats(&after);
+    failed |= after.bytes != before.bytes;
+
+    /* Two paths that do not fit into the cache together evict each other, and keep their draw counts. */
+    for (i = 0; i < 2; i++) {
+        memset(&big[i], 0, sizeof(big[i]));
+        memset(big_data[i], VLC_OP_LINE, sizeof(big_data[i]));
+        big_data[i][0] = VLC_OP_MOVE;
+        big_data[i][sizeof(big_data[i]) - 1] = VLC_OP_END;
+        vg_lite_init_path(&big[i], VG_LITE_S8, VG_LITE_HIGH, sizeof(big_data[i]), big_data[i], -10, -10, 10, 10);
+    }
+    vg_lite_get_path_cache_stats(&before);
+    for (i = 0; i < 5; i++) {
+        failed |= vg_lite_draw(&target, &big[i < 2 ? 0 : i < 4 ? 1 : 0], VG_LITE_FILL_EVEN_ODD, &matrix,
+                               VG_LITE_BLEND_NONE, 0xFFFF0000) != VG_LITE_SUCCESS;
+        failed |= vg_lite_finish() != VG_LITE_SUCCESS;
+    }
+    vg_lite_get_path_cache_stats(&after);
+    failed |= after.uploads - before.uploads != 3;
+    /* Paths left over from the scenes may go first. */
+    failed |= after.evictions - before.evictions < 2;
+    for (i = 0; i < 2; i++)
+        failed |= vg_lite_clear_path(&big[i]) != VG_LITE_SUCCESS;
+
+    vg_lite_free(&target);
+    printf("%s path cache\n", failed ? "FAIL" : "ok  ");
+    return failed;
+}
+
+/* Random allocations leave an aligned, fully coalesced heap behind. */
+static int check_heap(void)
+{
+    static vg_lite_buffer_t buffers[64];
+    vg_lite_mem_stats_t before, after;
+    uint32_t seed = 1;
+    int i, k, failed = 0;
+
+    vg_lite_mem_stats(&before);
+    for (k = 0; k < 20000; k++) {
+        seed = seed * 1103515245 + 12345;
+        i = (seed >> 16) % 64;
+        if (buffers[i].handle != NULL) {
+            memset(buffers[i].memory, 0xA5, buffers[i].stride * buffers[i].height);
+            vg_lite_free(&buffers[i]);
+            memset(&buffers[i], 0, sizeof(buffers[i]));
+        }
+        else {
+            buffers[i].width = 1 + (seed >> 8) % 200;
+            buffers[i].height = 1 + (seed >> 3) % 40;
+            buffers[i].format = VG_LITE_A8;
+            if (vg_lite_allocate(&buffers[i]) != VG_LITE_SUCCESS)
+                memset(&buffers[i], 0, sizeof(buffers[i]));
+            else if (((uintptr_t)buffers[i].memory & 63) != 0)
+                failed = 1;
+        }
+    }
+    for (i = 0; i < 64; i++) {
+        if (buffers[i].handle != NULL)
+            vg_lite_free(&buffers[i]);
+    }
+    vg_lite_mem_stats(&after);
+    failed |= after.bytes_free != before.bytes_free;
+    failed |= after.free_blocks != before.free_blocks;
+    failed |= after.used_blocks != before.used_blocks;
+
+    printf("%s heap\n", failed ? "FAIL" : "ok  ");
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t heap[HEAP_SIZE] __attribute__((aligned(64)));
+    vg_lite_sim_stats_t stats;
+    uint32_t i;
+    int failed = 0;
+
+    update_golden = argc > 1 && strcmp(argv[1], "-u") == 0;
+
+    vg_lite_init_mem(0, 0, heap, sizeof(heap));
+    if (vg_lite_init(128, 128) != VG_LITE_SUCCESS ||
+        vg_lite_set_command_buffer_size(64 << 10) != VG_LITE_SUCCESS) {
+        printf("FAIL init\n");
+        return 1;
+    }
+
+    star.format = VG_LITE_S8;
+    star.quality = VG_LITE_HIGH;
+    star.bounding_box[0] = star.bounding_box[1] = -10;
+    star.bounding_box[2] = star.bounding_box[3] = 10;
+    star.path_length = sizeof(star_data);
+    star.path = star_data;
+    star.path_changed = 1;
+
+    memset(&checker, 0, sizeof(checker));
+    checker.width = 16;
+    checker.height = 16;
+    checker.format = VG_LITE_BGRA8888;
+    if (vg_lite_allocate(&checker) != VG_LITE_SUCCESS) {
+        printf("FAIL allocate\n");
+        return 1;
+    }
+    for (i = 0; i < 256; i++)
+        ((uint32_t *)checker.memory)[i] = ((i & 16) ^ ((i & 1) << 4)) ? 0xFF00FF00 : 0xFFFFFFFF;
+
+    text_init_vector_fonts();
+
+    for (i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++)
+        failed |= run_scene(&scenes[i]);
+    failed |= check_transform();
+    failed |= check_fences();
+    failed |= check_path_cache();
+
+    vg_lite_free(&checker);
+    vft_unload(NULL);
+    failed |= check_heap();
+
+    vg_lite_sim_get_stats(&stats, 0);
+    if (stats.errors) {
+        printf("FAIL simulator reported %u command errors\n", stats.errors);
+        failed = 1;
+    }
+
+    vg_lite_close();
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+    return failed;
+}